@@ -12,17 +12,56 @@
 
 #include "buffer/buffer_pool_manager.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <future>  // NOLINT
 #include <list>
-#include <unordered_map>
+#include <vector>
 #include "common/logger.h"
+#include "common/macros.h"
 
 namespace bustub {
 
-BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
-  // We allocate a consecutive memory space for the buffer pool.
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size);
+BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager,
+                                     ReplacerType replacer_type, size_t max_pool_size)
+    : BufferPoolManager(pool_size, 1, 0, disk_manager, log_manager, replacer_type, max_pool_size) {}
+
+BufferPoolManager::BufferPoolManager(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                                     DiskManager *disk_manager, LogManager *log_manager, ReplacerType replacer_type,
+                                     size_t max_pool_size)
+    : pool_size_(pool_size),
+      max_pool_size_(std::max(pool_size, max_pool_size)),
+      disk_manager_(disk_manager),
+      log_manager_(log_manager),
+      num_instances_(num_instances),
+      instance_index_(instance_index),
+      read_only_(disk_manager != nullptr && disk_manager->IsReadOnly()),
+      page_table_(max_pool_size_) {
+  BUSTUB_ASSERT(num_instances > 0, "If BPM is not part of a pool, then the pool size should just be 1");
+  BUSTUB_ASSERT(instance_index < num_instances,
+                "BPM index cannot be greater than the number of BPMs in the pool. In non-parallel case, index should "
+                "just be 0.");
+  // We allocate a consecutive, page aligned memory space for the frames, and a separate array for their book-keeping.
+  // Both cover every frame the pool may grow to; frames that are not in use yet take no memory in the arena.
+  frame_arena_ = new FrameArena(max_pool_size_, enable_hugepage_frames);
+  pages_ = new Page[max_pool_size_];
+  for (size_t i = 0; i < max_pool_size_; ++i) {
+    pages_[i].data_ = frame_arena_->GetFrame(static_cast<frame_id_t>(i));
+  }
+  switch (replacer_type) {
+    case ReplacerType::LRU:
+      replacer_ = new LRUReplacer(max_pool_size_);
+      break;
+    case ReplacerType::LRU_K:
+      replacer_ = new LRUKReplacer(max_pool_size_);
+      break;
+    case ReplacerType::CLOCK:
+      replacer_ = new ClockReplacer(max_pool_size_);
+      break;
+    case ReplacerType::LOCK_FREE_CLOCK:
+      replacer_ = new LockFreeClockReplacer(max_pool_size_);
+      break;
+  }
 
   // Initially, every page is in the free list.
   for (size_t i = 0; i < pool_size_; ++i) {
@@ -30,89 +69,176 @@ BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager
   }
 }
 
+BufferPoolManager::BufferPoolManager(DiskManager *disk_manager, LogManager *log_manager)
+    : pool_size_(0),
+      max_pool_size_(0),
+      pages_(nullptr),
+      disk_manager_(disk_manager),
+      log_manager_(log_manager),
+      page_table_(0),
+      replacer_(nullptr) {}
+
 BufferPoolManager::~BufferPoolManager() {
+  StopPrefetchThread();
+  StopPageCleaner();
   delete[] pages_;
+  delete frame_arena_;
   delete replacer_;
 }
 
 Page *BufferPoolManager::FetchPageImpl(page_id_t page_id) {
   // 1.     Search the page table for the requested page (P).
-  // 1.1    If P exists, pin it and return it immediately.
-  std::lock_guard<std::mutex> lock(latch_);
-  // LOG_INFO("FetchPageImpl(pid:%d)", page_id);
-  if (page_table_.count(page_id) != 0U) {
-    auto frame_id = page_table_[page_id];
-    // assertion failed??
-    if (page_id != (pages_ + frame_id)->page_id_) {
-      LOG_DEBUG("FetchPageImpl,pid unequal,frame_id:%d,aim pid:%d,pid in ptable:%d", frame_id, page_id,
-                (pages_ + frame_id)->page_id_);
+  // 1.1    If P exists, pin it and return it immediately. Most hits do not need the latch for that.
+  if (enable_optimistic_pinning) {
+    Page *page = TryFetchPageOptimistic(page_id);
+    if (page != nullptr) {
+      return page;
     }
+  }
+  std::unique_lock<std::mutex> lock(latch_);
+  // LOG_INFO("FetchPageImpl(pid:%d)", page_id);
+  // If P is still being written back by the thread that evicted it, the copy on disk is not complete yet.
+  if (evicting_pages_.count(page_id) != 0U) {
+    stats_.Increment(BufferPoolStatsCollector::Counter::PIN_WAITS);
+    io_cv_.wait(lock, [&] { return evicting_pages_.count(page_id) == 0U; });
+  }
+  frame_id_t frame_id;
+  if (page_table_.Find(page_id, &frame_id)) {
     replacer_->Pin(frame_id);
     (pages_ + frame_id)->pin_count_++;
+    stats_.Increment(BufferPoolStatsCollector::Counter::HITS);
+    // Another thread may still be reading P in. Our pin keeps the frame from being reused while we wait for it.
+    if (pages_[frame_id].is_io_in_progress_) {
+      stats_.Increment(BufferPoolStatsCollector::Counter::PIN_WAITS);
+      io_cv_.wait(lock, [&] { return !pages_[frame_id].is_io_in_progress_; });
+      if (pages_[frame_id].GetPageId() != page_id) {
+        DropPinOfFailedRead(frame_id);
+        return nullptr;
+      }
+    }
     return pages_ + frame_id;
   }
   // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
   //        Note that pages are always found from the free list first.
+  auto miss_start = BufferPoolStatsCollector::StartTimer();
   frame_id_t stale_frame = -1;
-  if (!free_list_.empty()) {
-    stale_frame = free_list_.front();
-    free_list_.pop_front();
-  } else {
-    replacer_->Victim(&stale_frame);
-  }
-  if (stale_frame == -1) {
+  if (!FindReplacementFrame(&stale_frame)) {
     return nullptr;
   }  // no free frames to be replaced? how to handle? what to return?
-  // 2.     If R is dirty, write it back to the disk.
+  stats_.Increment(BufferPoolStatsCollector::Counter::MISSES);
+  // 2.     Delete R from the page table and insert P, so that concurrent fetchers of P wait for our read.
   Page &page = pages_[stale_frame];
-  if (page.IsDirty()) {
-    disk_manager_->WritePage(page.GetPageId(), page.GetData());
-    page.is_dirty_ = false;
-  }
-  // 3.     Delete R from the page table and insert P.
-  page_table_.erase(page.GetPageId());
-  page_table_[page_id] = stale_frame;
-  // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-  page.ResetMemory();
+  page_id_t stale_page_id = page.GetPageId();
+  bool write_back = page.IsDirty();
+  page_table_.Erase(stale_page_id);
+  page_table_.Insert(page_id, stale_frame);
+  if (write_back) {
+    evicting_pages_.insert(stale_page_id);
+  }
+  // 3.     Update P's metadata and mark the frame busy. The disk I/O happens after we drop the latch.
+  //        Pinning in the replacer records the access for policies that keep a history.
+  replacer_->Pin(stale_frame);
   page.page_id_ = page_id;
-  (pages_ + stale_frame)->pin_count_++;  // this page is newly loaded to memory, pin_count must be 1
-  disk_manager_->ReadPage(page_id, page.GetData());
-  return pages_ + stale_frame;
+  SetDirtyFlag(&page, false);
+  if (read_only_) {
+    // There is nothing to read or write back: the frame just points at the page in the mapped db file.
+    page.data_ = const_cast<char *>(disk_manager_->GetMappedPage(page_id));
+    ReleaseFrame(&page, 1);
+    stats_.RecordMissLatency(miss_start);
+    return pages_ + stale_frame;
+  }
+  page.is_io_in_progress_ = true;
+  ReleaseFrame(&page, 1);  // this page is newly loaded to memory, pin_count must be 1
+  lock.unlock();
+
+  // 4.     If R is dirty, write it back to the disk, then read in the page content from disk.
+  if (write_back) {
+    auto write_back_start = BufferPoolStatsCollector::StartTimer();
+    FlushLogUntil(page.GetLSN());
+    disk_manager_->WritePage(stale_page_id, page.GetData());
+    stats_.RecordWriteBackLatency(write_back_start);
+    foreground_writes_++;
+  }
+  page.ResetMemory();
+  bool read = disk_manager_->ReadPage(page_id, page.GetData());
+  stats_.RecordMissLatency(miss_start);
+
+  lock.lock();
+  if (write_back) {
+    evicting_pages_.erase(stale_page_id);
+  }
+  if (!read) {
+    DiscardFailedRead(&page);
+  }
+  page.is_io_in_progress_ = false;
+  if (!read) {
+    DropPinOfFailedRead(stale_frame);
+  }
+  lock.unlock();
+  io_cv_.notify_all();
+  return read ? pages_ + stale_frame : nullptr;
 }
 
 bool BufferPoolManager::UnpinPageImpl(page_id_t page_id, bool is_dirty) {
+  if (enable_optimistic_pinning && TryUnpinPageOptimistic(page_id, is_dirty)) {
+    return true;
+  }
   std::lock_guard<std::mutex> lock(latch_);
+  return UnpinPageLatched(page_id, is_dirty);
+}
+
+bool BufferPoolManager::UnpinPageLatched(page_id_t page_id, bool is_dirty) {
   // LOG_INFO("UnpinPageImpl(pid:%d)", page_id);
-  if (page_table_.count(page_id) == 0U) {
+  frame_id_t frame_id;
+  if (!page_table_.Find(page_id, &frame_id)) {
     // LOG_DEBUG("UnpinPageImpl,pid %d not found in ptable", page_id);
     return false;
   }
-  auto frame_id = page_table_[page_id];
   Page &page = pages_[frame_id];
   if (page.GetPinCount() <= 0) {
     LOG_DEBUG("unpin a not pined page,pid:%d", page_id);
     return false;
   }
+  // Mark the page dirty while we still hold our pin, a latch-free unpin may make the frame evictable right after.
+  if (is_dirty) {
+    SetDirtyFlag(&page, true);
+  }
   if (--page.pin_count_ == 0) {
     // put it to lru re placer??
     replacer_->Unpin(frame_id);
   }
-  if (is_dirty) {
-    page.is_dirty_ = true;
-  }
   return true;
 }
 
 bool BufferPoolManager::FlushPageImpl(page_id_t page_id) {
   // Make sure you call DiskManager::WritePage!
-  std::lock_guard<std::mutex> lock(latch_);
-  if (page_table_.count(page_id) == 0U) {
+  std::unique_lock<std::mutex> lock(latch_);
+  frame_id_t frame_id;
+  if (!page_table_.Find(page_id, &frame_id)) {
     return false;
   }
-  auto frame_id = page_table_[page_id];
+  if (read_only_) {
+    return true;  // the page is never dirty
+  }
   Page &page = pages_[frame_id];
+  // The frame may only hold part of the page while it is being read in.
+  io_cv_.wait(lock, [&] { return !page.is_io_in_progress_; });
+  if (page.GetPageId() != page_id) {
+    return false;  // evicted while we were waiting
+  }
+  // Pin the frame so that it is not evicted and mark it busy so that P is not fetched or flushed meanwhile, then flush
+  // the log and write P without the latch. The flag is cleared first, so a page dirtied during the write stays dirty.
+  page.pin_count_++;
+  page.is_io_in_progress_ = true;
+  SetDirtyFlag(&page, false);
+  lsn_t lsn = page.GetLSN();
+  lock.unlock();
+  FlushLogUntil(lsn);
   disk_manager_->WritePage(page_id, page.GetData());
-  page.is_dirty_ = false;
+  lock.lock();
+  EndFlush(frame_id, true);
+  lock.unlock();
+  io_cv_.notify_all();
   return true;
 }
 
@@ -120,34 +246,53 @@ Page *BufferPoolManager::NewPageImpl(page_id_t *page_id) {
   // 0.   Make sure you call DiskManager::AllocatePage!
   // 1.   If all the pages in the buffer pool are pinned, return nullptr.
   // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
-  std::lock_guard<std::mutex> lock(latch_);
-  frame_id_t frame_id = -1;
-  if (!free_list_.empty()) {
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-  } else {
-    replacer_->Victim(&frame_id);
+  if (read_only_) {
+    *page_id = INVALID_PAGE_ID;
+    return nullptr;
   }
-  if (frame_id == -1) {
+  std::unique_lock<std::mutex> lock(latch_);
+  frame_id_t frame_id = -1;
+  if (!FindReplacementFrame(&frame_id)) {
     return nullptr;
   }  // no free frames to be replaced
+  stats_.Increment(BufferPoolStatsCollector::Counter::NEW_PAGES);
   Page &P = pages_[frame_id];
-  if (P.IsDirty()) {
+  page_id_t stale_page_id = P.GetPageId();
+  bool write_back = P.IsDirty();
+  *page_id = AllocatePage();
+  // LOG_INFO("NewPageImpl(),pid:%d", *page_id);
+  // 3.   Update P's metadata and add P to the page table. The old content is written back without the latch.
+  page_table_.Erase(stale_page_id);
+  page_table_.Insert(*page_id, frame_id);
+  if (write_back) {
+    evicting_pages_.insert(stale_page_id);
+  }
+  // The new page is dirty: its id may have been deallocated before, and what is on disk is the deleted page.
+  replacer_->Pin(frame_id);
+  SetDirtyFlag(&P, true);
+  P.page_id_ = *page_id;
+  P.is_io_in_progress_ = true;
+  ReleaseFrame(&P, 1);
+  lock.unlock();
+
+  if (write_back) {
     // Flush this page to disk
-    disk_manager_->WritePage(P.GetPageId(), P.GetData());
-    P.is_dirty_ = false;
+    auto write_back_start = BufferPoolStatsCollector::StartTimer();
+    FlushLogUntil(P.GetLSN());
+    disk_manager_->WritePage(stale_page_id, P.GetData());
+    stats_.RecordWriteBackLatency(write_back_start);
+    foreground_writes_++;
   }
-  *page_id = disk_manager_->AllocatePage();
-  // LOG_INFO("NewPageImpl(),pid:%d", *page_id);
-  // 3.   Update P's metadata, zero out memory and add P to the page table.
-  page_table_.erase(P.GetPageId());
   P.ResetMemory();
-  // new page is dirty?? ,not write to disk yet???
-  P.is_dirty_ = false;
-  P.page_id_ = *page_id;
-  page_table_[*page_id] = frame_id;
+
+  lock.lock();
+  if (write_back) {
+    evicting_pages_.erase(stale_page_id);
+  }
+  P.is_io_in_progress_ = false;
+  lock.unlock();
+  io_cv_.notify_all();
   // 4.   Set the page ID output parameter. Return a pointer to P.
-  (pages_ + frame_id)->pin_count_++;
   return pages_ + frame_id;
 }
 
@@ -157,36 +302,646 @@ bool BufferPoolManager::DeletePageImpl(page_id_t page_id) {
   // 1.   If P does not exist, return true.
   // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
   // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
-  std::lock_guard<std::mutex> lock(latch_);
-  if (page_table_.count(page_id) == 0U) {
+  if (read_only_) {
+    return false;
+  }
+  std::unique_lock<std::mutex> lock(latch_);
+  // If P is still being written back by the thread that evicted it, deallocating it now would let the write land on
+  // a page that has been freed, or even handed out again.
+  if (evicting_pages_.count(page_id) != 0U) {
+    io_cv_.wait(lock, [&] { return evicting_pages_.count(page_id) == 0U; });
+  }
+  frame_id_t frame_id;
+  if (!page_table_.Find(page_id, &frame_id)) {
+    // Not resident, but the page still takes space on disk.
+    disk_manager_->DeallocatePage(page_id);
     return true;
   }  // page not found!
-  auto frame_id = page_table_[page_id];
   Page &P = pages_[frame_id];
-  if (P.GetPinCount() != 0) {
+  if (!TryClaimFrame(&P)) {
     LOG_DEBUG("delete a pin page,pid:%d,pin_cnt:%d", P.GetPageId(), P.GetPinCount());
     // TO DO 在这里应该把pid放到一个队列里，异步轮询删除
     return false;
   }
   // delete 掉的page，也要从lru replacer里面去除掉。。。
-  replacer_->Pin(frame_id);
+  replacer_->Remove(frame_id);
   disk_manager_->DeallocatePage(page_id);
   P.ResetMemory();
   P.page_id_ = INVALID_PAGE_ID;
-  P.is_dirty_ = false;
-  page_table_.erase(page_id);
-  free_list_.emplace_back(frame_id);
+  SetDirtyFlag(&P, false);
+  page_table_.Erase(page_id);
+  ReleaseFrame(&P, 0);
+  // A frame above the pool size is being retired by Resize, which puts it back on the free list if it keeps it.
+  if (static_cast<size_t>(frame_id) < pool_size_) {
+    free_list_.emplace_back(frame_id);
+  }
   return true;
 }
 
 void BufferPoolManager::FlushAllPagesImpl() {
   // You can do it!
+  if (read_only_) {
+    return;
+  }
+  std::vector<std::pair<page_id_t, const char *>> writes;
+  std::vector<std::pair<frame_id_t, bool>> flushed;
+  lsn_t max_lsn = BeginFlushAll(&writes, &flushed);
+  FlushLogUntil(max_lsn);
+  std::vector<bool> written(writes.size(), true);
+  if (enable_write_batching) {
+    if (!disk_manager_->WritePages(writes)) {
+      written.assign(writes.size(), false);
+    }
+  } else {
+    // Queue every write before waiting for any of them, so that they overlap on the device.
+    std::vector<std::future<bool>> futures;
+    futures.reserve(writes.size());
+    for (const auto &[page_id, data] : writes) {
+      futures.push_back(disk_manager_->WritePageAsync(page_id, data));
+    }
+    for (size_t i = 0; i < futures.size(); i++) {
+      written[i] = futures[i].get();
+    }
+  }
+  EndFlushAll(flushed, written);
+}
+
+lsn_t BufferPoolManager::BeginFlushAll(std::vector<std::pair<page_id_t, const char *>> *writes,
+                                       std::vector<std::pair<frame_id_t, bool>> *flushed) {
+  std::unique_lock<std::mutex> lock(latch_);
+  // Frames that are being read in must not be written out half-filled. Frames that Resize is retiring may still be.
+  io_cv_.wait(lock, [&] {
+    return std::none_of(pages_, pages_ + max_pool_size_,
+                        [](const Page &page) { return page.is_io_in_progress_.load(); });
+  });
+  // Pin and mark busy the frames to be written, as FlushPageImpl does, so that they can be written without the latch.
+  // With write batching only the dirty pages are written.
+  lsn_t max_lsn = INVALID_LSN;
+  page_table_.ForEach([&](page_id_t page_id, frame_id_t frame_id) {
+    Page *page = pages_ + frame_id;
+    if (enable_write_batching && !page->IsDirty()) {
+      return;
+    }
+    page->pin_count_++;
+    page->is_io_in_progress_ = true;
+    flushed->emplace_back(frame_id, page->IsDirty());
+    SetDirtyFlag(page, false);
+    writes->emplace_back(page_id, page->GetData());
+    max_lsn = std::max(max_lsn, page->GetLSN());
+  });
+  return max_lsn;
+}
+
+void BufferPoolManager::EndFlushAll(const std::vector<std::pair<frame_id_t, bool>> &flushed,
+                                    const std::vector<bool> &written) {
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    for (size_t i = 0; i < flushed.size(); i++) {
+      auto [frame_id, was_dirty] = flushed[i];
+      EndFlush(frame_id, written[i] || !was_dirty);
+    }
+  }
+  io_cv_.notify_all();
+}
+
+void BufferPoolManager::EndFlush(frame_id_t frame_id, bool written) {
+  Page *page = pages_ + frame_id;
+  if (!written) {
+    SetDirtyFlag(page, true);
+  }
+  page->is_io_in_progress_ = false;
+  if (--page->pin_count_ == 0) {
+    // No-op unless FindReplacementFrame took the frame out of the replacer in the meantime.
+    replacer_->Unpin(frame_id);
+  }
+}
+
+bool BufferPoolManager::FindReplacementFrame(frame_id_t *frame_id) {
+  if (!free_list_.empty()) {
+    *frame_id = free_list_.front();
+    free_list_.pop_front();
+    // A latch-free fetcher that looked the frame's old page up may hold it for a moment, it lets go without the latch.
+    while (!TryClaimFrame(pages_ + *frame_id)) {
+      std::this_thread::yield();
+    }
+    return true;
+  }
+  // Frames pinned by the page cleaner or without the latch are still in the replacer, whoever unpins them last puts
+  // them back. A latch-free unpin that raced with DeletePage may even have put a frame of the free list back. Frames
+  // above the pool size are left to Resize.
+  while (replacer_->Victim(frame_id)) {
+    Page *page = pages_ + *frame_id;
+    if (static_cast<size_t>(*frame_id) < pool_size_ && page->GetPageId() != INVALID_PAGE_ID && TryClaimFrame(page)) {
+      stats_.Increment(BufferPoolStatsCollector::Counter::EVICTIONS);
+      return true;
+    }
+  }
+  stats_.Increment(BufferPoolStatsCollector::Counter::NO_FREE_FRAMES);
+  return false;
+}
+
+Page *BufferPoolManager::TryFetchPageOptimistic(page_id_t page_id) {
+  frame_id_t frame_id;
+  if (!page_table_.Find(page_id, &frame_id)) {
+    return nullptr;
+  }
+  // Frames are only reassigned while they are claimed, i.e. have a negative pin count. Once our increment lands on a
+  // non-negative count nobody can claim the frame, so if it holds the page now it keeps holding it.
+  Page *page = pages_ + frame_id;
+  if (page->pin_count_.fetch_add(1) < 0 || page->GetPageId() != page_id || page->is_io_in_progress_) {
+    DropOptimisticPin(frame_id);
+    return nullptr;
+  }
+  replacer_->Pin(frame_id);
+  stats_.Increment(BufferPoolStatsCollector::Counter::HITS);
+  return page;
+}
+
+bool BufferPoolManager::TryUnpinPageOptimistic(page_id_t page_id, bool is_dirty) {
+  frame_id_t frame_id;
+  if (!page_table_.Find(page_id, &frame_id)) {
+    return false;
+  }
+  // A caller that holds a pin keeps the frame holding the page, anything else is left to the latched path.
+  Page *page = pages_ + frame_id;
+  int pin_count = page->pin_count_;
+  if (pin_count <= 0 || page->GetPageId() != page_id) {
+    return false;
+  }
+  if (is_dirty) {
+    SetDirtyFlag(page, true);
+  }
+  while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count - 1)) {
+    if (pin_count <= 0) {
+      return false;
+    }
+  }
+  if (pin_count == 1) {
+    replacer_->Unpin(frame_id);
+  }
+  return true;
+}
+
+void BufferPoolManager::DropOptimisticPin(frame_id_t frame_id) {
+  Page *page = pages_ + frame_id;
+  if (page->pin_count_.fetch_sub(1) != 1) {
+    return;
+  }
+  // Our pin may have made FindReplacementFrame skip the frame and drop it from the replacer, so put it back unless it
+  // is free or somebody pinned it meanwhile.
+  std::lock_guard<std::mutex> lock(latch_);
+  if (page->GetPageId() != INVALID_PAGE_ID && page->GetPinCount() == 0) {
+    replacer_->Unpin(frame_id);
+  }
+}
+
+void BufferPoolManager::SetDirtyFlag(Page *page, bool is_dirty) {
+  if (is_dirty && read_only_) {
+    return;  // the mapped page cannot have been modified
+  }
+  if (page->is_dirty_.exchange(is_dirty) != is_dirty) {
+    if (is_dirty) {
+      num_dirty_frames_++;
+    } else {
+      num_dirty_frames_--;
+    }
+  }
+}
+
+void BufferPoolManager::RunPageCleaner(double dirty_high_watermark, double dirty_low_watermark,
+                                       size_t max_pages_per_second) {
+  BUSTUB_ASSERT(dirty_low_watermark <= dirty_high_watermark, "low watermark must not exceed the high watermark");
+  StopPageCleaner();
+  std::lock_guard<std::mutex> lock(latch_);
+  cleaner_high_watermark_ = dirty_high_watermark;
+  cleaner_low_watermark_ = dirty_low_watermark;
+  cleaner_high_dirty_frames_ = static_cast<size_t>(dirty_high_watermark * pool_size_);
+  cleaner_low_dirty_frames_ = static_cast<size_t>(dirty_low_watermark * pool_size_);
+  cleaner_pages_per_interval_ = 0;
+  if (max_pages_per_second != 0) {
+    auto pages = max_pages_per_second * page_cleaner_interval.count() / 1000;
+    cleaner_pages_per_interval_ = std::max<size_t>(pages, 1);
+  }
+  page_cleaner_running_ = true;
+  page_cleaner_thread_ = new std::thread(&BufferPoolManager::PageCleanerLoop, this);
+}
+
+void BufferPoolManager::StopPageCleaner() {
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    if (page_cleaner_thread_ == nullptr) {
+      return;
+    }
+    page_cleaner_running_ = false;
+  }
+  page_cleaner_cv_.notify_all();
+  page_cleaner_thread_->join();
+  delete page_cleaner_thread_;
+  page_cleaner_thread_ = nullptr;
+}
+
+void BufferPoolManager::PageCleanerLoop() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (page_cleaner_running_) {
+    page_cleaner_cv_.wait_for(lock, page_cleaner_interval);
+    if (num_dirty_frames_ <= cleaner_high_dirty_frames_) {
+      continue;
+    }
+    size_t written = 0;
+    frame_id_t frame_id;
+    while (page_cleaner_running_ && num_dirty_frames_ > cleaner_low_dirty_frames_ &&
+           (cleaner_pages_per_interval_ == 0 || written < cleaner_pages_per_interval_) && FindFrameToClean(&frame_id)) {
+      // Pin the frame so that it is not evicted, then write it out without the latch. The frame stays in the replacer
+      // so that cleaning it does not change its position; FindReplacementFrame skips it while it is pinned. The page
+      // read latch keeps writers out until the dirty flag is cleared, so a modification made after the write is never
+      // lost.
+      Page &page = pages_[frame_id];
+      page.pin_count_++;
+      lock.unlock();
+      page.RLatch();
+      FlushLogUntil(page.GetLSN());
+      disk_manager_->WritePage(page.GetPageId(), page.GetData());
+      background_writes_++;
+      lock.lock();
+      SetDirtyFlag(&page, false);
+      page.RUnlatch();
+      if (--page.pin_count_ == 0) {
+        // No-op unless FindReplacementFrame took the frame out of the replacer in the meantime.
+        replacer_->Unpin(frame_id);
+      }
+      written++;
+    }
+  }
+}
+
+void BufferPoolManager::DiscardFailedRead(Page *page) {
+  LOG_DEBUG("failed to read page %d", page->GetPageId());
+  page_table_.Erase(page->GetPageId());
+  page->page_id_ = INVALID_PAGE_ID;
+  page->ResetMemory();
+}
+
+void BufferPoolManager::DropPinOfFailedRead(frame_id_t frame_id) {
+  if (--pages_[frame_id].pin_count_ == 0) {
+    // the frame holds no page, so it goes back on the free list like a deleted one
+    replacer_->Remove(frame_id);
+    if (static_cast<size_t>(frame_id) < pool_size_) {
+      free_list_.emplace_back(frame_id);
+    }
+  }
+}
+
+void BufferPoolManager::FlushLogUntil(lsn_t lsn) {
+  // Pages other than table pages keep something else where the LSN would be, which at worst flushes the log early.
+  if (enable_logging && log_manager_ != nullptr && lsn > log_manager_->GetPersistentLSN()) {
+    log_manager_->Flush(lsn);
+  }
+}
+
+bool BufferPoolManager::FindFrameToClean(frame_id_t *frame_id) {
+  for (size_t i = 0; i < pool_size_; ++i) {
+    Page &page = pages_[cleaner_hand_];
+    auto candidate = static_cast<frame_id_t>(cleaner_hand_);
+    cleaner_hand_ = (cleaner_hand_ + 1) % pool_size_;
+    if (page.IsDirty() && page.GetPinCount() == 0 && !page.is_io_in_progress_) {
+      *frame_id = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+void BufferPoolManager::PrefetchPages(page_id_t page_id, size_t count, next_page_id_fn next_page_id) {
+  if (page_id == INVALID_PAGE_ID || count == 0) {
+    return;
+  }
+  // Reading further ahead than a quarter of the pool would start evicting the pages the scan has yet to use.
+  count = std::min(count, std::max<size_t>(pool_size_ / 4, 1));
+  {
+    std::lock_guard<std::mutex> lock(prefetch_latch_);
+    if (prefetch_stopping_ || prefetch_queue_.size() >= MAX_PREFETCH_REQUESTS) {
+      return;
+    }
+    if (prefetch_thread_ == nullptr) {
+      prefetch_thread_ = new std::thread(&BufferPoolManager::PrefetchLoop, this);
+    }
+    prefetch_queue_.push_back({page_id, count, next_page_id});
+  }
+  prefetch_cv_.notify_one();
+}
+
+void BufferPoolManager::PrefetchLoop() {
+  std::unique_lock<std::mutex> lock(prefetch_latch_);
+  while (true) {
+    prefetch_cv_.wait(lock, [&] { return prefetch_stopping_ || !prefetch_queue_.empty(); });
+    if (prefetch_stopping_) {
+      return;
+    }
+    PrefetchRequest request = prefetch_queue_.front();
+    prefetch_queue_.pop_front();
+    lock.unlock();
+    // Go through FetchPage so that a ParallelBufferPoolManager routes every page of the chain to its shard. Reading
+    // the pages in order is what lets us follow the chain; the caller is busy with the pages before them meanwhile.
+    page_id_t page_id = request.page_id_;
+    for (size_t i = 0; i < request.count_ && page_id >= 0; ++i) {
+      Page *page = FetchPage(page_id);
+      if (page == nullptr) {
+        break;  // every frame is pinned, reading further ahead would not help
+      }
+      page->RLatch();
+      page_id_t next_page_id = request.next_page_id_(page->GetData());
+      page->RUnlatch();
+      UnpinPage(page_id, false);
+      page_id = next_page_id;
+    }
+    lock.lock();
+  }
+}
+
+void BufferPoolManager::StopPrefetchThread() {
+  {
+    std::lock_guard<std::mutex> lock(prefetch_latch_);
+    prefetch_stopping_ = true;
+    if (prefetch_thread_ == nullptr) {
+      return;
+    }
+  }
+  prefetch_cv_.notify_all();
+  prefetch_thread_->join();
+  delete prefetch_thread_;
+  prefetch_thread_ = nullptr;
+}
+
+page_id_t BufferPoolManager::AllocatePage() { return disk_manager_->AllocatePage(num_instances_, instance_index_); }
+
+size_t BufferPoolManager::Resize(size_t new_size) {
+  std::lock_guard<std::mutex> resize_lock(resize_latch_);
+  new_size = std::clamp<size_t>(new_size, 1, max_pool_size_);
+  std::unique_lock<std::mutex> lock(latch_);
+  size_t old_size = pool_size_;
+  if (new_size >= old_size) {
+    for (size_t i = old_size; i < new_size; ++i) {
+      free_list_.emplace_back(static_cast<frame_id_t>(i));
+    }
+    pool_size_ = new_size;
+  } else {
+    // From now on no frame above new_size is handed out again.
+    pool_size_ = new_size;
+    free_list_.remove_if([&](frame_id_t frame_id) { return static_cast<size_t>(frame_id) >= new_size; });
+    std::vector<frame_id_t> retiring;
+    for (size_t i = new_size; i < old_size; ++i) {
+      if (pages_[i].GetPageId() != INVALID_PAGE_ID) {
+        retiring.push_back(static_cast<frame_id_t>(i));
+      }
+    }
+    auto deadline = std::chrono::steady_clock::now() + buffer_pool_resize_timeout;
+    while (true) {
+      // Evict every retiring frame that nobody uses, like FindReplacementFrame would. Dirty frames stay claimed until
+      // they are written back without the latch.
+      std::vector<Page *> write_backs;
+      std::vector<frame_id_t> still_pinned;
+      for (frame_id_t frame_id : retiring) {
+        Page *page = pages_ + frame_id;
+        if (page->is_io_in_progress_ || !TryClaimFrame(page)) {
+          still_pinned.push_back(frame_id);
+          continue;
+        }
+        stats_.Increment(BufferPoolStatsCollector::Counter::EVICTIONS);
+        page_table_.Erase(page->GetPageId());
+        replacer_->Remove(frame_id);
+        if (page->IsDirty()) {
+          evicting_pages_.insert(page->GetPageId());
+          write_backs.push_back(page);
+        } else {
+          page->page_id_ = INVALID_PAGE_ID;
+          ReleaseFrame(page, 0);
+        }
+      }
+      retiring.swap(still_pinned);
+      if (!write_backs.empty()) {
+        lock.unlock();
+        for (Page *page : write_backs) {
+          auto write_back_start = BufferPoolStatsCollector::StartTimer();
+          FlushLogUntil(page->GetLSN());
+          disk_manager_->WritePage(page->GetPageId(), page->GetData());
+          stats_.RecordWriteBackLatency(write_back_start);
+          foreground_writes_++;
+        }
+        lock.lock();
+        for (Page *page : write_backs) {
+          evicting_pages_.erase(page->GetPageId());
+          SetDirtyFlag(page, false);
+          page->page_id_ = INVALID_PAGE_ID;
+          ReleaseFrame(page, 0);
+        }
+        io_cv_.notify_all();
+      }
+      if (retiring.empty() || std::chrono::steady_clock::now() >= deadline) {
+        break;
+      }
+      // Unpinning does not signal anybody, so check the pinned frames again a little later.
+      io_cv_.wait_for(lock, std::chrono::milliseconds(1));
+    }
+    // Frames that are still pinned keep the pool from shrinking below them. The frames under them that were retired
+    // meanwhile are taken back, and the pinned ones become evictable again once they are unpinned.
+    for (frame_id_t frame_id : retiring) {
+      pool_size_ = std::max<size_t>(pool_size_, frame_id + 1);
+    }
+    for (size_t i = new_size; i < pool_size_; ++i) {
+      Page &page = pages_[i];
+      if (page.GetPageId() == INVALID_PAGE_ID) {
+        free_list_.emplace_back(static_cast<frame_id_t>(i));
+      } else if (page.GetPinCount() == 0) {
+        replacer_->Unpin(static_cast<frame_id_t>(i));
+      }
+    }
+    frame_arena_->Release(static_cast<frame_id_t>(pool_size_.load()), old_size - pool_size_);
+  }
+  cleaner_high_dirty_frames_ = static_cast<size_t>(cleaner_high_watermark_ * pool_size_);
+  cleaner_low_dirty_frames_ = static_cast<size_t>(cleaner_low_watermark_ * pool_size_);
+  return pool_size_;
+}
+
+BufferPoolStats BufferPoolManager::GetStats() {
+  BufferPoolStats stats = stats_.Snapshot();
+  stats.foreground_write_backs_ = foreground_writes_;
+  stats.background_write_backs_ = background_writes_;
+  return stats;
+}
+
+ReadPageGuard BufferPoolManager::FetchPageRead(page_id_t page_id) {
+  Page *page = FetchPage(page_id);
+  if (page != nullptr) {
+    page->RLatch();
+  }
+  return {this, page};
+}
+
+WritePageGuard BufferPoolManager::FetchPageWrite(page_id_t page_id) {
+  Page *page = FetchPage(page_id);
+  if (page != nullptr) {
+    page->WLatch();
+  }
+  return {this, page};
+}
+
+BasicPageGuard BufferPoolManager::NewPageGuarded(page_id_t *page_id) {
+  BasicPageGuard guard(this, NewPage(page_id));
+  guard.MarkDirty();
+  return guard;
+}
+
+std::vector<Page *> BufferPoolManager::FetchPages(const std::vector<page_id_t> &page_ids) {
+  std::vector<Page *> pages(page_ids.size(), nullptr);
+  // A miss of the batch: the page read into a frame, and the page that was there before if it has to be written back.
+  struct PendingRead {
+    size_t index_;
+    page_id_t page_id_;
+    Page *page_;
+    page_id_t stale_page_id_;
+    bool write_back_;
+  };
+  std::vector<PendingRead> reads;
+  // Pages that another thread is still writing back. Waiting for them while our own reads are pending could deadlock
+  // with a batch that waits for one of ours, so they are fetched one by one at the end.
+  std::vector<size_t> deferred;
+  bool wait_for_io = false;
+  auto miss_start = BufferPoolStatsCollector::StartTimer();
+
+  // 1.     Pin the hits and claim a frame for every miss, the same way FetchPageImpl does, under one latch.
+  std::unique_lock<std::mutex> lock(latch_);
+  for (size_t i = 0; i < page_ids.size(); ++i) {
+    page_id_t page_id = page_ids[i];
+    if (evicting_pages_.count(page_id) != 0U) {
+      deferred.push_back(i);
+      continue;
+    }
+    frame_id_t frame_id;
+    if (page_table_.Find(page_id, &frame_id)) {
+      replacer_->Pin(frame_id);
+      pages_[frame_id].pin_count_++;
+      stats_.Increment(BufferPoolStatsCollector::Counter::HITS);
+      wait_for_io |= pages_[frame_id].is_io_in_progress_;
+      pages[i] = pages_ + frame_id;
+      continue;
+    }
+    if (!FindReplacementFrame(&frame_id)) {
+      continue;
+    }
+    stats_.Increment(BufferPoolStatsCollector::Counter::MISSES);
+    Page *page = pages_ + frame_id;
+    page_id_t stale_page_id = page->GetPageId();
+    bool write_back = page->IsDirty();
+    page_table_.Erase(stale_page_id);
+    page_table_.Insert(page_id, frame_id);
+    if (write_back) {
+      evicting_pages_.insert(stale_page_id);
+    }
+    replacer_->Pin(frame_id);
+    page->page_id_ = page_id;
+    SetDirtyFlag(page, false);
+    pages[i] = page;
+    if (read_only_) {
+      page->data_ = const_cast<char *>(disk_manager_->GetMappedPage(page_id));
+      ReleaseFrame(page, 1);
+      stats_.RecordMissLatency(miss_start);
+      continue;
+    }
+    page->is_io_in_progress_ = true;
+    ReleaseFrame(page, 1);
+    reads.push_back({i, page_id, page, stale_page_id, write_back});
+  }
+  lock.unlock();
+
+  // 2.     Write the dirty victims back, then read the misses in, both in page id order. The writes and the reads
+  //        are each issued together, so they overlap on the device.
+  if (!reads.empty()) {
+    std::sort(reads.begin(), reads.end(), [](const PendingRead &a, const PendingRead &b) {
+      return a.stale_page_id_ < b.stale_page_id_;
+    });
+    auto write_back_start = BufferPoolStatsCollector::StartTimer();
+    lsn_t max_lsn = INVALID_LSN;
+    for (const auto &read : reads) {
+      if (read.write_back_) {
+        max_lsn = std::max(max_lsn, read.page_->GetLSN());
+      }
+    }
+    FlushLogUntil(max_lsn);
+    std::vector<std::future<bool>> write_backs;
+    for (const auto &read : reads) {
+      if (read.write_back_) {
+        write_backs.push_back(disk_manager_->WritePageAsync(read.stale_page_id_, read.page_->GetData()));
+      }
+    }
+    for (auto &write_back : write_backs) {
+      write_back.wait();
+      stats_.RecordWriteBackLatency(write_back_start);
+      foreground_writes_++;
+    }
+    std::sort(reads.begin(), reads.end(),
+              [](const PendingRead &a, const PendingRead &b) { return a.page_id_ < b.page_id_; });
+    std::vector<std::future<bool>> disk_reads;
+    disk_reads.reserve(reads.size());
+    for (const auto &read : reads) {
+      read.page_->ResetMemory();
+      disk_reads.push_back(disk_manager_->ReadPageAsync(read.page_id_, read.page_->GetData()));
+    }
+    std::vector<bool> read_ok;
+    read_ok.reserve(reads.size());
+    for (auto &disk_read : disk_reads) {
+      read_ok.push_back(disk_read.get());
+      stats_.RecordMissLatency(miss_start);
+    }
+
+    lock.lock();
+    for (size_t i = 0; i < reads.size(); ++i) {
+      const PendingRead &read = reads[i];
+      if (read.write_back_) {
+        evicting_pages_.erase(read.stale_page_id_);
+      }
+      if (!read_ok[i]) {
+        DiscardFailedRead(read.page_);
+      }
+      read.page_->is_io_in_progress_ = false;
+      if (!read_ok[i]) {
+        DropPinOfFailedRead(static_cast<frame_id_t>(read.page_ - pages_));
+        pages[read.index_] = nullptr;
+      }
+    }
+    lock.unlock();
+    io_cv_.notify_all();
+  }
+
+  // 3.     Wait for the hits that other threads are still reading in, and fetch the deferred pages.
+  if (wait_for_io) {
+    lock.lock();
+    for (size_t i = 0; i < pages.size(); ++i) {
+      Page *page = pages[i];
+      if (page != nullptr && page->is_io_in_progress_) {
+        stats_.Increment(BufferPoolStatsCollector::Counter::PIN_WAITS);
+        io_cv_.wait(lock, [&] { return !page->is_io_in_progress_; });
+      }
+      // the read failed, see FetchPageImpl
+      if (page != nullptr && page->GetPageId() != page_ids[i]) {
+        DropPinOfFailedRead(static_cast<frame_id_t>(page - pages_));
+        pages[i] = nullptr;
+      }
+    }
+    lock.unlock();
+  }
+  for (size_t i : deferred) {
+    pages[i] = FetchPageImpl(page_ids[i]);
+  }
+  return pages;
+}
+
+bool BufferPoolManager::UnpinPages(const std::vector<std::pair<page_id_t, bool>> &pages) {
   std::lock_guard<std::mutex> lock(latch_);
-  for (auto p : page_table_) {
-    Page *page = pages_ + p.second;
-    disk_manager_->WritePage(page->GetPageId(), page->GetData());
-    page->is_dirty_ = false;
+  bool all_unpinned = true;
+  for (const auto &[page_id, is_dirty] : pages) {
+    all_unpinned &= UnpinPageLatched(page_id, is_dirty);
   }
+  return all_unpinned;
 }
 
 }  // namespace bustub
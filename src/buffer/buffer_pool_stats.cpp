@@ -0,0 +1,96 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.cpp
+//
+// Identification: src/buffer/buffer_pool_stats.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_stats.h"
+
+#include <sstream>
+
+#include "common/config.h"
+
+namespace bustub {
+
+void LatencyHistogram::Merge(const LatencyHistogram &other) {
+  for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+    buckets_[i] += other.buckets_[i];
+  }
+  count_ += other.count_;
+}
+
+uint64_t LatencyHistogram::GetPercentile(double percentile) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  auto rank = static_cast<uint64_t>(percentile / 100 * static_cast<double>(count_));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+    seen += buckets_[i];
+    if (seen > rank || seen == count_) {
+      return uint64_t{2} << i;
+    }
+  }
+  return uint64_t{2} << (NUM_BUCKETS - 1);
+}
+
+void BufferPoolStats::Merge(const BufferPoolStats &other) {
+  hits_ += other.hits_;
+  misses_ += other.misses_;
+  new_pages_ += other.new_pages_;
+  no_free_frames_ += other.no_free_frames_;
+  evictions_ += other.evictions_;
+  foreground_write_backs_ += other.foreground_write_backs_;
+  background_write_backs_ += other.background_write_backs_;
+  pin_waits_ += other.pin_waits_;
+  miss_latency_.Merge(other.miss_latency_);
+  write_back_latency_.Merge(other.write_back_latency_);
+}
+
+std::string BufferPoolStats::ToString() const {
+  std::ostringstream os;
+  os << "hits=" << hits_ << " misses=" << misses_ << " hit_ratio=" << HitRatio() << " new_pages=" << new_pages_
+     << " no_free_frames=" << no_free_frames_ << " evictions=" << evictions_
+     << " foreground_write_backs=" << foreground_write_backs_ << " background_write_backs=" << background_write_backs_
+     << " pin_waits=" << pin_waits_ << " miss_p50<=" << miss_latency_.GetPercentile(50)
+     << "ns miss_p99<=" << miss_latency_.GetPercentile(99)
+     << "ns write_back_p50<=" << write_back_latency_.GetPercentile(50)
+     << "ns write_back_p99<=" << write_back_latency_.GetPercentile(99) << "ns";
+  return os.str();
+}
+
+bool BufferPoolStatsCollector::Enabled() { return enable_buffer_pool_stats.load(std::memory_order_relaxed); }
+
+size_t BufferPoolStatsCollector::ShardIndex() {
+  static std::atomic<size_t> next_index{0};
+  thread_local size_t index = next_index.fetch_add(1, std::memory_order_relaxed) % NUM_SHARDS;
+  return index;
+}
+
+BufferPoolStats BufferPoolStatsCollector::Snapshot() const {
+  BufferPoolStats stats;
+  for (const auto &shard : shards_) {
+    auto counter = [&shard](Counter counter) {
+      return shard.counters_[static_cast<size_t>(counter)].load(std::memory_order_relaxed);
+    };
+    stats.hits_ += counter(Counter::HITS);
+    stats.misses_ += counter(Counter::MISSES);
+    stats.new_pages_ += counter(Counter::NEW_PAGES);
+    stats.no_free_frames_ += counter(Counter::NO_FREE_FRAMES);
+    stats.evictions_ += counter(Counter::EVICTIONS);
+    stats.pin_waits_ += counter(Counter::PIN_WAITS);
+    for (size_t i = 0; i < LatencyHistogram::NUM_BUCKETS; ++i) {
+      stats.miss_latency_.Add(i, shard.miss_latency_[i].load(std::memory_order_relaxed));
+      stats.write_back_latency_.Add(i, shard.write_back_latency_[i].load(std::memory_order_relaxed));
+    }
+  }
+  return stats;
+}
+
+}  // namespace bustub
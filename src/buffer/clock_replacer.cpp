@@ -14,16 +14,53 @@
 
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {}
+ClockReplacer::ClockReplacer(size_t num_pages) : in_replacer_(num_pages, false), ref_(num_pages, false) {}
 
 ClockReplacer::~ClockReplacer() = default;
 
-bool ClockReplacer::Victim(frame_id_t *frame_id) { return false; }
+bool ClockReplacer::Victim(frame_id_t *frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (size_ == 0) {
+    return false;
+  }
+  // Two sweeps are enough: the first one clears every reference bit it passes.
+  while (true) {
+    size_t frame = hand_;
+    hand_ = (hand_ + 1) % in_replacer_.size();
+    if (!in_replacer_[frame]) {
+      continue;
+    }
+    if (ref_[frame]) {
+      ref_[frame] = false;
+      continue;
+    }
+    in_replacer_[frame] = false;
+    size_--;
+    *frame_id = static_cast<frame_id_t>(frame);
+    return true;
+  }
+}
 
-void ClockReplacer::Pin(frame_id_t frame_id) {}
+void ClockReplacer::Pin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (in_replacer_[frame_id]) {
+    in_replacer_[frame_id] = false;
+    size_--;
+  }
+}
 
-void ClockReplacer::Unpin(frame_id_t frame_id) {}
+void ClockReplacer::Unpin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (!in_replacer_[frame_id]) {
+    in_replacer_[frame_id] = true;
+    size_++;
+  }
+  ref_[frame_id] = true;
+}
 
-size_t ClockReplacer::Size() { return 0; }
+size_t ClockReplacer::Size() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return size_;
+}
 
 }  // namespace bustub
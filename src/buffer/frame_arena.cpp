@@ -0,0 +1,79 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.cpp
+//
+// Identification: src/buffer/frame_arena.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <sys/mman.h>
+
+#include <cstdint>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+FrameArena::FrameArena(size_t num_frames, bool use_hugepages) {
+  mapped_size_ = num_frames * PAGE_SIZE;
+  if (mapped_size_ == 0) {
+    return;
+  }
+  void *data = MAP_FAILED;
+  if (use_hugepages) {
+    mapped_size_ = (mapped_size_ + HUGEPAGE_SIZE - 1) / HUGEPAGE_SIZE * HUGEPAGE_SIZE;
+    // Explicit hugepages only exist if the administrator reserved some, e.g. through vm.nr_hugepages.
+    data = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (data != MAP_FAILED) {
+      mode_ = Mode::HUGETLB_PAGES;
+    }
+  }
+  if (data == MAP_FAILED) {
+    data = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (data == MAP_FAILED) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "Couldn't map the frames of the buffer pool.");
+    }
+    if (use_hugepages && madvise(data, mapped_size_, MADV_HUGEPAGE) == 0) {
+      mode_ = Mode::TRANSPARENT_HUGEPAGES;
+    }
+  }
+  data_ = static_cast<char *>(data);
+}
+
+FrameArena::~FrameArena() {
+  if (data_ != nullptr) {
+    munmap(data_, mapped_size_);
+  }
+}
+
+void FrameArena::Release(frame_id_t first_frame, size_t num_frames) {
+  auto begin = reinterpret_cast<uintptr_t>(GetFrame(first_frame));
+  uintptr_t end = begin + num_frames * PAGE_SIZE;
+  if (mode_ == Mode::HUGETLB_PAGES) {
+    begin = (begin + HUGEPAGE_SIZE - 1) / HUGEPAGE_SIZE * HUGEPAGE_SIZE;
+    end = end / HUGEPAGE_SIZE * HUGEPAGE_SIZE;
+  }
+  if (begin < end) {
+    madvise(reinterpret_cast<void *>(begin), end - begin, MADV_DONTNEED);
+  }
+}
+
+const char *FrameArena::ModeToString(Mode mode) {
+  switch (mode) {
+    case Mode::REGULAR_PAGES:
+      return "regular pages";
+    case Mode::TRANSPARENT_HUGEPAGES:
+      return "transparent hugepages";
+    case Mode::HUGETLB_PAGES:
+      return "hugetlb pages";
+  }
+  return "unknown";
+}
+
+}  // namespace bustub
@@ -0,0 +1,78 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lock_free_clock_replacer.cpp
+//
+// Identification: src/buffer/lock_free_clock_replacer.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lock_free_clock_replacer.h"
+
+#include <thread>  // NOLINT
+
+#include "common/macros.h"
+
+namespace bustub {
+
+LockFreeClockReplacer::LockFreeClockReplacer(size_t num_pages)
+    : num_pages_(num_pages), states_(new std::atomic<uint8_t>[num_pages]) {
+  for (size_t i = 0; i < num_pages_; ++i) {
+    states_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+LockFreeClockReplacer::~LockFreeClockReplacer() = default;
+
+bool LockFreeClockReplacer::Victim(frame_id_t *frame_id) {
+  // The first sweep clears every reference bit it passes and the second finds an unreferenced frame. Frames that are
+  // referenced again behind the hand, or pinned before size_ counts it, may take more sweeps, so the hand goes on for
+  // as long as some frame is evictable, yielding between sweeps to let the threads that hold them back move on.
+  for (size_t step = 0; size_.load(std::memory_order_acquire) > 0; ++step) {
+    if (step >= 2 * num_pages_ && step % num_pages_ == 0) {
+      std::this_thread::yield();
+    }
+    size_t frame = hand_.fetch_add(1, std::memory_order_relaxed) % num_pages_;
+    uint8_t state = states_[frame].load(std::memory_order_acquire);
+    if ((state & EVICTABLE) == 0) {
+      continue;
+    }
+    if ((state & REF) != 0) {
+      states_[frame].fetch_and(static_cast<uint8_t>(~REF), std::memory_order_acq_rel);
+      continue;
+    }
+    // Fails if the frame was pinned or referenced after we read its state, the hand then simply moves on.
+    if (states_[frame].compare_exchange_strong(state, 0, std::memory_order_acq_rel)) {
+      size_.fetch_sub(1, std::memory_order_acq_rel);
+      *frame_id = static_cast<frame_id_t>(frame);
+      return true;
+    }
+  }
+  return false;
+}
+
+void LockFreeClockReplacer::Pin(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_pages_, "frame id out of range");
+  uint8_t old_state = states_[frame_id].exchange(0, std::memory_order_acq_rel);
+  if ((old_state & EVICTABLE) != 0) {
+    size_.fetch_sub(1, std::memory_order_acq_rel);
+  }
+}
+
+void LockFreeClockReplacer::Unpin(frame_id_t frame_id) {
+  BUSTUB_ASSERT(static_cast<size_t>(frame_id) < num_pages_, "frame id out of range");
+  uint8_t old_state = states_[frame_id].fetch_or(EVICTABLE | REF, std::memory_order_acq_rel);
+  if ((old_state & EVICTABLE) == 0) {
+    size_.fetch_add(1, std::memory_order_acq_rel);
+  }
+}
+
+size_t LockFreeClockReplacer::Size() {
+  int64_t size = size_.load(std::memory_order_acquire);
+  return size > 0 ? static_cast<size_t>(size) : 0;
+}
+
+}  // namespace bustub
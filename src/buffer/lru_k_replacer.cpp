@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.cpp
+//
+// Identification: src/buffer/lru_k_replacer.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lru_k_replacer.h"
+
+namespace bustub {
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k, size_t correlated_reference_period)
+    : k_(k), correlated_reference_period_(correlated_reference_period), frames_(num_pages) {}
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto *candidates = history_.empty() ? &cache_ : &history_;
+  if (candidates->empty()) {
+    return false;
+  }
+  *frame_id = candidates->begin()->second;
+  candidates->erase(candidates->begin());
+  // The frame is about to hold a different page, which starts with a clean history.
+  frames_[*frame_id].references_.clear();
+  frames_[*frame_id].evictable_ = false;
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  FrameHistory &frame = frames_[frame_id];
+  if (frame.evictable_) {
+    EvictionSet(frame_id)->erase(EvictionKey(frame_id));
+    frame.evictable_ = false;
+  }
+  current_timestamp_++;
+  if (!frame.references_.empty() && current_timestamp_ - frame.references_.back() <= correlated_reference_period_) {
+    return;  // same burst of accesses
+  }
+  frame.references_.push_back(current_timestamp_);
+  if (frame.references_.size() > k_) {
+    frame.references_.pop_front();
+  }
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  FrameHistory &frame = frames_[frame_id];
+  if (frame.evictable_) {
+    return;  // already unpinned!
+  }
+  if (frame.references_.empty()) {
+    // Unpinned without ever being accessed through Pin, treat this as its first reference.
+    frame.references_.push_back(++current_timestamp_);
+  }
+  frame.evictable_ = true;
+  EvictionSet(frame_id)->insert(EvictionKey(frame_id));
+}
+
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  FrameHistory &frame = frames_[frame_id];
+  if (frame.evictable_) {
+    EvictionSet(frame_id)->erase(EvictionKey(frame_id));
+    frame.evictable_ = false;
+  }
+  frame.references_.clear();
+}
+
+size_t LRUKReplacer::Size() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return history_.size() + cache_.size();
+}
+
+}  // namespace bustub
@@ -12,82 +12,60 @@
 
 #include "buffer/lru_replacer.h"
 #include "common/logger.h"
+#include "common/macros.h"
 
-/**
- * maybe some concurrency control issue not handled
- * 2020年9月30日 test case passed
- *
- */
 namespace bustub {
 
-LRUReplacer::LRUReplacer(size_t num_pages) : _capacity(num_pages) {
-  front = std::make_shared<Linked_list>();
-  rear = std::make_shared<Linked_list>();
-  front->right = rear;
-  rear->left = front;
+LRUReplacer::LRUReplacer(size_t num_pages)
+    : sentinel_(static_cast<frame_id_t>(num_pages)),
+      prev_(num_pages + 1, INVALID_FRAME),
+      next_(num_pages + 1, INVALID_FRAME) {
+  prev_[sentinel_] = sentinel_;
+  next_[sentinel_] = sentinel_;
 }
 
-LRUReplacer::~LRUReplacer() {
-  // LOG_INFO("LRU Destructor");
-  Linked_list *p = front.get();
-  while (p != nullptr) {
-    // LOG_INFO("un reference node");
-    Linked_list *next = p->right.get();
-    p->left = nullptr;
-    p->right = nullptr;
-    p = next;
-  }
-}
+LRUReplacer::~LRUReplacer() = default;
 
 bool LRUReplacer::Victim(frame_id_t *frame_id) {
-  // how to konw the frame's pin counter is 0 or not??? track by it self
-  // choose the list used page_frame_id and write it to the output parame
   std::lock_guard<std::mutex> guard(latch_);
-  auto least_used = front->right;
-  if (least_used == rear) {
+  frame_id_t least_used = next_[sentinel_];
+  if (least_used == sentinel_) {
     LOG_DEBUG("no Victim found in lru replacer");
     return false;
   }
-  *frame_id = least_used->data;
-  // delete the node
+  *frame_id = least_used;
   RemoveNode(least_used);
-  map.erase(least_used->data);
+  size_--;
   return true;
 }
-// will be called when access a frame?
-// It should remove the frame containing the pinned page from the LRUReplacer.
-// because pined page cann't be replaced!
+
+// It should remove the frame containing the pinned page from the LRUReplacer,
+// because pinned pages can't be replaced.
 void LRUReplacer::Pin(frame_id_t frame_id) {
+  BUSTUB_ASSERT(frame_id >= 0 && frame_id < sentinel_, "frame id out of range");
   std::lock_guard<std::mutex> guard(latch_);
-  if (map.count(frame_id) == 0U) {
+  if (!InList(frame_id)) {
     return;  // frame not in the replacer
   }
-  auto pined_frame = map[frame_id];
-  // remove the node from list
-  RemoveNode(pined_frame);
-  map.erase(frame_id);
+  RemoveNode(frame_id);
+  size_--;
 }
 
 void LRUReplacer::Unpin(frame_id_t frame_id) {
+  BUSTUB_ASSERT(frame_id >= 0 && frame_id < sentinel_, "frame id out of range");
   std::lock_guard<std::mutex> guard(latch_);
-  // capacity full
-  if (map.size() == _capacity) {
-    return;
-  }
-  if (map.count(frame_id) != 0U) {
-    return;  // already unpined!
+  if (InList(frame_id)) {
+    return;  // already unpinned!
   }
-  auto node = std::make_shared<Linked_list>(frame_id);
-  PushBack(node);
-  map[frame_id] = node;
+  PushBack(frame_id);
+  size_++;
 }
 
-// return the number of unpined frames?
 // this method returns the number of frames that are currently in the LRUReplacer.
-// the lRU replacer don't store pined pages
+// the LRU replacer doesn't store pinned pages
 size_t LRUReplacer::Size() {
   std::lock_guard<std::mutex> guard(latch_);
-  return map.size();
+  return size_;
 }
 
 }  // namespace bustub
@@ -0,0 +1,95 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.cpp
+//
+// Identification: src/buffer/page_table.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_table.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+PageTable::PageTable(size_t num_frames) {
+  // Keep the load factor at or below 1/2.
+  unsigned bits = 1;
+  while ((size_t{1} << bits) < 2 * num_frames) {
+    bits++;
+  }
+  capacity_ = size_t{1} << bits;
+  mask_ = capacity_ - 1;
+  shift_ = 64 - bits;
+  slots_.reset(new std::atomic<uint64_t>[capacity_]);
+  for (size_t slot = 0; slot < capacity_; ++slot) {
+    slots_[slot].store(EMPTY, std::memory_order_relaxed);
+  }
+}
+
+size_t PageTable::FindSlot(page_id_t page_id) const {
+  for (size_t slot = SlotOf(page_id), probes = 0; probes < capacity_; slot = (slot + 1) & mask_, ++probes) {
+    uint64_t entry = slots_[slot].load(std::memory_order_relaxed);
+    if (entry == EMPTY) {
+      return capacity_;
+    }
+    if (PageIdOf(entry) == page_id) {
+      return slot;
+    }
+  }
+  return capacity_;
+}
+
+void PageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+  BUSTUB_ASSERT(page_id != INVALID_PAGE_ID, "cannot map the invalid page id");
+  size_t slot = SlotOf(page_id);
+  while (true) {
+    uint64_t entry = slots_[slot].load(std::memory_order_relaxed);
+    if (entry == EMPTY || PageIdOf(entry) == page_id) {
+      if (entry == EMPTY) {
+        BUSTUB_ASSERT(size_ < capacity_ / 2, "page table is full");
+        size_++;
+      }
+      slots_[slot].store(MakeEntry(page_id, frame_id), std::memory_order_release);
+      return;
+    }
+    slot = (slot + 1) & mask_;
+  }
+}
+
+bool PageTable::Erase(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  size_t hole = FindSlot(page_id);
+  if (hole == capacity_) {
+    return false;
+  }
+  // Backward-shift deletion: move every later entry of the cluster that may not live behind the hole into it, so the
+  // table never needs tombstones. An entry is copied into the hole before its old slot is reused, so a latch-free
+  // reader can at worst miss it, never find a wrong mapping.
+  size_t slot = hole;
+  while (true) {
+    slot = (slot + 1) & mask_;
+    uint64_t entry = slots_[slot].load(std::memory_order_relaxed);
+    if (entry == EMPTY) {
+      break;
+    }
+    size_t home = SlotOf(PageIdOf(entry));
+    bool stays = hole <= slot ? (hole < home && home <= slot) : (hole < home || home <= slot);
+    if (stays) {
+      continue;
+    }
+    slots_[hole].store(entry, std::memory_order_release);
+    hole = slot;
+  }
+  slots_[hole].store(EMPTY, std::memory_order_release);
+  size_--;
+  return true;
+}
+
+}  // namespace bustub
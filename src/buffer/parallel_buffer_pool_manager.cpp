@@ -0,0 +1,180 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.cpp
+//
+// Identification: src/buffer/parallel_buffer_pool_manager.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                                                     LogManager *log_manager, ReplacerType replacer_type,
+                                                     size_t max_pool_size)
+    : BufferPoolManager(disk_manager, log_manager) {
+  instances_.reserve(num_instances);
+  for (size_t i = 0; i < num_instances; ++i) {
+    instances_.push_back(new BufferPoolManager(pool_size, static_cast<uint32_t>(num_instances),
+                                               static_cast<uint32_t>(i), disk_manager, log_manager, replacer_type,
+                                               max_pool_size));
+  }
+  pool_size_ = num_instances * pool_size;
+  max_pool_size_ = num_instances * instances_[0]->GetMaxPoolSize();
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  StopPrefetchThread();
+  for (auto *instance : instances_) {
+    delete instance;
+  }
+}
+
+BufferPoolManager *ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) {
+  return instances_[static_cast<size_t>(page_id) % instances_.size()];
+}
+
+Page *ParallelBufferPoolManager::FetchPageImpl(page_id_t page_id) {
+  return GetBufferPoolManager(page_id)->FetchPage(page_id);
+}
+
+bool ParallelBufferPoolManager::UnpinPageImpl(page_id_t page_id, bool is_dirty) {
+  return GetBufferPoolManager(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+bool ParallelBufferPoolManager::FlushPageImpl(page_id_t page_id) {
+  return GetBufferPoolManager(page_id)->FlushPage(page_id);
+}
+
+Page *ParallelBufferPoolManager::NewPageImpl(page_id_t *page_id) {
+  // Start from a different shard on every call and fall through to the others if that one is full.
+  size_t start = next_instance_.fetch_add(1) % instances_.size();
+  for (size_t i = 0; i < instances_.size(); ++i) {
+    Page *page = instances_[(start + i) % instances_.size()]->NewPage(page_id);
+    if (page != nullptr) {
+      return page;
+    }
+  }
+  return nullptr;
+}
+
+bool ParallelBufferPoolManager::DeletePageImpl(page_id_t page_id) {
+  return GetBufferPoolManager(page_id)->DeletePage(page_id);
+}
+
+void ParallelBufferPoolManager::FlushAllPagesImpl() {
+  if (!enable_write_batching || disk_manager_ == nullptr || disk_manager_->IsReadOnly()) {
+    for (auto *instance : instances_) {
+      instance->FlushAllPages();
+    }
+    return;
+  }
+  // The dirty pages of every shard go to disk in one batch, which costs a single sync instead of one per shard.
+  std::vector<std::pair<page_id_t, const char *>> writes;
+  std::vector<std::vector<std::pair<frame_id_t, bool>>> flushed(instances_.size());
+  lsn_t max_lsn = INVALID_LSN;
+  for (size_t i = 0; i < instances_.size(); ++i) {
+    max_lsn = std::max(max_lsn, instances_[i]->BeginFlushAll(&writes, &flushed[i]));
+  }
+  FlushLogUntil(max_lsn);
+  bool ok = disk_manager_->WritePages(writes);
+  for (size_t i = 0; i < instances_.size(); ++i) {
+    instances_[i]->EndFlushAll(flushed[i], std::vector<bool>(flushed[i].size(), ok));
+  }
+}
+
+size_t ParallelBufferPoolManager::Resize(size_t new_size) {
+  std::lock_guard<std::mutex> resize_lock(resize_latch_);
+  size_t total = 0;
+  for (size_t i = 0; i < instances_.size(); ++i) {
+    size_t shard_size = new_size / instances_.size() + (i < new_size % instances_.size() ? 1 : 0);
+    total += instances_[i]->Resize(shard_size);
+  }
+  pool_size_ = total;
+  return total;
+}
+
+std::vector<Page *> ParallelBufferPoolManager::FetchPages(const std::vector<page_id_t> &page_ids) {
+  // Positions in page_ids of the pages of every shard.
+  std::vector<std::vector<size_t>> positions(instances_.size());
+  for (size_t i = 0; i < page_ids.size(); ++i) {
+    positions[static_cast<size_t>(page_ids[i]) % instances_.size()].push_back(i);
+  }
+  std::vector<Page *> pages(page_ids.size(), nullptr);
+  std::vector<page_id_t> shard_page_ids;
+  for (size_t shard = 0; shard < instances_.size(); ++shard) {
+    if (positions[shard].empty()) {
+      continue;
+    }
+    shard_page_ids.clear();
+    for (size_t i : positions[shard]) {
+      shard_page_ids.push_back(page_ids[i]);
+    }
+    std::vector<Page *> shard_pages = instances_[shard]->FetchPages(shard_page_ids);
+    for (size_t j = 0; j < shard_pages.size(); ++j) {
+      pages[positions[shard][j]] = shard_pages[j];
+    }
+  }
+  return pages;
+}
+
+bool ParallelBufferPoolManager::UnpinPages(const std::vector<std::pair<page_id_t, bool>> &pages) {
+  std::vector<std::vector<std::pair<page_id_t, bool>>> shard_pages(instances_.size());
+  for (const auto &page : pages) {
+    shard_pages[static_cast<size_t>(page.first) % instances_.size()].push_back(page);
+  }
+  bool all_unpinned = true;
+  for (size_t shard = 0; shard < instances_.size(); ++shard) {
+    if (!shard_pages[shard].empty()) {
+      all_unpinned &= instances_[shard]->UnpinPages(shard_pages[shard]);
+    }
+  }
+  return all_unpinned;
+}
+
+void ParallelBufferPoolManager::RunPageCleaner(double dirty_high_watermark, double dirty_low_watermark,
+                                               size_t max_pages_per_second) {
+  size_t shard_pages_per_second = (max_pages_per_second + instances_.size() - 1) / instances_.size();
+  for (auto *instance : instances_) {
+    instance->RunPageCleaner(dirty_high_watermark, dirty_low_watermark, shard_pages_per_second);
+  }
+}
+
+void ParallelBufferPoolManager::StopPageCleaner() {
+  for (auto *instance : instances_) {
+    instance->StopPageCleaner();
+  }
+}
+
+size_t ParallelBufferPoolManager::GetForegroundWriteCount() {
+  size_t count = 0;
+  for (auto *instance : instances_) {
+    count += instance->GetForegroundWriteCount();
+  }
+  return count;
+}
+
+size_t ParallelBufferPoolManager::GetBackgroundWriteCount() {
+  size_t count = 0;
+  for (auto *instance : instances_) {
+    count += instance->GetBackgroundWriteCount();
+  }
+  return count;
+}
+
+BufferPoolStats ParallelBufferPoolManager::GetStats() {
+  BufferPoolStats stats;
+  for (auto *instance : instances_) {
+    stats.Merge(instance->GetStats());
+  }
+  return stats;
+}
+
+}  // namespace bustub
@@ -20,4 +20,26 @@ std::chrono::duration<int64_t> log_timeout = std::chrono::seconds(1);
 
 std::chrono::milliseconds cycle_detection_interval = std::chrono::milliseconds(50);
 
+std::chrono::milliseconds page_cleaner_interval = std::chrono::milliseconds(10);
+
+std::atomic<bool> enable_hugepage_frames(false);
+
+std::atomic<bool> enable_buffer_pool_stats(true);
+
+std::atomic<bool> enable_optimistic_pinning(true);
+
+std::chrono::milliseconds buffer_pool_resize_timeout = std::chrono::milliseconds(1000);
+
+std::atomic<bool> enable_io_uring(true);
+
+size_t disk_io_queue_depth = 32;
+
+std::atomic<bool> enable_direct_io(false);
+
+std::atomic<PageChecksumMode> page_checksum_mode(PageChecksumMode::VERIFY);
+
+std::atomic<bool> enable_write_batching(true);
+
+std::atomic<bool> enable_page_compression(false);
+
 }  // namespace bustub
@@ -0,0 +1,111 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c.cpp
+//
+// Identification: src/common/util/crc32c.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/crc32c.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+namespace bustub {
+
+namespace {
+
+// the CRC32C polynomial, bit reversed
+constexpr uint32_t POLYNOMIAL = 0x82F63B78;
+
+/** Slice-by-8 lookup tables: table[k][b] is the CRC of byte b followed by k zero bytes. */
+struct Crc32cTables {
+  std::array<std::array<uint32_t, 256>, 8> table_;
+
+  Crc32cTables() : table_() {
+    for (uint32_t b = 0; b < 256; ++b) {
+      uint32_t crc = b;
+      for (int bit = 0; bit < 8; ++bit) {
+        crc = (crc >> 1) ^ ((crc & 1) != 0 ? POLYNOMIAL : 0);
+      }
+      table_[0][b] = crc;
+    }
+    for (uint32_t b = 0; b < 256; ++b) {
+      for (size_t k = 1; k < 8; ++k) {
+        table_[k][b] = (table_[k - 1][b] >> 8) ^ table_[0][table_[k - 1][b] & 0xFF];
+      }
+    }
+  }
+};
+
+const Crc32cTables &Tables() {
+  static const Crc32cTables tables;
+  return tables;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2"))) uint32_t ComputeHardware(const void *data, size_t length, uint32_t crc) {
+  const auto *bytes = static_cast<const uint8_t *>(data);
+  uint64_t crc64 = ~crc;
+  for (; length >= 8; bytes += 8, length -= 8) {
+    uint64_t word;
+    memcpy(&word, bytes, sizeof(word));
+    crc64 = _mm_crc32_u64(crc64, word);
+  }
+  auto crc32 = static_cast<uint32_t>(crc64);
+  for (; length > 0; ++bytes, --length) {
+    crc32 = _mm_crc32_u8(crc32, *bytes);
+  }
+  return ~crc32;
+}
+#endif
+
+}  // namespace
+
+uint32_t Crc32c::ComputeSoftware(const void *data, size_t length, uint32_t crc) {
+  const auto &table = Tables().table_;
+  const auto *bytes = static_cast<const uint8_t *>(data);
+  crc = ~crc;
+  for (; length >= 8; bytes += 8, length -= 8) {
+    uint32_t low;
+    uint32_t high;
+    memcpy(&low, bytes, sizeof(low));
+    memcpy(&high, bytes + 4, sizeof(high));
+    // the tables are for little-endian words
+    low ^= crc;
+    crc = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF] ^ table[5][(low >> 16) & 0xFF] ^ table[4][low >> 24] ^
+          table[3][high & 0xFF] ^ table[2][(high >> 8) & 0xFF] ^ table[1][(high >> 16) & 0xFF] ^ table[0][high >> 24];
+  }
+  for (; length > 0; ++bytes, --length) {
+    crc = (crc >> 8) ^ table[0][(crc ^ *bytes) & 0xFF];
+  }
+  return ~crc;
+}
+
+bool Crc32c::IsHardwareAccelerated() {
+#if defined(__x86_64__)
+  static const bool has_sse42 = __builtin_cpu_supports("sse4.2");
+  return has_sse42;
+#else
+  return false;
+#endif
+}
+
+uint32_t Crc32c::Compute(const void *data, size_t length, uint32_t crc) {
+#if defined(__x86_64__)
+  if (IsHardwareAccelerated()) {
+    return ComputeHardware(data, length, crc);
+  }
+#endif
+  return ComputeSoftware(data, length, crc);
+}
+
+}  // namespace bustub
@@ -0,0 +1,204 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz4.cpp
+//
+// Identification: src/common/util/lz4.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/lz4.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+namespace bustub {
+
+namespace {
+
+constexpr size_t MIN_MATCH = 4;
+// the last bytes of a block are always literals
+constexpr size_t LAST_LITERALS = 5;
+// no match starts within the last MF_LIMIT bytes of a block
+constexpr size_t MF_LIMIT = 12;
+constexpr size_t MAX_OFFSET = 65535;
+// a length that does not fit into its 4 bits of the token continues in the following bytes
+constexpr size_t RUN_MASK = 15;
+constexpr int HASH_LOG = 12;
+// after this many misses in a row the search starts skipping bytes, which speeds up incompressible input
+constexpr int SKIP_TRIGGER = 6;
+
+uint32_t Read32(const char *p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+uint32_t Hash(uint32_t sequence) { return (sequence * 2654435761U) >> (32 - HASH_LOG); }
+
+/** @return the number of bytes a length takes after the token */
+size_t ExtraLengthBytes(size_t length) { return length < RUN_MASK ? 0 : (length - RUN_MASK) / 255 + 1; }
+
+char *WriteExtraLength(char *op, size_t length) {
+  if (length < RUN_MASK) {
+    return op;
+  }
+  for (length -= RUN_MASK; length >= 255; length -= 255) {
+    *op++ = static_cast<char>(255);
+  }
+  *op++ = static_cast<char>(length);
+  return op;
+}
+
+/**
+ * Appends a sequence: a run of literals followed by a match, or by nothing if it is the last sequence.
+ * @param match_length 0 for the last sequence
+ * @return false if the sequence does not fit
+ */
+bool WriteSequence(char **op, const char *op_end, const char *literals, size_t literal_length, size_t offset,
+                   size_t match_length) {
+  size_t match_code = match_length == 0 ? 0 : match_length - MIN_MATCH;
+  size_t size = 1 + ExtraLengthBytes(literal_length) + literal_length;
+  if (match_length != 0) {
+    size += 2 + ExtraLengthBytes(match_code);
+  }
+  if (static_cast<size_t>(op_end - *op) < size) {
+    return false;
+  }
+  char *out = *op;
+  *out++ = static_cast<char>((std::min(literal_length, RUN_MASK) << 4) | std::min(match_code, RUN_MASK));
+  out = WriteExtraLength(out, literal_length);
+  memcpy(out, literals, literal_length);
+  out += literal_length;
+  if (match_length != 0) {
+    *out++ = static_cast<char>(offset & 0xFF);
+    *out++ = static_cast<char>(offset >> 8);
+    out = WriteExtraLength(out, match_code);
+  }
+  *op = out;
+  return true;
+}
+
+/** Adds the bytes following a length of RUN_MASK. @return false if the block ends first */
+bool ReadExtraLength(const uint8_t **ip, const uint8_t *ip_end, size_t *length) {
+  if (*length != RUN_MASK) {
+    return true;
+  }
+  uint8_t byte;
+  do {
+    if (*ip == ip_end) {
+      return false;
+    }
+    byte = *(*ip)++;
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+}  // namespace
+
+size_t Lz4::Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity) {
+  char *op = dst;
+  const char *const op_end = dst + dst_capacity;
+  const char *anchor = src;
+  const char *const end = src + src_size;
+  if (src_size > MF_LIMIT) {
+    // positions of recent 4-byte sequences, -1 if none
+    int32_t table[1 << HASH_LOG];
+    std::fill(std::begin(table), std::end(table), -1);
+    const char *const match_limit = end - LAST_LITERALS;
+    const char *const search_limit = end - MF_LIMIT;
+    const char *ip = src;
+    uint32_t misses = 0;
+    while (ip < search_limit) {
+      uint32_t sequence = Read32(ip);
+      uint32_t hash = Hash(sequence);
+      int32_t candidate = table[hash];
+      table[hash] = static_cast<int32_t>(ip - src);
+      if (candidate < 0 || static_cast<size_t>(ip - src - candidate) > MAX_OFFSET ||
+          Read32(src + candidate) != sequence) {
+        ip += 1 + (misses++ >> SKIP_TRIGGER);
+        continue;
+      }
+      misses = 0;
+      const char *match = src + candidate;
+      size_t match_length = MIN_MATCH;
+      while (ip + match_length < match_limit && ip[match_length] == match[match_length]) {
+        match_length++;
+      }
+      // the match may also reach back into the pending literals
+      while (ip > anchor && match > src && ip[-1] == match[-1]) {
+        ip--;
+        match--;
+        match_length++;
+      }
+      if (!WriteSequence(&op, op_end, anchor, ip - anchor, ip - match, match_length)) {
+        return 0;
+      }
+      ip += match_length;
+      anchor = ip;
+      // remember a position inside the match too, matches often continue where the previous one ended
+      table[Hash(Read32(ip - 2))] = static_cast<int32_t>(ip - 2 - src);
+    }
+  }
+  if (!WriteSequence(&op, op_end, anchor, end - anchor, 0, 0)) {
+    return 0;
+  }
+  return op - dst;
+}
+
+int64_t Lz4::Decompress(const char *src, size_t src_size, char *dst, size_t dst_capacity) {
+  const auto *ip = reinterpret_cast<const uint8_t *>(src);
+  const uint8_t *const ip_end = ip + src_size;
+  char *op = dst;
+  const char *const op_end = dst + dst_capacity;
+  while (true) {
+    if (ip == ip_end) {
+      return -1;
+    }
+    uint8_t token = *ip++;
+    size_t literal_length = token >> 4;
+    if (!ReadExtraLength(&ip, ip_end, &literal_length) || literal_length > static_cast<size_t>(ip_end - ip) ||
+        literal_length > static_cast<size_t>(op_end - op)) {
+      return -1;
+    }
+    memcpy(op, ip, literal_length);
+    ip += literal_length;
+    op += literal_length;
+    if (ip == ip_end) {
+      // the last sequence has no match
+      break;
+    }
+    if (ip_end - ip < 2) {
+      return -1;
+    }
+    size_t offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    size_t match_length = token & RUN_MASK;
+    if (offset == 0 || offset > static_cast<size_t>(op - dst) || !ReadExtraLength(&ip, ip_end, &match_length)) {
+      return -1;
+    }
+    match_length += MIN_MATCH;
+    if (match_length > static_cast<size_t>(op_end - op)) {
+      return -1;
+    }
+    const char *match = op - offset;
+    if (offset >= match_length) {
+      memcpy(op, match, match_length);
+      op += match_length;
+    } else {
+      // the match overlaps the bytes it produces, e.g. a run of one repeated byte
+      for (size_t i = 0; i < match_length; ++i) {
+        *op++ = *match++;
+      }
+    }
+  }
+  return op - dst;
+}
+
+}  // namespace bustub
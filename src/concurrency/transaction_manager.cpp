@@ -21,6 +21,7 @@
 namespace bustub {
 
 std::unordered_map<txn_id_t, Transaction *> TransactionManager::txn_map = {};
+std::mutex TransactionManager::txn_map_latch;
 
 Transaction *TransactionManager::Begin(Transaction *txn, IsolationLevel isolation_level) {
   // Acquire the global transaction latch in shared mode.
@@ -30,6 +31,12 @@ Transaction *TransactionManager::Begin(Transaction *txn, IsolationLevel isolatio
     txn = new Transaction(next_txn_id_++, isolation_level);
   }
 
+  if (enable_logging) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::BEGIN);
+    txn->SetPrevLSN(log_manager_->AppendLogRecord(&log_record));
+  }
+
+  std::lock_guard<std::mutex> guard(txn_map_latch);
   txn_map[txn->GetTransactionId()] = txn;
   return txn;
 }
@@ -50,6 +57,14 @@ void TransactionManager::Commit(Transaction *txn) {
   }
   write_set->clear();
 
+  if (enable_logging) {
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::COMMIT);
+    lsn_t lsn = log_manager_->AppendLogRecord(&log_record);
+    txn->SetPrevLSN(lsn);
+    // The commit is durable once its record is; concurrent commits are flushed together.
+    log_manager_->Flush(lsn);
+  }
+
   // Release all the locks.
   ReleaseLocks(txn);
   // Release the global transaction latch.
@@ -100,6 +115,12 @@ void TransactionManager::Abort(Transaction *txn) {
   table_write_set->clear();
   index_write_set->clear();
 
+  if (enable_logging) {
+    // An abort does not wait for its record: if the record is lost, recovery undoes the transaction anyway.
+    LogRecord log_record(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::ABORT);
+    txn->SetPrevLSN(log_manager_->AppendLogRecord(&log_record));
+  }
+
   // Release all the locks.
   ReleaseLocks(txn);
   // Release the global transaction latch.
@@ -11,11 +11,20 @@
 //===----------------------------------------------------------------------===//
 #include "execution/executors/index_scan_executor.h"
 
+#include <algorithm>
+#include <unordered_set>
+
 namespace bustub {
 IndexScanExecutor::IndexScanExecutor(ExecutorContext *exec_ctx, const IndexScanPlanNode *plan)
     : AbstractExecutor(exec_ctx), plan_(plan), index_iterator_(nullptr) {}
 
-void IndexScanExecutor::Init() { index_iterator_.reset(nullptr); }
+void IndexScanExecutor::Init() {
+  index_iterator_.reset(nullptr);
+  batch_rids_.clear();
+  batch_tuples_.clear();
+  batch_found_.clear();
+  batch_cursor_ = 0;
+}
 
 bool IndexScanExecutor::Next(Tuple *tuple, RID *rid) {
   index_oid_t indexOid = plan_->GetIndexOid();
@@ -30,21 +39,41 @@ bool IndexScanExecutor::Next(Tuple *tuple, RID *rid) {
   }
   IndexIterator<GenericKey<8>, RID, GenericComparator<8>> endIterator = index->GetEndIterator();
   TableMetadata *tableMetadata = exec_ctx_->GetCatalog()->GetTable(indexInfo->table_name_);
-  while (index_iterator_.operator*() != endIterator) {
-    *rid = index_iterator_.operator*().operator*().second;
-    index_iterator_.operator*().operator++();
-    rid->GetPageId();
-    bool ok;
-    bool predicated = false;
-    ok = tableMetadata->table_->GetTuple(*rid, tuple, exec_ctx_->GetTransaction());
-    if (ok) {
-      predicated = plan_->GetPredicate()->Evaluate(tuple, &tableMetadata->schema_).GetAs<bool>();
+  while (true) {
+    if (batch_cursor_ == batch_rids_.size() && !FetchNextBatch(endIterator, tableMetadata->table_.get())) {
+      return false;
     }
-    if (predicated) {
+    size_t i = batch_cursor_++;
+    if (batch_found_[i] && plan_->GetPredicate()->Evaluate(&batch_tuples_[i], &tableMetadata->schema_).GetAs<bool>()) {
+      *tuple = batch_tuples_[i];
+      *rid = batch_rids_[i];
       return true;
     }
   }
-  return false;
+}
+
+bool IndexScanExecutor::FetchNextBatch(const IndexIterator<GenericKey<8>, RID, GenericComparator<8>> &end,
+                                       TableHeap *table_heap) {
+  size_t max_pages = std::max<size_t>(exec_ctx_->GetBufferPoolManager()->GetPoolSize() / 4, 1);
+  std::unordered_set<page_id_t> pages;
+  batch_rids_.clear();
+  batch_cursor_ = 0;
+  while (*index_iterator_ != end && batch_rids_.size() < MAX_BATCH_SIZE) {
+    RID rid = (**index_iterator_).second;
+    if (pages.count(rid.GetPageId()) == 0U) {
+      if (pages.size() == max_pages) {
+        break;
+      }
+      pages.insert(rid.GetPageId());
+    }
+    batch_rids_.push_back(rid);
+    ++*index_iterator_;
+  }
+  if (batch_rids_.empty()) {
+    return false;
+  }
+  batch_found_ = table_heap->GetTuples(batch_rids_, &batch_tuples_, exec_ctx_->GetTransaction());
+  return true;
 }
 
 }  // namespace bustub
@@ -12,37 +12,77 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <limits>
 #include <list>
-#include <mutex>  // NOLINT
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
+#include "buffer/buffer_pool_stats.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/frame_arena.h"
+#include "buffer/lock_free_clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/page_table.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
+ *
+ * On a disk manager that is READ_ONLY, the buffer pool copies nothing: a frame points at its page in the mapped db
+ * file, and the buffer pool only keeps track of the pins. Pages cannot be created, deleted or modified then.
  */
 class BufferPoolManager {
  public:
   enum class CallbackType { BEFORE, AFTER };
+  /** The replacement policy a BufferPoolManager uses to pick victims. */
+  enum class ReplacerType { LRU, LRU_K, CLOCK, LOCK_FREE_CLOCK };
   using bufferpool_callback_fn = void (*)(enum CallbackType, const page_id_t page_id);
+  /** Reads the id of the page that follows a page in a chain of pages, e.g. a table heap or the B+ tree leaves. */
+  using next_page_id_fn = page_id_t (*)(const char *page_data);
 
   /**
    * Creates a new BufferPoolManager.
    * @param pool_size the size of the buffer pool
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy, LRU_K keeps frequently used pages around during large scans and
+   * LOCK_FREE_CLOCK never blocks in the replacer
+   * @param max_pool_size the size Resize may grow the buffer pool to, 0 = pool_size
    */
-  BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr);
+  BufferPoolManager(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                    ReplacerType replacer_type = ReplacerType::LRU, size_t max_pool_size = 0);
+
+  /**
+   * Creates a new BufferPoolManager that serves as one shard of a ParallelBufferPoolManager.
+   * @param pool_size the size of this shard
+   * @param num_instances the total number of shards
+   * @param instance_index the index of this shard, every page id it allocates is congruent to it modulo num_instances
+   * @param disk_manager the disk manager
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy
+   * @param max_pool_size the size Resize may grow this shard to, 0 = pool_size
+   */
+  BufferPoolManager(size_t pool_size, uint32_t num_instances, uint32_t instance_index, DiskManager *disk_manager,
+                    LogManager *log_manager = nullptr, ReplacerType replacer_type = ReplacerType::LRU,
+                    size_t max_pool_size = 0);
 
   /**
    * Destroys an existing BufferPoolManager.
    */
-  ~BufferPoolManager();
+  virtual ~BufferPoolManager();
 
   /** Grading function. Do not modify! */
   Page *FetchPage(page_id_t page_id, bufferpool_callback_fn callback = nullptr) {
@@ -91,13 +131,119 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
-  /** @return pointer to all the pages in the buffer pool */
+  /**
+   * Fetches a page and wraps it in a guard that unpins it when the guard goes out of scope.
+   * @param page_id id of page to be fetched
+   * @return the guarded page, an empty guard if the page could not be fetched
+   */
+  BasicPageGuard FetchPageBasic(page_id_t page_id) { return {this, FetchPage(page_id)}; }
+
+  /**
+   * Fetches a page and read-latches it. The guard unlatches and unpins it when it goes out of scope.
+   * @param page_id id of page to be fetched
+   * @return the guarded page, an empty guard if the page could not be fetched
+   */
+  ReadPageGuard FetchPageRead(page_id_t page_id);
+
+  /**
+   * Fetches a page and write-latches it. The guard unlatches and unpins it when it goes out of scope, and marks it
+   * dirty if it was modified through the guard.
+   * @param page_id id of page to be fetched
+   * @return the guarded page, an empty guard if the page could not be fetched
+   */
+  WritePageGuard FetchPageWrite(page_id_t page_id);
+
+  /**
+   * Creates a new page and wraps it in a guard. The new page is dirty, so it is written back even if the caller does
+   * not modify it.
+   * @param[out] page_id id of created page
+   * @return the guarded page, an empty guard if no new page could be created
+   */
+  BasicPageGuard NewPageGuarded(page_id_t *page_id);
+
+  /**
+   * Fetches several pages at once. The latch is taken once for the whole batch, and the misses are read in with one
+   * sorted pass over the file. Every page that is returned is pinned once per occurrence in page_ids.
+   * @param page_ids ids of the pages to be fetched; asking for more pages than the pool holds gets some nullptrs
+   * @return the requested pages in the order of page_ids, nullptr for a page that could not be fetched
+   */
+  virtual std::vector<Page *> FetchPages(const std::vector<page_id_t> &page_ids);
+
+  /**
+   * Unpins several pages at once, taking the latch once for the whole batch.
+   * @param pages ids of the pages to be unpinned, each with true if the page should be marked as dirty
+   * @return false if any of the pages was not pinned, true otherwise
+   */
+  virtual bool UnpinPages(const std::vector<std::pair<page_id_t, bool>> &pages);
+
+  /** @return pointer to all the pages in the buffer pool, nullptr if the pool is split into shards */
   Page *GetPages() { return pages_; }
 
   /** @return size of the buffer pool */
   size_t GetPoolSize() { return pool_size_; }
 
+  /** @return the size the buffer pool can grow to */
+  size_t GetMaxPoolSize() { return max_pool_size_; }
+
+  /**
+   * Grows or shrinks the buffer pool while it is in use. Growing adds frames to the free list. Shrinking writes back
+   * and retires the frames above the new size; a frame that is pinned is waited for up to buffer_pool_resize_timeout
+   * and kept if it is still pinned then, so pages that are in use stay valid throughout. The memory of retired frames
+   * is given back to the system.
+   * @param new_size the requested number of frames, clamped to [1, GetMaxPoolSize()]
+   * @return the size of the buffer pool now, larger than requested if pinned frames kept it from shrinking further
+   */
+  virtual size_t Resize(size_t new_size);
+
+  /** @return how the frames of the buffer pool are backed, see enable_hugepage_frames */
+  virtual FrameArena::Mode GetFrameArenaMode() { return frame_arena_->GetMode(); }
+
+  /**
+   * Starts a background thread that writes dirty, unpinned pages back to disk ahead of eviction, so that victims picked
+   * by FetchPage and NewPage are usually clean. The cleaner wakes up every page_cleaner_interval.
+   * @param dirty_high_watermark the cleaner starts writing once this fraction of the frames is dirty
+   * @param dirty_low_watermark the cleaner stops writing once the dirty fraction has dropped to this
+   * @param max_pages_per_second upper bound on the write rate of the cleaner, 0 = unlimited
+   */
+  virtual void RunPageCleaner(double dirty_high_watermark, double dirty_low_watermark, size_t max_pages_per_second);
+
+  /**
+   * Stops and joins the page cleaner thread, if it is running.
+   */
+  virtual void StopPageCleaner();
+
+  /**
+   * Asks the buffer pool to read a chain of pages in the background, so that a scan that walks the chain later finds
+   * them in memory. This is only a hint: it returns immediately, and the request is dropped if too many are queued.
+   * @param page_id id of the first page of the chain
+   * @param count the number of pages to read ahead, capped at a quarter of the pool size
+   * @param next_page_id reads the id of the next page of the chain from the data of a page
+   */
+  void PrefetchPages(page_id_t page_id, size_t count, next_page_id_fn next_page_id);
+
+  /** @return the number of dirty victims written back by FetchPage and NewPage on the caller's thread */
+  virtual size_t GetForegroundWriteCount() { return foreground_writes_; }
+
+  /** @return the number of dirty pages written back by the page cleaner */
+  virtual size_t GetBackgroundWriteCount() { return background_writes_; }
+
+  /**
+   * @return a snapshot of the statistics of this buffer pool; the counters other than the write-backs only move while
+   * enable_buffer_pool_stats is set
+   */
+  virtual BufferPoolStats GetStats();
+
  protected:
+  // flushes the pages of all its shards at once
+  friend class ParallelBufferPoolManager;
+
+  /**
+   * Creates a BufferPoolManager that owns no frames of its own. Used by managers that forward to other instances.
+   * @param disk_manager the disk manager
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   */
+  BufferPoolManager(DiskManager *disk_manager, LogManager *log_manager);
+
   /**
    * Grading function. Do not modify!
    * Invokes the callback function if it is not null.
@@ -114,9 +260,9 @@ class BufferPoolManager {
   /**
    * Fetch the requested page from the buffer pool.
    * @param page_id id of page to be fetched
-   * @return the requested page
+   * @return the requested page, nullptr if no frame was free or the page failed to read, e.g. its checksum
    */
-  Page *FetchPageImpl(page_id_t page_id);
+  virtual Page *FetchPageImpl(page_id_t page_id);
 
   /**
    * Unpin the target page from the buffer pool.
@@ -124,50 +270,261 @@ class BufferPoolManager {
    * @param is_dirty true if the page should be marked as dirty, false otherwise
    * @return false if the page pin count is <= 0 before this call, true otherwise
    */
-  bool UnpinPageImpl(page_id_t page_id, bool is_dirty);
+  virtual bool UnpinPageImpl(page_id_t page_id, bool is_dirty);
 
   /**
    * Flushes the target page to disk.
    * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
    * @return false if the page could not be found in the page table, true otherwise
    */
-  bool FlushPageImpl(page_id_t page_id);
+  virtual bool FlushPageImpl(page_id_t page_id);
 
   /**
    * Creates a new page in the buffer pool.
    * @param[out] page_id id of created page
    * @return nullptr if no new pages could be created, otherwise pointer to new page
    */
-  Page *NewPageImpl(page_id_t *page_id);
+  virtual Page *NewPageImpl(page_id_t *page_id);
 
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
    * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
    */
-  bool DeletePageImpl(page_id_t page_id);
+  virtual bool DeletePageImpl(page_id_t page_id);
 
   /**
    * Flushes all the pages in the buffer pool to disk.
    */
-  void FlushAllPagesImpl();
+  virtual void FlushAllPagesImpl();
 
-  /** Number of pages in the buffer pool. */
-  size_t pool_size_;
-  /** Array of buffer pool pages. */
+  /**
+   * Allocates a page id for a new page from the disk manager, which reuses deallocated pages. A shard only takes the
+   * ids of its own residue class so that ParallelBufferPoolManager can route any page id back to the shard that
+   * created it. Must be called with latch_ held.
+   * @return the id of the allocated page
+   */
+  page_id_t AllocatePage();
+
+  /**
+   * Takes a frame from the free list, or evicts one through the replacer if the free list is empty. The frame is
+   * returned claimed, see TryClaimFrame.
+   * Must be called with latch_ held.
+   * @param[out] frame_id the frame to reuse
+   * @return false if every frame is pinned, true otherwise
+   */
+  bool FindReplacementFrame(frame_id_t *frame_id);
+
+  /**
+   * Unpins a page. Must be called with latch_ held.
+   * @param page_id id of page to be unpinned
+   * @param is_dirty true if the page should be marked as dirty
+   * @return false if the page pin count is <= 0 before this call, true otherwise
+   */
+  bool UnpinPageLatched(page_id_t page_id, bool is_dirty);
+
+  /**
+   * Fetches a resident page without latch_. Pins the frame the page table maps the page to with an atomic increment,
+   * then checks that the frame still holds the page; the pin keeps it from being claimed from then on.
+   * @param page_id id of page to be fetched
+   * @return the pinned page, nullptr if the caller has to fall back to the latched path
+   */
+  Page *TryFetchPageOptimistic(page_id_t page_id);
+
+  /**
+   * Unpins a page without latch_.
+   * @param page_id id of page to be unpinned
+   * @param is_dirty true if the page should be marked as dirty
+   * @return false if the caller has to fall back to the latched path, true if the page was unpinned
+   */
+  bool TryUnpinPageOptimistic(page_id_t page_id, bool is_dirty);
+
+  /**
+   * Takes back a pin that TryFetchPageOptimistic took on a frame that turned out not to hold the page.
+   * @param frame_id the frame
+   */
+  void DropOptimisticPin(frame_id_t frame_id);
+
+  /**
+   * Gives up a frame whose page failed to read in, with latch_ held and before is_io_in_progress_ is cleared. The
+   * page leaves the page table, so no later fetch gets the bytes that were read.
+   * @param page the frame
+   */
+  void DiscardFailedRead(Page *page);
+
+  /**
+   * Takes back the pin of a fetcher whose page failed to read in, with latch_ held. The frame no longer holds a
+   * page, so the last pin to go puts it back on the free list.
+   * @param frame_id the frame
+   */
+  void DropPinOfFailedRead(frame_id_t frame_id);
+
+  /**
+   * Picks the pages that FlushAllPagesImpl writes, pinning their frames and marking them busy until EndFlushAll. Their
+   * dirty flags are cleared, so that a page dirtied while it is being written stays dirty.
+   * @param[out] writes the pages to write and their data
+   * @param[out] flushed the frames of the pages, each with whether its page was dirty
+   * @return the largest LSN of the pages, up to which the log must be flushed before they are written
+   */
+  lsn_t BeginFlushAll(std::vector<std::pair<page_id_t, const char *>> *writes,
+                      std::vector<std::pair<frame_id_t, bool>> *flushed);
+
+  /**
+   * Releases the frames that BeginFlushAll picked once their pages have been written.
+   * @param flushed the frames that BeginFlushAll returned
+   * @param written for each of them, false if its write failed, which leaves a dirty page dirty
+   */
+  void EndFlushAll(const std::vector<std::pair<frame_id_t, bool>> &flushed, const std::vector<bool> &written);
+
+  /**
+   * Finishes the flush of a frame that FlushPageImpl or FlushAllPagesImpl pinned and marked busy, with latch_ held.
+   * The caller notifies io_cv_ once it releases latch_.
+   * @param frame_id the frame
+   * @param written false if the write failed, which leaves the page dirty
+   */
+  void EndFlush(frame_id_t frame_id, bool written);
+
+  /**
+   * Claims an unpinned frame before reassigning it, so that latch-free fetchers cannot pin it until it is released.
+   * Must be called with latch_ held, and the frame must be released before latch_ is.
+   * @param page the frame
+   * @return false if the frame is pinned, true otherwise
+   */
+  static bool TryClaimFrame(Page *page) {
+    int unpinned = 0;
+    return page->pin_count_.compare_exchange_strong(unpinned, CLAIMED_PIN_COUNT);
+  }
+
+  /**
+   * Releases a claimed frame. Latch-free fetchers that bumped the pin count meanwhile take their pins back themselves.
+   * @param page the frame
+   * @param pin_count the pin count of the frame from now on
+   */
+  static void ReleaseFrame(Page *page, int pin_count) { page->pin_count_ += pin_count - CLAIMED_PIN_COUNT; }
+
+  /**
+   * Sets the dirty flag of a frame and keeps num_dirty_frames_ in sync. The caller must hold latch_, a pin or a claim.
+   * @param page the frame
+   * @param is_dirty the new value of the dirty flag
+   */
+  void SetDirtyFlag(Page *page, bool is_dirty);
+
+  /**
+   * Enforces the write-ahead rule before dirty pages are written: waits until the log is on disk up to lsn, the
+   * largest page LSN among them. It only waits on the log manager, never on this buffer pool.
+   */
+  void FlushLogUntil(lsn_t lsn);
+
+  /**
+   * Body of the page cleaner thread.
+   */
+  void PageCleanerLoop();
+
+  /**
+   * Advances the cleaner hand to the next dirty frame that nobody is using. Must be called with latch_ held.
+   * @param[out] frame_id the frame to write back
+   * @return false if there is no such frame, true otherwise
+   */
+  bool FindFrameToClean(frame_id_t *frame_id);
+
+  /**
+   * Body of the prefetch thread.
+   */
+  void PrefetchLoop();
+
+  /**
+   * Stops and joins the prefetch thread, if it is running. Managers that forward to other instances must call this
+   * before destroying them, because the prefetch thread fetches pages through the virtual FetchPageImpl.
+   */
+  void StopPrefetchThread();
+
+  /** Pin count of a claimed frame. Far enough below zero that concurrent latch-free pins never make it non-negative. */
+  static constexpr int CLAIMED_PIN_COUNT = std::numeric_limits<int>::min() / 2;
+
+  /** Number of frames in use. Frames pool_size_ .. max_pool_size_ - 1 exist but are retired, see Resize. */
+  std::atomic<size_t> pool_size_;
+  /**
+   * Number of frames the buffer pool can grow to. The frame book-keeping, the page table and the replacer are sized
+   * for it up front, so that latch-free readers never see them move.
+   */
+  size_t max_pool_size_;
+  /** Array of buffer pool pages. Only holds the book-keeping; frame i's data lives in frame_arena_. */
   Page *pages_;
+  /** The data of all the frames, nullptr if the pool is split into shards. */
+  FrameArena *frame_arena_ = nullptr;
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
   /** Pointer to the log manager. */
-  LogManager *log_manager_ __attribute__((__unused__));
+  LogManager *log_manager_;
+  /** Number of shards the page id space is split into, 1 for a standalone instance. */
+  const uint32_t num_instances_ = 1;
+  /** Index of this shard. */
+  const uint32_t instance_index_ = 0;
+  /** True if the disk manager is READ_ONLY and the frames point into its mapping instead of frame_arena_. */
+  const bool read_only_ = false;
   /** Page table for keeping track of buffer pool pages. */
-  std::unordered_map<page_id_t, frame_id_t> page_table_;
+  PageTable page_table_;
   /** Replacer to find unpinned pages for replacement. */
   Replacer *replacer_;
   /** List of free pages. */
   // what's the purpose of free list?
   std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
+  /** Ids of dirty pages that were evicted and are still being written back, fetching them must wait. */
+  std::unordered_set<page_id_t> evicting_pages_;
+  /**
+   * This latch protects the page table, the free list, evicting_pages_ and the book-keeping fields of the frames.
+   * It is not held during disk I/O; a frame whose I/O is in flight is pinned and flagged instead. Hits may pin and
+   * unpin a frame without it, which is why a frame is claimed before it is reassigned.
+   */
   std::mutex latch_;
+  /** Signalled whenever a frame finishes its I/O. */
+  std::condition_variable io_cv_;
+  /** Number of frames whose dirty flag is set. */
+  std::atomic<size_t> num_dirty_frames_{0};
+
+  /** The page cleaner thread, nullptr if it is not running. */
+  std::thread *page_cleaner_thread_ = nullptr;
+  /** True while the page cleaner should keep running. Protected by latch_. */
+  bool page_cleaner_running_ = false;
+  /** Wakes the page cleaner up early, e.g. to stop it. */
+  std::condition_variable page_cleaner_cv_;
+  /** Watermarks of the page cleaner as fractions of the pool size, kept to rescale the counts below on Resize. */
+  double cleaner_high_watermark_ = 0;
+  double cleaner_low_watermark_ = 0;
+  /** The cleaner starts writing when more than this many frames are dirty. */
+  size_t cleaner_high_dirty_frames_ = 0;
+  /** The cleaner stops writing when at most this many frames are dirty. */
+  size_t cleaner_low_dirty_frames_ = 0;
+  /** Maximum number of pages the cleaner writes per page_cleaner_interval, 0 = unlimited. */
+  size_t cleaner_pages_per_interval_ = 0;
+  /** The next frame the cleaner looks at. */
+  size_t cleaner_hand_ = 0;
+  /** Dirty victims written back on the eviction path of FetchPage and NewPage. */
+  std::atomic<size_t> foreground_writes_{0};
+  /** Dirty pages written back by the page cleaner. */
+  std::atomic<size_t> background_writes_{0};
+  /** Hits, misses and latencies, see GetStats. */
+  BufferPoolStatsCollector stats_;
+
+  /** A pending PrefetchPages call. */
+  struct PrefetchRequest {
+    page_id_t page_id_;
+    size_t count_;
+    next_page_id_fn next_page_id_;
+  };
+  /** Maximum number of pending prefetch requests, further hints are dropped. */
+  static constexpr size_t MAX_PREFETCH_REQUESTS = 16;
+  /** The prefetch thread, started by the first PrefetchPages call. */
+  std::thread *prefetch_thread_ = nullptr;
+  /** True once the prefetch thread has been asked to stop. Protected by prefetch_latch_. */
+  bool prefetch_stopping_ = false;
+  /** Pending prefetch requests, oldest first. Protected by prefetch_latch_. */
+  std::deque<PrefetchRequest> prefetch_queue_;
+  /** Serializes Resize calls, which drop latch_ while they write back retiring frames. */
+  std::mutex resize_latch_;
+  /** Protects the prefetch queue. Never held together with latch_. */
+  std::mutex prefetch_latch_;
+  /** Wakes the prefetch thread up when a request is queued or it should stop. */
+  std::condition_variable prefetch_cv_;
 };
 }  // namespace bustub
@@ -0,0 +1,180 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.h
+//
+// Identification: src/include/buffer/buffer_pool_stats.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <string>
+
+namespace bustub {
+
+/**
+ * LatencyHistogram counts latencies in power-of-two buckets: bucket i holds the latencies in [2^i, 2^(i+1)) ns, and
+ * bucket 0 also holds 0 ns. The last bucket is open-ended.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr size_t NUM_BUCKETS = 40;
+
+  /** @return the bucket a latency falls into */
+  static size_t BucketOf(uint64_t nanos) {
+    size_t bucket = 0;
+    while (nanos > 1 && bucket < NUM_BUCKETS - 1) {
+      nanos >>= 1;
+      bucket++;
+    }
+    return bucket;
+  }
+
+  /** Adds count latencies to a bucket. */
+  void Add(size_t bucket, uint64_t count) {
+    buckets_[bucket] += count;
+    count_ += count;
+  }
+
+  /** Adds the latencies of another histogram to this one. */
+  void Merge(const LatencyHistogram &other);
+
+  /** @return the number of recorded latencies */
+  uint64_t GetCount() const { return count_; }
+
+  /** @return the number of latencies in a bucket */
+  uint64_t GetBucket(size_t bucket) const { return buckets_[bucket]; }
+
+  /**
+   * @param percentile a value in [0, 100]
+   * @return an upper bound of the given percentile in ns, i.e. the end of the bucket it falls into, 0 if empty
+   */
+  uint64_t GetPercentile(double percentile) const;
+
+ private:
+  std::array<uint64_t, NUM_BUCKETS> buckets_{};
+  uint64_t count_ = 0;
+};
+
+/**
+ * BufferPoolStats is a snapshot of the activity of a buffer pool since it was created.
+ */
+struct BufferPoolStats {
+  /** FetchPage calls that found the page in the pool. */
+  uint64_t hits_ = 0;
+  /** FetchPage calls that had to read the page from disk. */
+  uint64_t misses_ = 0;
+  /** Pages created by NewPage. */
+  uint64_t new_pages_ = 0;
+  /** FetchPage and NewPage calls that failed because every frame was pinned. */
+  uint64_t no_free_frames_ = 0;
+  /** Frames taken from the replacer, i.e. pages evicted to make room for another one. */
+  uint64_t evictions_ = 0;
+  /** Dirty victims written back by FetchPage and NewPage. */
+  uint64_t foreground_write_backs_ = 0;
+  /** Dirty pages written back by the page cleaner. */
+  uint64_t background_write_backs_ = 0;
+  /** FetchPage calls that had to wait for another thread's I/O on the page. */
+  uint64_t pin_waits_ = 0;
+  /** Time FetchPage spends on a miss, from picking the victim to having the page in memory. */
+  LatencyHistogram miss_latency_;
+  /** Time it takes to write a dirty victim back. */
+  LatencyHistogram write_back_latency_;
+
+  /** @return the fraction of fetches that were hits, 0 if there were none */
+  double HitRatio() const {
+    uint64_t fetches = hits_ + misses_;
+    return fetches == 0 ? 0 : static_cast<double>(hits_) / static_cast<double>(fetches);
+  }
+
+  /** Adds the activity of another buffer pool, e.g. another shard, to this snapshot. */
+  void Merge(const BufferPoolStats &other);
+
+  /** @return a one-line summary for logs */
+  std::string ToString() const;
+};
+
+/**
+ * BufferPoolStatsCollector gathers the statistics of one buffer pool.
+ *
+ * Threads record into one of NUM_SHARDS cache-line-aligned shards of relaxed atomic counters, picked once per thread,
+ * so recording never contends on a shared cache line in the common case. A snapshot sums the shards.
+ * Recording is skipped while enable_buffer_pool_stats is false.
+ */
+class BufferPoolStatsCollector {
+ public:
+  enum class Counter : size_t {
+    HITS,
+    MISSES,
+    NEW_PAGES,
+    NO_FREE_FRAMES,
+    EVICTIONS,
+    PIN_WAITS,
+    NUM_COUNTERS
+  };
+
+  /** @return true if statistics should be recorded */
+  static bool Enabled();
+
+  /** Starts a latency measurement, returns the epoch if statistics are disabled so the clock is not read. */
+  static std::chrono::steady_clock::time_point StartTimer() {
+    return Enabled() ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+  }
+
+  /** Counts an event. */
+  void Increment(Counter counter) {
+    if (Enabled()) {
+      LocalShard().counters_[static_cast<size_t>(counter)].fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  /** Records the latency of a miss that started at start, which must come from StartTimer. */
+  void RecordMissLatency(std::chrono::steady_clock::time_point start) {
+    Record(&Shard::miss_latency_, start);
+  }
+
+  /** Records the latency of a write-back that started at start, which must come from StartTimer. */
+  void RecordWriteBackLatency(std::chrono::steady_clock::time_point start) {
+    Record(&Shard::write_back_latency_, start);
+  }
+
+  /** @return the sum of all the shards, the write-back counts are left for the buffer pool to fill in */
+  BufferPoolStats Snapshot() const;
+
+ private:
+  static constexpr size_t NUM_SHARDS = 16;
+  static constexpr size_t NUM_COUNTERS = static_cast<size_t>(Counter::NUM_COUNTERS);
+  using AtomicHistogram = std::array<std::atomic<uint64_t>, LatencyHistogram::NUM_BUCKETS>;
+
+  struct alignas(64) Shard {
+    std::array<std::atomic<uint64_t>, NUM_COUNTERS> counters_{};
+    AtomicHistogram miss_latency_{};
+    AtomicHistogram write_back_latency_{};
+  };
+
+  /** @return the shard of the calling thread */
+  Shard &LocalShard() { return shards_[ShardIndex()]; }
+
+  /** @return the shard index of the calling thread, assigned round-robin the first time a thread records */
+  static size_t ShardIndex();
+
+  void Record(AtomicHistogram Shard::*histogram, std::chrono::steady_clock::time_point start) {
+    if (start == std::chrono::steady_clock::time_point{}) {
+      return;
+    }
+    auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    (LocalShard().*histogram)[LatencyHistogram::BucketOf(nanos.count())].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  std::array<Shard, NUM_SHARDS> shards_;
+};
+
+}  // namespace bustub
@@ -12,7 +12,6 @@
 
 #pragma once
 
-#include <list>
 #include <mutex>  // NOLINT
 #include <vector>
 
@@ -46,7 +45,16 @@ class ClockReplacer : public Replacer {
   size_t Size() override;
 
  private:
-  // TODO(student): implement me!
+  // true if the frame is in the replacer, i.e. it can be victimized
+  std::vector<bool> in_replacer_;
+  // reference bit of every frame, set on unpin and cleared when the clock hand passes
+  std::vector<bool> ref_;
+  // the frame the clock hand points to
+  size_t hand_ = 0;
+  // number of frames in the replacer
+  size_t size_ = 0;
+
+  std::mutex latch_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,78 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.h
+//
+// Identification: src/include/buffer/frame_arena.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * FrameArena is one mmap'd region that holds the data of every frame of a buffer pool.
+ *
+ * Frames are PAGE_SIZE apart and the region is page aligned, so every frame can be handed to the kernel for direct
+ * I/O. When hugepages are requested the arena first asks for explicit hugepages (MAP_HUGETLB), then for transparent
+ * hugepages (MADV_HUGEPAGE), and falls back to regular pages if neither is available.
+ *
+ * An arena of regular or transparent hugepages only takes memory for the frames that are used, so a buffer pool that
+ * may grow maps one for its largest size up front and releases frames again when it shrinks.
+ */
+class FrameArena {
+ public:
+  /** How the memory of an arena is backed. */
+  enum class Mode { REGULAR_PAGES, TRANSPARENT_HUGEPAGES, HUGETLB_PAGES };
+
+  /**
+   * Maps a zeroed arena.
+   * @param num_frames the number of frames
+   * @param use_hugepages true to try to back the arena with hugepages
+   * @throws Exception if the memory cannot be mapped at all
+   */
+  FrameArena(size_t num_frames, bool use_hugepages);
+
+  /**
+   * Unmaps the arena.
+   */
+  ~FrameArena();
+
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+
+  /** @return the data of a frame */
+  char *GetFrame(frame_id_t frame_id) { return data_ + static_cast<size_t>(frame_id) * PAGE_SIZE; }
+
+  /**
+   * Gives the memory of a range of frames back to the system. The frames stay mapped and read as zeroes when they are
+   * used again. With explicit hugepages only the hugepages that lie entirely within the range are released.
+   * @param first_frame the first frame of the range
+   * @param num_frames the number of frames in the range
+   */
+  void Release(frame_id_t first_frame, size_t num_frames);
+
+  /** @return how the arena is backed */
+  Mode GetMode() const { return mode_; }
+
+  /** @return a printable name of a mode */
+  static const char *ModeToString(Mode mode);
+
+  /** Size of a hugepage; the arena is rounded up to a multiple of it when hugepages are requested. */
+  static constexpr size_t HUGEPAGE_SIZE = 2 * 1024 * 1024;
+
+ private:
+  char *data_ = nullptr;
+  size_t mapped_size_ = 0;
+  Mode mode_ = Mode::REGULAR_PAGES;
+};
+
+}  // namespace bustub
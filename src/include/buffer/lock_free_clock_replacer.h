@@ -0,0 +1,71 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lock_free_clock_replacer.h
+//
+// Identification: src/include/buffer/lock_free_clock_replacer.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * LockFreeClockReplacer implements the clock replacement policy without a latch.
+ *
+ * Every frame has one atomic state byte holding its evictable and reference bits, so Pin and Unpin are a single
+ * atomic read-modify-write. Victim advances a shared clock hand with fetch_add and claims a frame by compare-and-swap,
+ * which lets several threads sweep the clock at the same time.
+ */
+class LockFreeClockReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LockFreeClockReplacer.
+   * @param num_pages the maximum number of pages the LockFreeClockReplacer will be required to store
+   */
+  explicit LockFreeClockReplacer(size_t num_pages);
+
+  /**
+   * Destroys the LockFreeClockReplacer.
+   */
+  ~LockFreeClockReplacer() override;
+
+  /**
+   * Finds a victim. Victim keeps sweeping the clock as long as some frame is evictable, so it only returns false if
+   * none is.
+   */
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  size_t Size() override;
+
+ private:
+  // the frame can be victimized
+  static constexpr uint8_t EVICTABLE = 1;
+  // the frame was unpinned since the clock hand last passed it
+  static constexpr uint8_t REF = 2;
+
+  const size_t num_pages_;
+  // state bits of every frame, indexed by frame id
+  std::unique_ptr<std::atomic<uint8_t>[]> states_;
+  // the clock hand, taken modulo num_pages_
+  std::atomic<size_t> hand_{0};
+  // number of evictable frames; signed because a victim may be claimed before the unpin that made it evictable
+  // has counted it
+  std::atomic<int64_t> size_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,95 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.h
+//
+// Identification: src/include/buffer/lru_k_replacer.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <deque>
+#include <mutex>  // NOLINT
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ *
+ * The victim is the frame whose K-th most recent reference lies furthest in the past. Frames with fewer than K
+ * references have an infinite backward K-distance and are evicted first, oldest first reference first. A page that a
+ * sequential scan touches once therefore cannot push out pages that are referenced over and over, like the inner
+ * pages of a B+ tree.
+ *
+ * Every Pin counts as an access. Accesses that follow the start of the current burst of accesses to a frame within
+ * the correlated reference period count as one reference, so that a scan which fetches the same page once per tuple
+ * does not make that page look hot.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k the number of references the backward distance is computed over
+   * @param correlated_reference_period accesses to a frame within this many accesses (to any frame) of the start of
+   * its current burst count as the same reference
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = 2, size_t correlated_reference_period = 32);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override = default;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  size_t Size() override;
+
+ private:
+  /** Reference history of one frame. */
+  struct FrameHistory {
+    /** Logical times of the last (at most) k references, oldest first. */
+    std::deque<size_t> references_;
+    /** True if the frame can be victimized. */
+    bool evictable_ = false;
+  };
+
+  /** @return the key the frame is ordered by in history_ or cache_. Must hold latch_. */
+  std::pair<size_t, frame_id_t> EvictionKey(frame_id_t frame_id) {
+    return {frames_[frame_id].references_.front(), frame_id};
+  }
+
+  /** @return the set the frame belongs into while it is evictable. Must hold latch_. */
+  std::set<std::pair<size_t, frame_id_t>> *EvictionSet(frame_id_t frame_id) {
+    return frames_[frame_id].references_.size() < k_ ? &history_ : &cache_;
+  }
+
+  const size_t k_;
+  const size_t correlated_reference_period_;
+  /** Logical clock, advanced on every access. */
+  size_t current_timestamp_ = 0;
+  std::vector<FrameHistory> frames_;
+  /** Evictable frames with fewer than k references, by time of their first reference. */
+  std::set<std::pair<size_t, frame_id_t>> history_;
+  /** Evictable frames with k references, by time of their k-th most recent reference. */
+  std::set<std::pair<size_t, frame_id_t>> cache_;
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -12,26 +12,19 @@
 
 #pragma once
 
-#include <list>
-#include <memory>
 #include <mutex>  // NOLINT
-#include <unordered_map>
 #include <vector>
 
 #include "buffer/replacer.h"
 #include "common/config.h"
 
 namespace bustub {
-// double linked list structure
-struct Linked_list {
-  frame_id_t data = 0;
 
-  std::shared_ptr<Linked_list> left = nullptr, right = nullptr;
-  Linked_list() = default;
-  explicit Linked_list(frame_id_t p) { data = p; }
-};
 /**
  * LRUReplacer implements the lru replacement policy, which approximates the Least Recently Used policy.
+ *
+ * Frame ids are dense, so the lru list is intrusive: the links of frame i live at index i of two fixed arrays, and
+ * index num_pages is the sentinel. Pin, Unpin and Victim are O(1) and never allocate.
  */
 class LRUReplacer : public Replacer {
  public:
@@ -55,28 +48,34 @@ class LRUReplacer : public Replacer {
   size_t Size() override;
 
  private:
-  // TODO(student): implement me!
-
-  // capacity
-  size_t _capacity = 0;
+  // remove a frame from the list
+  void RemoveNode(frame_id_t frame_id) {
+    next_[prev_[frame_id]] = next_[frame_id];
+    prev_[next_[frame_id]] = prev_[frame_id];
+    prev_[frame_id] = next_[frame_id] = INVALID_FRAME;
+  }
+  // push a frame to the back, i.e. the most recently used end
+  void PushBack(frame_id_t frame_id) {
+    prev_[frame_id] = prev_[sentinel_];
+    next_[frame_id] = sentinel_;
+    next_[prev_[sentinel_]] = frame_id;
+    prev_[sentinel_] = frame_id;
+  }
+  // a frame is in the list iff its links are set
+  bool InList(frame_id_t frame_id) { return next_[frame_id] != INVALID_FRAME; }
 
-  std::shared_ptr<Linked_list> front = nullptr, rear = nullptr;
+  static constexpr frame_id_t INVALID_FRAME = -1;
 
-  std::unordered_map<frame_id_t, std::shared_ptr<Linked_list>> map;
+  // index of the sentinel node, the front of the list is next_[sentinel_] and the back is prev_[sentinel_]
+  const frame_id_t sentinel_;
+  // previous frame in the list, indexed by frame id
+  std::vector<frame_id_t> prev_;
+  // next frame in the list, indexed by frame id
+  std::vector<frame_id_t> next_;
+  // number of frames in the list
+  size_t size_ = 0;
 
   std::mutex latch_;
-  // remove from list but not delete
-  void RemoveNode(const std::shared_ptr<Linked_list> &node) {
-    node->left->right = node->right;
-    node->right->left = node->left;
-  }
-  // push a node to the back
-  void PushBack(const std::shared_ptr<Linked_list> &node) {
-    node->left = rear->left;
-    rear->left->right = node;
-    node->right = rear;
-    rear->left = node;
-  }
 };
 
 }  // namespace bustub
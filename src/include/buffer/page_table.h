@@ -0,0 +1,117 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.h
+//
+// Identification: src/include/buffer/page_table.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * PageTable maps the ids of the pages in a buffer pool to their frames.
+ *
+ * It is an open-addressing hash table with linear probing and a fixed capacity of at least twice the number of
+ * frames, so it never grows and probes stay short. Every slot is one atomic 64-bit word holding both the page id and
+ * the frame id, so eight slots share a cache line and a reader always sees a consistent pair.
+ *
+ * Insert and Erase must be serialized by the caller, e.g. by the buffer pool latch. Find may run concurrently with
+ * them without any latch: it then returns either a mapping that existed at some point during the call or nothing, so
+ * a latch-free caller has to check that the frame still holds the page and fall back to a latched lookup on a miss.
+ */
+class PageTable {
+ public:
+  /**
+   * Creates an empty page table.
+   * @param num_frames the number of frames of the buffer pool, the table never holds more entries than that
+   */
+  explicit PageTable(size_t num_frames);
+
+  /**
+   * Looks a page up. Safe to call without serializing with writers, see above.
+   * @param page_id the page to look up
+   * @param[out] frame_id the frame holding the page
+   * @return true if the page was found
+   */
+  bool Find(page_id_t page_id, frame_id_t *frame_id) const {
+    for (size_t slot = SlotOf(page_id), probes = 0; probes < capacity_; slot = (slot + 1) & mask_, ++probes) {
+      uint64_t entry = slots_[slot].load(std::memory_order_acquire);
+      if (entry == EMPTY) {
+        return false;
+      }
+      if (PageIdOf(entry) == page_id) {
+        *frame_id = FrameIdOf(entry);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Maps a page to a frame, replacing the frame it was mapped to before, if any.
+   * @param page_id the page, cannot be INVALID_PAGE_ID
+   * @param frame_id the frame holding the page
+   */
+  void Insert(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * Removes a page from the table.
+   * @param page_id the page to remove
+   * @return false if the page was not in the table
+   */
+  bool Erase(page_id_t page_id);
+
+  /** @return the number of pages in the table */
+  size_t Size() const { return size_; }
+
+  /**
+   * Calls f(page_id, frame_id) for every page in the table. Must be serialized with writers.
+   */
+  template <typename F>
+  void ForEach(F &&f) const {
+    for (size_t slot = 0; slot < capacity_; ++slot) {
+      uint64_t entry = slots_[slot].load(std::memory_order_relaxed);
+      if (entry != EMPTY) {
+        f(PageIdOf(entry), FrameIdOf(entry));
+      }
+    }
+  }
+
+ private:
+  /** An empty slot, i.e. INVALID_PAGE_ID mapped to frame -1. */
+  static constexpr uint64_t EMPTY = ~uint64_t{0};
+
+  static uint64_t MakeEntry(page_id_t page_id, frame_id_t frame_id) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32) | static_cast<uint32_t>(frame_id);
+  }
+  static page_id_t PageIdOf(uint64_t entry) { return static_cast<page_id_t>(entry >> 32); }
+  static frame_id_t FrameIdOf(uint64_t entry) { return static_cast<frame_id_t>(entry & 0xFFFFFFFF); }
+
+  /** @return the home slot of a page; Fibonacci hashing spreads the consecutive ids of a file over the table */
+  size_t SlotOf(page_id_t page_id) const {
+    return static_cast<size_t>((static_cast<uint32_t>(page_id) * 0x9E3779B97F4A7C15ULL) >> shift_);
+  }
+
+  /** @return the slot holding a page, or capacity_ if it is not in the table */
+  size_t FindSlot(page_id_t page_id) const;
+
+  size_t capacity_;
+  size_t mask_;
+  unsigned shift_;
+  size_t size_ = 0;
+  std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,108 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.h
+//
+// Identification: src/include/buffer/parallel_buffer_pool_manager.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * ParallelBufferPoolManager splits the buffer pool into several independent BufferPoolManager shards, each with its
+ * own latch, page table, free list and replacer. A page always lives in the shard given by page_id % num_instances, so
+ * threads working on different pages rarely contend on the same latch.
+ */
+class ParallelBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * Creates a new ParallelBufferPoolManager.
+   * @param num_instances the number of shards
+   * @param pool_size the size of each shard
+   * @param disk_manager the disk manager
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy of every shard
+   * @param max_pool_size the size Resize may grow each shard to, 0 = pool_size
+   */
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                            LogManager *log_manager = nullptr, ReplacerType replacer_type = ReplacerType::LRU,
+                            size_t max_pool_size = 0);
+
+  /**
+   * Destroys an existing ParallelBufferPoolManager and all of its shards.
+   */
+  ~ParallelBufferPoolManager() override;
+
+  /**
+   * @param page_id id of the page
+   * @return the shard responsible for page_id
+   */
+  BufferPoolManager *GetBufferPoolManager(page_id_t page_id);
+
+  /** @return the number of shards */
+  size_t GetNumInstances() { return instances_.size(); }
+
+  /** Starts one page cleaner per shard, each applying the watermarks and its share of the rate to its own frames. */
+  void RunPageCleaner(double dirty_high_watermark, double dirty_low_watermark, size_t max_pages_per_second) override;
+
+  void StopPageCleaner() override;
+
+  size_t GetForegroundWriteCount() override;
+
+  size_t GetBackgroundWriteCount() override;
+
+  /** @return the statistics of all the shards added up */
+  BufferPoolStats GetStats() override;
+
+  /** Spreads the new size evenly over the shards. */
+  size_t Resize(size_t new_size) override;
+
+  /** Splits the batch by shard, so that every shard takes its latch once. */
+  std::vector<Page *> FetchPages(const std::vector<page_id_t> &page_ids) override;
+
+  bool UnpinPages(const std::vector<std::pair<page_id_t, bool>> &pages) override;
+
+  /** Every shard maps its own arena with the same setting, so the first shard speaks for all of them. */
+  FrameArena::Mode GetFrameArenaMode() override { return instances_[0]->GetFrameArenaMode(); }
+
+ protected:
+  Page *FetchPageImpl(page_id_t page_id) override;
+
+  bool UnpinPageImpl(page_id_t page_id, bool is_dirty) override;
+
+  bool FlushPageImpl(page_id_t page_id) override;
+
+  /**
+   * Creates a new page, asking the shards in round-robin order so that new pages spread evenly over the pool.
+   * @param[out] page_id id of created page
+   * @return nullptr if no shard could create a new page, otherwise pointer to new page
+   */
+  Page *NewPageImpl(page_id_t *page_id) override;
+
+  bool DeletePageImpl(page_id_t page_id) override;
+
+  void FlushAllPagesImpl() override;
+
+ private:
+  /** The shards, indexed by page_id % num_instances. */
+  std::vector<BufferPoolManager *> instances_;
+  /** The shard NewPage tries first on its next call. */
+  std::atomic<size_t> next_instance_{0};
+};
+
+}  // namespace bustub
@@ -43,6 +43,13 @@ class Replacer {
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Removes a frame and whatever the replacer knows about its past use, e.g. because its page was deleted.
+   * Replacers that keep no access history can simply pin it.
+   * @param frame_id the id of the frame to remove
+   */
+  virtual void Remove(frame_id_t frame_id) { Pin(frame_id); }
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
 };
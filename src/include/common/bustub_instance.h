@@ -32,7 +32,8 @@ class BustubInstance {
     // log related
     log_manager_ = new LogManager(disk_manager_);
 
-    buffer_pool_manager_ = new BufferPoolManager(BUFFER_POOL_SIZE, disk_manager_, log_manager_);
+    buffer_pool_manager_ = new BufferPoolManager(BUFFER_POOL_SIZE, disk_manager_, log_manager_,
+                                                 BufferPoolManager::ReplacerType::LRU, MAX_BUFFER_POOL_SIZE);
 
     // txn related
     lock_manager_ = new LockManager();
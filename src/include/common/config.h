@@ -14,6 +14,7 @@
 
 #include <atomic>
 #include <chrono>  // NOLINT
+#include <cstddef>
 #include <cstdint>
 
 namespace bustub {
@@ -27,14 +28,62 @@ extern std::atomic<bool> enable_logging;
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
 extern std::chrono::duration<int64_t> log_timeout;
 
+/** A running page cleaner checks the dirty ratio of its buffer pool every PAGE_CLEANER_INTERVAL milliseconds. */
+extern std::chrono::milliseconds page_cleaner_interval;
+
+/** True if buffer pools should back their frames with hugepages when the system has them. */
+extern std::atomic<bool> enable_hugepage_frames;
+
+/** True if buffer pools should record hit, miss and latency statistics, see BufferPoolManager::GetStats. */
+extern std::atomic<bool> enable_buffer_pool_stats;
+
+/** True if buffer pools should pin and unpin resident pages without taking their latch. */
+extern std::atomic<bool> enable_optimistic_pinning;
+
+/** A buffer pool that shrinks waits at most BUFFER_POOL_RESIZE_TIMEOUT for the frames it gives up to be unpinned. */
+extern std::chrono::milliseconds buffer_pool_resize_timeout;
+
+/** True if disk managers should run their asynchronous page I/O on io_uring when the kernel allows it. */
+extern std::atomic<bool> enable_io_uring;
+
+/**
+ * True if disk managers should open their db file with O_DIRECT, bypassing the page cache that only duplicates the
+ * buffer pool. Read when a disk manager is created.
+ */
+extern std::atomic<bool> enable_direct_io;
+
+/**
+ * What disk managers do with page checksums: OFF computes none, WRITE_ONLY keeps them up to date for the pages it
+ * writes, and VERIFY also checks every page it reads against its checksum, see DiskManager::GetNumChecksumFailures.
+ */
+enum class PageChecksumMode : uint8_t { OFF, WRITE_ONLY, VERIFY };
+extern std::atomic<PageChecksumMode> page_checksum_mode;
+
+/**
+ * True if disk managers should store the pages of a new db file LZ4-compressed, each in as many 512-byte sectors as
+ * it needs. Read when a disk manager opens an empty db file; a db file keeps the layout it was created with.
+ */
+extern std::atomic<bool> enable_page_compression;
+
+/**
+ * True if flushing a whole buffer pool should write its dirty pages as sorted runs followed by a single sync, one for
+ * all the shards of a parallel buffer pool. On by default; when it is off, every resident page is written.
+ */
+extern std::atomic<bool> enable_write_batching;
+
+/** A disk manager keeps at most DISK_IO_QUEUE_DEPTH asynchronous page reads and writes in flight. */
+extern size_t disk_io_queue_depth;
+
 static constexpr int INVALID_PAGE_ID = -1;                                    // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                     // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                        // invalid log sequence number
 static constexpr int HEADER_PAGE_ID = 0;                                      // the header page id
 static constexpr int PAGE_SIZE = 4096;                                        // size of a data page in byte
 static constexpr int BUFFER_POOL_SIZE = 10;                                   // size of buffer pool
+static constexpr int MAX_BUFFER_POOL_SIZE = 1024;                             // size the buffer pool may grow to
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                        // size of extendible hash bucket
+static constexpr int READ_AHEAD_PAGES = 8;                                    // pages a scan asks to read ahead
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
@@ -0,0 +1,41 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c.h
+//
+// Identification: src/include/common/util/crc32c.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bustub {
+
+/**
+ * CRC32C (Castagnoli) checksums. On x86-64 processors with SSE4.2 the crc32 instruction is used, which is picked at
+ * run time so the binary still runs on processors without it; everywhere else a table-driven software version is.
+ */
+class Crc32c {
+ public:
+  /**
+   * @param data the bytes to checksum
+   * @param length the number of bytes
+   * @param crc the checksum of the bytes before data, to checksum a buffer in pieces
+   * @return the CRC32C of the bytes
+   */
+  static uint32_t Compute(const void *data, size_t length, uint32_t crc = 0);
+
+  /** Same as Compute, but never uses the crc32 instruction. */
+  static uint32_t ComputeSoftware(const void *data, size_t length, uint32_t crc = 0);
+
+  /** @return true if Compute uses the crc32 instruction */
+  static bool IsHardwareAccelerated();
+};
+
+}  // namespace bustub
@@ -0,0 +1,50 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz4.h
+//
+// Identification: src/include/common/util/lz4.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bustub {
+
+/**
+ * Compression in the LZ4 block format: a block is a sequence of literal runs each followed by a copy of earlier
+ * output, which decompresses at memory speed. The compressor is a single pass with a hash table of recent positions,
+ * like LZ4's default level, and its output can be decompressed by any LZ4 implementation and vice versa.
+ */
+class Lz4 {
+ public:
+  /** @return the size of the largest block that input_size bytes may compress to */
+  static constexpr size_t CompressBound(size_t input_size) { return input_size + input_size / 255 + 16; }
+
+  /**
+   * @param src the bytes to compress, at most 2 GiB
+   * @param src_size the number of bytes
+   * @param[out] dst the compressed block
+   * @param dst_capacity the size of dst; CompressBound(src_size) always suffices
+   * @return the size of the compressed block, or 0 if it does not fit into dst_capacity bytes
+   */
+  static size_t Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity);
+
+  /**
+   * Decompresses a block. Malformed blocks are detected and never make it read or write out of bounds.
+   * @param src the compressed block
+   * @param src_size the size of the compressed block
+   * @param[out] dst the decompressed bytes
+   * @param dst_capacity the size of dst
+   * @return the number of decompressed bytes, or -1 if the block is malformed or does not fit into dst
+   */
+  static int64_t Decompress(const char *src, size_t src_size, char *dst, size_t dst_capacity);
+};
+
+}  // namespace bustub
@@ -18,10 +18,12 @@
 #include <string>
 #include <thread>  // NOLINT
 #include <unordered_set>
+#include <utility>
 
 #include "common/config.h"
 #include "common/logger.h"
 #include "storage/page/page.h"
+#include "storage/page/page_guard.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
@@ -159,7 +161,7 @@ class Transaction {
     // Initialize the sets that will be tracked.
     table_write_set_ = std::make_shared<std::deque<TableWriteRecord>>();
     index_write_set_ = std::make_shared<std::deque<IndexWriteRecord>>();
-    page_set_ = std::make_shared<std::deque<bustub::Page *>>();
+    page_set_ = std::make_shared<std::deque<WritePageGuard>>();
     deleted_page_set_ = std::make_shared<std::unordered_set<page_id_t>>();
   }
 
@@ -183,7 +185,7 @@ class Transaction {
   inline std::shared_ptr<std::deque<IndexWriteRecord>> GetIndexWriteSet() { return index_write_set_; }
 
   /** @return the page set */
-  inline std::shared_ptr<std::deque<Page *>> GetPageSet() { return page_set_; }
+  inline std::shared_ptr<std::deque<WritePageGuard>> GetPageSet() { return page_set_; }
 
   /**
    * Adds a tuple write record into the table write set.
@@ -203,9 +205,9 @@ class Transaction {
 
   /**
    * Adds a page into the page set.
-   * @param page page to be added
+   * @param page guard of the page to be added, which the page set takes over
    */
-  inline void AddIntoPageSet(Page *page) { page_set_->push_back(page); }
+  inline void AddIntoPageSet(WritePageGuard &&page) { page_set_->push_back(std::move(page)); }
 
   /** @return the deleted page set */
   inline std::shared_ptr<std::unordered_set<page_id_t>> GetDeletedPageSet() { return deleted_page_set_; }
@@ -263,8 +265,8 @@ class Transaction {
   /** The LSN of the last record written by the transaction. */
   lsn_t prev_lsn_;
 
-  /** Concurrent index: the pages that were latched during index operation. */
-  std::shared_ptr<std::deque<Page *>> page_set_;
+  /** Concurrent index: the pages that were latched during index operation, released when their guards go. */
+  std::shared_ptr<std::deque<WritePageGuard>> page_set_;
   /** Concurrent index: the page IDs that were deleted during index operation.*/
   std::shared_ptr<std::unordered_set<page_id_t>> deleted_page_set_;
 
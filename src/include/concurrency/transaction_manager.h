@@ -13,6 +13,7 @@
 #pragma once
 
 #include <atomic>
+#include <mutex>  // NOLINT
 #include <unordered_map>
 #include <unordered_set>
 
@@ -43,7 +44,7 @@ class TransactionManager {
   Transaction *Begin(Transaction *txn = nullptr, IsolationLevel isolation_level = IsolationLevel::REPEATABLE_READ);
 
   /**
-   * Commits a transaction.
+   * Commits a transaction. With logging enabled, it returns once the commit record is on disk.
    * @param txn the transaction to commit
    */
   void Commit(Transaction *txn);
@@ -60,6 +61,8 @@ class TransactionManager {
 
   /** The transaction map is a global list of all the running transactions in the system. */
   static std::unordered_map<txn_id_t, Transaction *> txn_map;
+  /** Protects txn_map from transactions that begin concurrently. */
+  static std::mutex txn_map_latch;
 
   /**
    * Locates and returns the transaction with the given transaction ID.
@@ -67,6 +70,7 @@ class TransactionManager {
    * @return the transaction with the given transaction id
    */
   static Transaction *GetTransaction(txn_id_t txn_id) {
+    std::lock_guard<std::mutex> guard(txn_map_latch);
     assert(TransactionManager::txn_map.find(txn_id) != TransactionManager::txn_map.end());
     auto *res = TransactionManager::txn_map[txn_id];
     assert(res != nullptr);
@@ -99,7 +103,7 @@ class TransactionManager {
 
   std::atomic<txn_id_t> next_txn_id_{0};
   LockManager *lock_manager_ __attribute__((__unused__));
-  LogManager *log_manager_ __attribute__((__unused__));
+  LogManager *log_manager_;
 
   /** The global transaction latch is used for checkpointing. */
   ReaderWriterLatch global_txn_latch_;
@@ -43,9 +43,27 @@ class IndexScanExecutor : public AbstractExecutor {
   bool Next(Tuple *tuple, RID *rid) override;
 
  private:
+  /** Most RIDs read from the index ahead of the tuples that are returned. */
+  static constexpr size_t MAX_BATCH_SIZE = 256;
+
+  /**
+   * Reads the next RIDs from the index and fetches their tuples with one TableHeap::GetTuples call. A batch stops
+   * before it spans more than a quarter of the buffer pool, so that its pages fit in next to everybody else's.
+   * @param end the end iterator of the index
+   * @param table_heap the table the index points into
+   * @return false if the index has no more entries
+   */
+  bool FetchNextBatch(const IndexIterator<GenericKey<8>, RID, GenericComparator<8>> &end, TableHeap *table_heap);
+
   /** The index scan plan node to be executed. */
   const IndexScanPlanNode *plan_;
 
   std::unique_ptr<IndexIterator<GenericKey<8>, RID, GenericComparator<8>>> index_iterator_;
+  /** The RIDs of the current batch, in index order, with their tuples and whether the tuple could be read. */
+  std::vector<RID> batch_rids_;
+  std::vector<Tuple> batch_tuples_;
+  std::vector<bool> batch_found_;
+  /** Position of the next entry of the current batch to return. */
+  size_t batch_cursor_{0};
 };
 }  // namespace bustub
@@ -16,6 +16,7 @@
 #include <condition_variable>  // NOLINT
 #include <future>              // NOLINT
 #include <mutex>               // NOLINT
+#include <thread>              // NOLINT
 
 #include "recovery/log_record.h"
 #include "storage/disk/disk_manager.h"
@@ -25,20 +26,28 @@ namespace bustub {
 /**
  * LogManager maintains a separate thread that is awakened whenever the log buffer is full or whenever a timeout
  * happens. When the thread is awakened, the log buffer's content is written into the disk log file.
+ *
+ * Appends do not take a latch. A record reserves its LSN and its space in the current buffer with one compare and swap
+ * on reservation_, a word holding the next LSN, the current buffer and the bytes reserved in it, so records sit in
+ * the buffer in LSN order. Writers then serialize their records in parallel and count the bytes they filled in. The
+ * flush thread switches reservations over to the other buffer, waits until the switched-out one is filled up to the
+ * point where reservations stopped, and writes and syncs it without holding the latch. A committing transaction only
+ * waits until persistent_lsn_ reaches its commit record; all commits arriving while a write is in progress are made
+ * durable together by the next one, so they share a single WriteLog and sync (group commit).
  */
 class LogManager {
  public:
-  explicit LogManager(DiskManager *disk_manager)
-      : next_lsn_(0), persistent_lsn_(INVALID_LSN), disk_manager_(disk_manager) {
-    log_buffer_ = new char[LOG_BUFFER_SIZE];
-    flush_buffer_ = new char[LOG_BUFFER_SIZE];
+  explicit LogManager(DiskManager *disk_manager) : persistent_lsn_(INVALID_LSN), disk_manager_(disk_manager) {
+    buffers_[0] = new char[LOG_BUFFER_SIZE];
+    buffers_[1] = new char[LOG_BUFFER_SIZE];
   }
 
   ~LogManager() {
-    delete[] log_buffer_;
-    delete[] flush_buffer_;
-    log_buffer_ = nullptr;
-    flush_buffer_ = nullptr;
+    StopFlushThread();
+    delete[] buffers_[0];
+    delete[] buffers_[1];
+    buffers_[0] = nullptr;
+    buffers_[1] = nullptr;
   }
 
   void RunFlushThread();
@@ -46,29 +55,77 @@ class LogManager {
 
   lsn_t AppendLogRecord(LogRecord *log_record);
 
-  inline lsn_t GetNextLSN() { return next_lsn_; }
+  /**
+   * Waits until the log records up to and including lsn are on disk. If the flush thread is not running, the log
+   * buffer is written by the calling thread instead.
+   * @param lsn an lsn returned by AppendLogRecord
+   */
+  void Flush(lsn_t lsn);
+
+  inline lsn_t GetNextLSN() { return LsnOf(reservation_); }
   inline lsn_t GetPersistentLSN() { return persistent_lsn_; }
   inline void SetPersistentLSN(lsn_t lsn) { persistent_lsn_ = lsn; }
-  inline char *GetLogBuffer() { return log_buffer_; }
+  /**
+   * Continues the lsns of a log that already holds records, e.g. from LogRecovery::GetNextLSN, so that page LSNs and
+   * the lsns of later records keep increasing across restarts. Call it before RunFlushThread.
+   * @param lsn the lsn of the next record; the records before it are on disk
+   */
+  inline void SetNextLSN(lsn_t lsn) {
+    reservation_ = static_cast<uint64_t>(lsn) << 32;
+    persistent_lsn_ = lsn - 1;
+  }
+  inline char *GetLogBuffer() { return buffers_[BufferOf(reservation_)]; }
 
  private:
-  // TODO(students): you may add your own member variables
+  static constexpr uint64_t OFFSET_MASK = (uint64_t{1} << 31) - 1;
+
+  static lsn_t LsnOf(uint64_t reservation) { return static_cast<lsn_t>(reservation >> 32); }
+  static int BufferOf(uint64_t reservation) { return static_cast<int>((reservation >> 31) & 1); }
+  static int OffsetOf(uint64_t reservation) { return static_cast<int>(reservation & OFFSET_MASK); }
+  /** @return the reservation that starts appending to the other buffer */
+  static uint64_t Switched(uint64_t reservation) {
+    return (reservation >> 32 << 32) | (static_cast<uint64_t>(BufferOf(reservation) ^ 1) << 31);
+  }
 
-  /** The atomic counter which records the next log sequence number. */
-  std::atomic<lsn_t> next_lsn_;
+  /** The loop of the flush thread. */
+  void FlushLoop();
+
+  /**
+   * Switches reservations to the other buffer and writes the records reserved so far, releasing the latch during the
+   * write.
+   * @param lock a lock on latch_
+   */
+  void FlushBuffer(std::unique_lock<std::mutex> *lock);
+
+  /**
+   * The next lsn in the upper 32 bits, then the buffer that records are appended to, then the number of bytes
+   * reserved in it. LSNs and space are handed out together by advancing this word.
+   */
+  std::atomic<uint64_t> reservation_{0};
   /** The log records before and including the persistent lsn have been written to disk. */
   std::atomic<lsn_t> persistent_lsn_;
 
-  char *log_buffer_;
-  char *flush_buffer_;
+  char *buffers_[2];
+  /** The number of bytes of each buffer whose records have been serialized. */
+  std::atomic<int> filled_[2] = {{0}, {0}};
+  /** True while a buffer is being written. */
+  bool flushing_{false};
+  /** True if a full buffer or a committing transaction is waiting for the flush thread. */
+  bool flush_requested_{false};
+  bool stop_flush_thread_{false};
 
   std::mutex latch_;
 
-  std::thread *flush_thread_ __attribute__((__unused__));
+  std::thread *flush_thread_{nullptr};
 
+  /** Wakes the flush thread. */
   std::condition_variable cv_;
+  /** Signalled when reservations have been switched to the other buffer, which makes room for appends. */
+  std::condition_variable append_cv_;
+  /** Signalled when a write has completed and persistent_lsn_ has advanced. */
+  std::condition_variable persist_cv_;
 
-  DiskManager *disk_manager_ __attribute__((__unused__));
+  DiskManager *disk_manager_;
 };
 
 }  // namespace bustub
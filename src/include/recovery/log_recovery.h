@@ -13,23 +13,40 @@
 #pragma once
 
 #include <algorithm>
-#include <mutex>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/lock_manager.h"
+#include "concurrency/transaction.h"
 #include "recovery/log_record.h"
 
 namespace bustub {
 
 /**
  * Read log file from disk, redo and undo.
+ *
+ * Redo is parallel. A single pass reads the log in LOG_BUFFER_SIZE chunks and hands every record to one of the redo
+ * threads, chosen by the page the record changes. As the log is in LSN order and a page always goes to the same
+ * thread, every page sees its records in LSN order, and a record is only applied if the page LSN shows that the page
+ * does not reflect it yet. Undo then rolls back the transactions that were active at the crash, latest record first.
  */
 class LogRecovery {
  public:
-  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager)
+  /**
+   * @param num_redo_threads the number of threads that apply records in Redo, 0 = one per core. Each of them pins a
+   * page at a time, so there are never more than the buffer pool has frames.
+   */
+  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, size_t num_redo_threads = 0)
       : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), offset_(0) {
     log_buffer_ = new char[LOG_BUFFER_SIZE];
+    num_redo_threads_ = num_redo_threads != 0 ? num_redo_threads : std::max(1U, std::thread::hardware_concurrency());
+    num_redo_threads_ = std::min(num_redo_threads_, std::max<size_t>(1, buffer_pool_manager->GetPoolSize()));
   }
 
   ~LogRecovery() {
@@ -41,17 +58,47 @@ class LogRecovery {
   void Undo();
   bool DeserializeLogRecord(const char *data, LogRecord *log_record);
 
+  /** @return the number of threads that Redo uses */
+  size_t GetNumRedoThreads() const { return num_redo_threads_; }
+
+  /** @return one past the largest lsn that Redo found in the log, which new log records must continue from */
+  lsn_t GetNextLSN() const { return max_lsn_ + 1; }
+
  private:
-  DiskManager *disk_manager_ __attribute__((__unused__));
-  BufferPoolManager *buffer_pool_manager_ __attribute__((__unused__));
+  /** A record to be applied to a page; a NEWPAGE record is applied to both the new page and the one before it. */
+  using RedoTask = std::pair<page_id_t, LogRecord>;
+
+  /** The queue of one redo thread. */
+  struct RedoPartition {
+    std::mutex latch_;
+    std::condition_variable cv_;
+    std::deque<std::vector<RedoTask>> batches_;
+    bool done_{false};
+  };
+
+  /** Runs a redo thread, which applies the batches of its partition until the log has been read. */
+  void RunRedoPartition(RedoPartition *partition);
+  /** Applies a record to a page unless the page LSN shows that it is already there. */
+  void RedoLogRecord(page_id_t page_id, LogRecord *log_record, Transaction *txn);
+  /** Rolls back the change of a record. */
+  void UndoLogRecord(LogRecord *log_record, Transaction *txn);
+
+  DiskManager *disk_manager_;
+  BufferPoolManager *buffer_pool_manager_;
 
   /** Maintain active transactions and its corresponding latest lsn. */
   std::unordered_map<txn_id_t, lsn_t> active_txn_;
   /** Mapping the log sequence number to log file offset for undos. */
   std::unordered_map<lsn_t, int> lsn_mapping_;
+  /** The largest lsn in the log, INVALID_LSN if it is empty. */
+  lsn_t max_lsn_{INVALID_LSN};
 
-  int offset_ __attribute__((__unused__));
+  /** The offset in the log file of the first byte in log_buffer_. */
+  int offset_;
   char *log_buffer_;
+  /** The number of bytes read into log_buffer_. */
+  int buffer_size_{0};
+  size_t num_redo_threads_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,115 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_table.h
+//
+// Identification: src/include/storage/disk/compressed_page_table.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstdint>
+#include <map>
+#include <mutex>  // NOLINT
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * CompressedPageTable keeps track of where the pages of a compressed db file are. A compressed page takes as many
+ * SECTOR_SIZE sectors as its compressed bytes need, anywhere in the file, so the table maps every page id to its
+ * extent. The table is mirrored to a file with one entry per page; the free extents are not stored but rebuilt from
+ * the gaps between the mapped ones.
+ *
+ * A page is written to a newly allocated extent and only mapped once the write completed, so a crash in between
+ * leaves the old version of the page in place. The extent a page is moved away from is only reused after the next
+ * Sync, as the table file may point to it until then.
+ */
+class CompressedPageTable {
+ public:
+  static constexpr uint32_t SECTOR_SIZE = 512;
+  static constexpr uint32_t SECTORS_PER_PAGE = PAGE_SIZE / SECTOR_SIZE;
+
+  /** The location of a stored page, as kept in the table file. */
+  struct Extent {
+    // the first sector
+    uint32_t sector_;
+    // the number of bytes stored; 0 if the page has never been written, PAGE_SIZE if it is stored uncompressed
+    uint32_t length_;
+
+    off_t Offset() const { return static_cast<off_t>(sector_) * SECTOR_SIZE; }
+    uint32_t NumSectors() const { return (length_ + SECTOR_SIZE - 1) / SECTOR_SIZE; }
+  };
+
+  /**
+   * Loads the table from its file.
+   * @param map_fd the table file, owned by the table from now on
+   * @param map_size the size of the table file
+   */
+  CompressedPageTable(int map_fd, off_t map_size);
+
+  ~CompressedPageTable() { Close(); }
+
+  /** @return the extent of a page, with a length of 0 if the page has never been written */
+  Extent Lookup(page_id_t page_id);
+
+  /**
+   * Allocates an extent for a page that is about to be written, preferring free extents over growing the file.
+   * @param length the number of bytes to be written, at most PAGE_SIZE
+   */
+  Extent Allocate(uint32_t length);
+
+  /** Maps a page to an extent returned by Allocate once it has been written, freeing the previous one on Sync. */
+  void Map(page_id_t page_id, Extent extent);
+
+  /** Unmaps a page, freeing its extent on Sync. */
+  void Unmap(page_id_t page_id);
+
+  /** Frees an extent returned by Allocate that is not going to be mapped, e.g. because the write failed. */
+  void Release(Extent extent);
+
+  /** @return the number of bytes that the mapped pages take up, not counting the rest of their last sectors */
+  uint64_t GetStoredBytes();
+
+  /** @return the number of mapped pages */
+  size_t GetNumStoredPages();
+
+  /** Makes the table file durable and frees the extents unmapped before. @return false if the sync failed */
+  bool Sync();
+
+  /** Closes the table file; the table is not mirrored any more afterwards. */
+  void Close();
+
+ private:
+  /** Adds an extent of any size to the free extents, merging it with its neighbours; latch_ must be held. */
+  void FreeSectors(uint32_t sector, uint32_t num_sectors);
+  /** Removes a free extent, must be called with latch_ held. */
+  void TakeSectors(std::map<uint32_t, uint32_t>::iterator free_extent);
+  /** Writes the entry of a page to the table file, must be called with latch_ held. */
+  void Persist(page_id_t page_id);
+
+  std::mutex latch_;
+  int map_fd_;
+  std::vector<Extent> extents_;
+  // the free extents as first sector -> number of sectors, and as (number of sectors, first sector) for best fit
+  std::map<uint32_t, uint32_t> free_by_sector_;
+  std::set<std::pair<uint32_t, uint32_t>> free_by_size_;
+  // the extents unmapped since the last Sync as (first sector, number of sectors); a crash may bring them back
+  std::vector<std::pair<uint32_t, uint32_t>> unsynced_free_;
+  // one past the last sector ever allocated
+  uint32_t end_sector_ = 0;
+  uint64_t stored_bytes_ = 0;
+  size_t num_stored_pages_ = 0;
+};
+
+}  // namespace bustub
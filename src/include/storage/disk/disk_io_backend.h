@@ -0,0 +1,153 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_io_backend.h
+//
+// Identification: src/include/storage/disk/disk_io_backend.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <sys/uio.h>
+
+#include <cstdint>
+#include <functional>
+#include <future>  // NOLINT
+#include <memory>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/** A read or write that was handed to a DiskIOBackend and has not completed yet. */
+struct DiskIORequest {
+  bool is_write_;
+  off_t offset_;
+  size_t length_;
+  char *page_data_;
+  // fulfilled with true once all length_ bytes were transferred; a read past the end of the file yields zeros
+  std::promise<bool> done_;
+  // the buffer as io_uring sees it, must stay put until the request completes
+  struct iovec iov_;
+  // the caller's buffer if page_data_ is an aligned bounce buffer standing in for it, nullptr otherwise
+  char *user_data_;
+  // called with the data once the transfer succeeded, its result becomes the result of the request
+  std::function<bool(const char *)> on_success_;
+  // called instead of on_success_ if the transfer failed
+  std::function<void()> on_failure_;
+};
+
+/**
+ * DiskIOBackend performs reads and writes on a file asynchronously, with at most queue_depth of them in flight
+ * at a time. Submitting blocks while the queue is full.
+ *
+ * There are two implementations: one on io_uring, which lets the kernel keep the whole queue in flight from a single
+ * submitting thread, and a fallback for kernels without io_uring that runs pread/pwrite on a pool of threads.
+ *
+ * For a file opened with O_DIRECT, buffers that are not aligned to DIRECT_IO_ALIGNMENT go through an aligned bounce
+ * buffer. The frames of a buffer pool are aligned and never need one.
+ */
+class DiskIOBackend {
+ public:
+  enum class Type { IO_URING, THREAD_POOL };
+
+  /** The alignment of buffers, offsets and lengths of direct I/O. */
+  static constexpr size_t DIRECT_IO_ALIGNMENT = PAGE_SIZE;
+
+  /**
+   * Creates a backend for a file, preferring io_uring.
+   * @param fd the file, must stay open until the backend is destroyed
+   * @param queue_depth the number of requests that may be in flight at once
+   * @param use_io_uring false to always use the thread pool
+   * @param direct true if the file was opened with O_DIRECT
+   */
+  static std::unique_ptr<DiskIOBackend> Create(int fd, size_t queue_depth, bool use_io_uring, bool direct = false);
+
+  /**
+   * Destroys the backend after every request submitted to it has completed.
+   */
+  virtual ~DiskIOBackend() = default;
+
+  /**
+   * Reads a page asynchronously. page_data must not be touched until the returned future is ready.
+   * @param on_success if set, called on an I/O thread with the page once it was read, e.g. to verify it
+   * @return a future holding true if the read succeeded and on_success, if set, returned true
+   */
+  std::future<bool> Read(page_id_t page_id, char *page_data, std::function<bool(const char *)> on_success = nullptr);
+
+  /**
+   * Writes a page asynchronously. page_data must not change until the returned future is ready.
+   * @param on_success if set, called on an I/O thread with the page once it was written
+   * @return a future holding true if the write succeeded and on_success, if set, returned true
+   */
+  std::future<bool> Write(page_id_t page_id, const char *page_data,
+                          std::function<bool(const char *)> on_success = nullptr);
+
+  /**
+   * Reads length bytes at an offset asynchronously, see Read. With direct I/O the offset must be aligned.
+   */
+  std::future<bool> ReadAt(off_t offset, char *data, size_t length,
+                           std::function<bool(const char *)> on_success = nullptr);
+
+  /**
+   * Writes length bytes at an offset asynchronously, see Write. With direct I/O the offset must be aligned.
+   * @param on_failure if set, called on an I/O thread if the write failed, e.g. to give back the space it was to use
+   */
+  std::future<bool> WriteAt(off_t offset, const char *data, size_t length,
+                            std::function<bool(const char *)> on_success = nullptr,
+                            std::function<void()> on_failure = nullptr);
+
+  /** @return which implementation this is */
+  virtual Type GetType() const = 0;
+
+  /** @return the number of requests that may be in flight at once */
+  size_t GetQueueDepth() const { return queue_depth_; }
+
+  /** @return true if a buffer may be used for direct I/O as it is */
+  static bool IsAligned(const void *data) { return reinterpret_cast<uintptr_t>(data) % DIRECT_IO_ALIGNMENT == 0; }
+
+  /**
+   * Transfers (the rest of) a page synchronously with pread/pwrite, which do not move the file offset and are safe to
+   * call from several threads at once.
+   * @param done the number of bytes of the page already transferred
+   * @return the total number of bytes transferred, less than PAGE_SIZE at the end of the file, or a negative errno. A
+   * read stops at the first short transfer, which on a regular file means the end of the file.
+   */
+  static int64_t TransferPage(int fd, bool is_write, page_id_t page_id, char *page_data, int64_t done = 0) {
+    return Transfer(fd, is_write, OffsetOf(page_id), page_data, PAGE_SIZE, done);
+  }
+
+  /** Same as TransferPage, for length bytes at an offset. */
+  static int64_t Transfer(int fd, bool is_write, off_t offset, char *data, int64_t length, int64_t done = 0);
+
+  static off_t OffsetOf(page_id_t page_id) { return static_cast<off_t>(page_id) * PAGE_SIZE; }
+
+ protected:
+  DiskIOBackend(int fd, size_t queue_depth, bool direct) : fd_(fd), queue_depth_(queue_depth), direct_(direct) {}
+
+  /**
+   * Starts a request, waiting for a free slot first. The backend owns the request from now on.
+   */
+  virtual void Submit(DiskIORequest *request) = 0;
+
+  /**
+   * Fulfills and deletes a request.
+   * @param result the number of bytes transferred, or a negative errno
+   */
+  static void Complete(DiskIORequest *request, int64_t result);
+
+  int fd_;
+  size_t queue_depth_;
+  bool direct_;
+
+ private:
+  /** @return a new request, with a bounce buffer if direct I/O cannot use data */
+  DiskIORequest *MakeRequest(bool is_write, off_t offset, size_t length, char *data,
+                             std::function<bool(const char *)> on_success);
+};
+
+}  // namespace bustub
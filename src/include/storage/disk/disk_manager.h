@@ -15,25 +15,60 @@
 #include <atomic>
 #include <fstream>
 #include <future>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
+#include "storage/disk/compressed_page_table.h"
+#include "storage/disk/disk_io_backend.h"
 
 namespace bustub {
 
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * Pages may be read and written from several threads at once.
+ *
+ * With enable_direct_io set, the db file is opened with O_DIRECT, so pages are cached by the buffer pool only. Direct
+ * I/O needs buffers aligned to DiskIOBackend::DIRECT_IO_ALIGNMENT, which buffer pool frames are; pages in any other
+ * buffer are copied through an aligned one.
+ *
+ * Every page written gets a CRC32C checksum, kept in a .crc file next to the db file so that page layouts need not
+ * make room for it. Pages read are checked against it according to page_checksum_mode, which catches torn writes and
+ * bit rot. A page that fails the check is still returned as read, but the read reports the failure to its caller, and
+ * the failure is counted. The .crc file and the free space map are synced together with the db file.
+ *
+ * A db file created with enable_page_compression set stores its pages LZ4-compressed, packed into 512-byte sectors
+ * wherever there is room, and a CompressedPageTable in a .map file next to it records where each page is. That cuts
+ * the space the file takes and the bytes a scan reads for pages with free space or repetitive tuples. Pages that do
+ * not compress below a page are stored as they are. Checksums are of the uncompressed page, and direct I/O is not
+ * used for compressed files since their pages do not sit at aligned offsets.
+ *
+ * A db file that never changes, e.g. on an analytics replica, can be opened READ_ONLY. The file is then mapped into
+ * memory and a buffer pool points its frames at the mapped pages instead of copying them, see GetMappedPage. Nothing
+ * is written in this mode: page writes and allocations fail, and the log and the side files are only read.
  */
 class DiskManager {
  public:
+  /** The maximum number of pages WritePages writes with one system call. */
+  static constexpr size_t MAX_WRITE_RUN = 256;
+
+  /** How the db file is opened. */
+  enum class OpenMode { READ_WRITE, READ_ONLY };
+
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param mode READ_ONLY to map an existing db file read-only instead
+   * @throws Exception if the file cannot be opened, or is compressed and READ_ONLY was asked for
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, OpenMode mode = OpenMode::READ_WRITE);
 
-  ~DiskManager() = default;
+  ~DiskManager();
 
   /**
    * Shut down the disk manager and close all the file resources.
@@ -48,14 +83,71 @@ class DiskManager {
   void WritePage(page_id_t page_id, const char *page_data);
 
   /**
-   * Read a page from the database file.
+   * Read a page from the database file. A page past the end of the file reads as zeros.
    * @param page_id id of the page
    * @param[out] page_data output buffer
+   * @return false if the read failed, or the page does not match its checksum
+   */
+  bool ReadPage(page_id_t page_id, char *page_data);
+
+  /**
+   * Read several pages from the database file. The reads are issued asynchronously in the given order and overlap
+   * each other.
+   * @param pages the ids of the pages, in ascending order, each with its output buffer
+   * @return false if any of the reads failed, see ReadPage
+   */
+  bool ReadPages(const std::vector<std::pair<page_id_t, char *>> &pages);
+
+  /**
+   * Write several pages to the database file and make them durable. The pages are written in page id order, each
+   * run of consecutive pages with a single vectored write, and the file is synced once at the end.
+   * @param pages the ids of the pages, in any order, each with its raw page data
+   * @return false if a write or the sync failed
+   */
+  bool WritePages(const std::vector<std::pair<page_id_t, const char *>> &pages);
+
+  /**
+   * Start writing a page to the database file. At most disk_io_queue_depth asynchronous reads and writes are in
+   * flight at a time, so this blocks while the queue is full.
+   * @param page_id id of the page
+   * @param page_data raw page data, must not change until the returned future is ready
+   * @return a future holding true once the page was written successfully
+   */
+  std::future<bool> WritePageAsync(page_id_t page_id, const char *page_data);
+
+  /**
+   * Start reading a page from the database file, see WritePageAsync.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer, must not be touched until the returned future is ready
+   * @return a future holding true once the page was read successfully, false if it failed as in ReadPage
+   */
+  std::future<bool> ReadPageAsync(page_id_t page_id, char *page_data);
+
+  /** @return true if the db file was opened READ_ONLY and is mapped */
+  bool IsReadOnly() const { return read_only_; }
+
+  /**
+   * Returns a page of a READ_ONLY db file where it is mapped, without reading or copying it. The memory is read-only,
+   * writing to it crashes, and it stays valid until the disk manager is shut down.
+   * @param page_id id of the page
+   * @return the page, or a page of zeros if it lies past the end of the file
    */
-  void ReadPage(page_id_t page_id, char *page_data);
+  const char *GetMappedPage(page_id_t page_id) const;
+
+  /** @return true if the pages of the db file are stored compressed */
+  bool IsCompressed() const { return page_table_ != nullptr; }
+
+  /** @return the compressed page table of the db file, nullptr if its pages are not compressed */
+  CompressedPageTable *GetCompressedPageTable() { return page_table_.get(); }
+
+  /** @return true if the db file was opened with O_DIRECT, false if direct I/O is off or the file system lacks it */
+  bool IsDirectIO() const { return direct_io_; }
+
+  /** @return the backend running the asynchronous page I/O, io_uring unless the kernel does not allow it */
+  DiskIOBackend::Type GetAsyncBackendType() { return GetAsyncBackend()->GetType(); }
 
   /**
-   * Flush the entire log buffer into disk.
+   * Flush the entire log buffer into disk, returning once it is synced.
    * @param log_data raw log data
    * @param size size of log entry
    */
@@ -71,17 +163,25 @@ class DiskManager {
   bool ReadLog(char *log_data, int size, int offset);
 
   /**
-   * Allocate a page on disk.
+   * Allocate a page on disk, reusing the lowest deallocated page if there is one. The allocation is recorded in the
+   * free space map, so it survives a restart.
+   * @param stride only pages with page_id % stride == offset are handed out, which lets the shards of a parallel
+   * buffer pool share one disk manager
+   * @param offset see stride
    * @return the id of the allocated page
    */
-  page_id_t AllocatePage();
+  page_id_t AllocatePage(uint32_t stride = 1, uint32_t offset = 0);
 
   /**
-   * Deallocate a page on disk.
+   * Deallocate a page on disk, so that AllocatePage may hand it out again. Deallocating a page that is not
+   * allocated has no effect.
    * @param page_id id of the page to deallocate
    */
   void DeallocatePage(page_id_t page_id);
 
+  /** @return true if the page is allocated */
+  bool IsAllocated(page_id_t page_id);
+
   /** @return the number of disk flushes */
   int GetNumFlushes() const;
 
@@ -91,6 +191,12 @@ class DiskManager {
   /** @return the number of disk writes */
   int GetNumWrites() const;
 
+  /** @return the number of pages read whose checksum did not match, or that did not decompress */
+  uint64_t GetNumChecksumFailures() const { return num_checksum_failures_; }
+
+  /** @return the checksum of a page, never 0, which stands for a page without a checksum */
+  static uint32_t PageChecksum(const char *page_data);
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -102,15 +208,105 @@ class DiskManager {
 
  private:
   int GetFileSize(const std::string &file_name);
-  // stream to write log file
-  std::fstream log_io_;
+  /** Opens the db file read-only and maps it. */
+  void MapDbFile();
+  /** Waits for the asynchronous I/O and closes the db file and the free space map. */
+  void CloseDbFiles();
+  /** Syncs the free space map and the checksums. @return false if either sync failed */
+  bool SyncSideFiles();
+  /**
+   * Opens a file kept next to the db file. A READ_ONLY disk manager opens it read-only, and takes a missing one to be
+   * empty.
+   * @param db_file_existed false if the db file was just created, the file is emptied then because it is stale
+   * @param[out] size the size of the file
+   * @return the file descriptor, -1 if the disk manager is READ_ONLY and the file does not exist
+   */
+  int OpenSideFile(const std::string &name, bool db_file_existed, off_t *size);
+  /**
+   * Opens the free space map and restores the allocated pages and the next page id from it.
+   * @param db_file_existed false if the db file was just created, any map found is stale then
+   */
+  void LoadFreeSpaceMap(bool db_file_existed);
+  /**
+   * Opens the compressed page table if the db file is compressed, or is empty and is to be compressed.
+   * @param db_file_existed false if the db file was just created, any table found is stale then
+   */
+  void LoadCompressedPageTable(bool db_file_existed);
+  /** Opens the checksum file and loads the checksums from it. */
+  void LoadChecksums(bool db_file_existed);
+  /**
+   * Records the checksums of consecutive pages after they were written, or clears them if checksums are off.
+   * @param pages the page data of page_id, page_id + 1, ...
+   */
+  void RecordChecksums(page_id_t page_id, const char *const *pages, size_t num_pages);
+  /** Same as RecordChecksums, for checksums computed beforehand, 0 for pages written with checksums off. */
+  void StoreChecksums(page_id_t page_id, const uint32_t *checksums, size_t num_pages);
+  /** @return false if checksums are verified and the page does not match its checksum */
+  bool VerifyChecksum(page_id_t page_id, const char *page_data);
+  /** Allocation bitmap helpers, must be called with allocation_latch_ held. */
+  bool IsAllocatedLocked(page_id_t page_id) const;
+  void SetAllocated(page_id_t page_id, bool allocated);
+  /**
+   * Writes a run of consecutive pages with pwritev.
+   * @param pages the first page of the run, the following ones have the next page ids
+   */
+  bool WritePageRun(const std::pair<page_id_t, const char *> *pages, size_t num_pages);
+  /**
+   * Compresses a page for storing it.
+   * @param buffer receives the compressed page, must hold PAGE_SIZE bytes
+   * @param[out] length the number of bytes to store
+   * @return the bytes to store, which are the page itself if it does not compress
+   */
+  static const char *CompressPage(const char *page_data, char *buffer, uint32_t *length);
+  /** @return false if the stored bytes do not decompress to a page */
+  bool DecompressPage(page_id_t page_id, const char *stored, uint32_t length, char *page_data);
+  /** Writes a page of a compressed db file to a new extent and maps it there. */
+  bool WriteCompressedPage(page_id_t page_id, const char *page_data);
+  /** Reads a page of a compressed db file, pages that have never been written read as zeros. */
+  bool ReadCompressedPage(page_id_t page_id, char *page_data);
+  std::future<bool> WriteCompressedPageAsync(page_id_t page_id, const char *page_data);
+  std::future<bool> ReadCompressedPageAsync(page_id_t page_id, char *page_data);
+  /** Raises the cached size of the db file to include a page that is being written. */
+  void GrowFileSize(page_id_t page_id);
+  /** @return the backend for asynchronous page I/O, created on first use */
+  DiskIOBackend *GetAsyncBackend();
+  // descriptor of the log file, appended to and synced by WriteLog
+  int log_fd_ = -1;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
   std::string file_name_;
+  // descriptor of the db file, it is only accessed with pread/pwrite so that threads can do page I/O in parallel
+  int db_fd_ = -1;
+  bool direct_io_ = false;
+  // the mapping of a READ_ONLY db file, nullptr if the file is empty
+  bool read_only_ = false;
+  const char *mapping_ = nullptr;
+  size_t mapped_size_ = 0;
+  // size of the db file as far as this disk manager has written it, so that reads need not stat the file
+  std::atomic<int64_t> db_file_size_{0};
+  std::once_flag async_backend_once_;
+  std::unique_ptr<DiskIOBackend> async_backend_;
+  // one past the last allocated page
   std::atomic<page_id_t> next_page_id_;
+  // The free space map is a bitmap with one bit per page, set if the page is allocated. It is kept in memory and
+  // mirrored to the .fsm file next to the db file.
+  std::string fsm_name_;
+  int fsm_fd_ = -1;
+  std::mutex allocation_latch_;
+  std::vector<uint64_t> allocated_;
+  size_t num_allocated_pages_ = 0;
+  // no page below this one is free
+  page_id_t first_free_hint_ = 0;
+  // where the pages are if the db file is compressed, nullptr otherwise
+  std::string map_name_;
+  std::unique_ptr<CompressedPageTable> page_table_;
+  // The checksum of every page, 0 if it has none, mirrored to the .crc file.
+  std::string crc_name_;
+  int crc_fd_ = -1;
+  std::mutex checksum_latch_;
+  std::vector<uint32_t> checksums_;
+  std::atomic<uint64_t> num_checksum_failures_{0};
   int num_flushes_;
-  int num_writes_;
+  std::atomic<int> num_writes_;
   bool flush_log_;
   std::future<void> *flush_log_f_;
 };
@@ -10,10 +10,12 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <deque>
 #include <queue>
 #include <string>
 #include <vector>
 
+#include "common/rwlatch.h"
 #include "concurrency/transaction.h"
 #include "storage/index/index_iterator.h"
 #include "storage/page/b_plus_tree_internal_page.h"
@@ -78,7 +80,7 @@ class BPlusTree {
   // read data from file and remove one by one
   void RemoveFromFile(const std::string &file_name, Transaction *transaction = nullptr);
   // expose for test purpose
-  Page *FindLeafPage(const KeyType &key, bool leftMost = false);
+  BasicPageGuard FindLeafPage(const KeyType &key, bool leftMost = false);
 
  private:
   void StartNewTree(const KeyType &key, const ValueType &value);
@@ -108,6 +110,9 @@ class BPlusTree {
 
   bool AdjustRoot(BPlusTreePage *node);
 
+  template <typename Guard>
+  void ReleaseAncestors(std::deque<Guard> *guards, bool *root_latched);
+
   void UpdateRootPageId(int insert_record = 0);
 
   /* Debug Routines for FREE!! */
@@ -122,8 +127,8 @@ class BPlusTree {
   KeyComparator comparator_;
   int leaf_max_size_;
   int internal_max_size_;
-  // dummy tree page, use to protect root_page_id field!
-  Page dummy_page;
+  // protects the root_page_id_ field!
+  ReaderWriterLatch root_latch_;
 };
 
 }  // namespace bustub
@@ -47,6 +47,15 @@ class IndexIterator {
 
   // key-value index
   int kvIndex;
+
+  // leaf pages entered since the last read-ahead request
+  int leavesSinceReadAhead = 0;
+
+  // ask the buffer pool to read the next READ_AHEAD_PAGES leaves, starting at pageId
+  void readAhead(page_id_t pageId);
+
+  // read the next leaf page id from raw page data
+  static page_id_t nextLeafPageIdOf(const char *pageData);
 };
 
 }  // namespace bustub
@@ -62,9 +62,9 @@ class BPlusTreePage {
 
   void SetLSN(lsn_t lsn = INVALID_LSN);
 
-  bool IsSafeForInsert();
+  bool IsSafeForInsert() const;
 
-  bool IsSafeForDelete();
+  bool IsSafeForDelete() const;
 
  private:
   // member variable, attributes that both internal and leaf page share
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
 
@@ -24,14 +25,18 @@ namespace bustub {
  * Page is the basic unit of storage within the database system. Page provides a wrapper for actual data pages being
  * held in main memory. Page also contains book-keeping information that is used by the buffer pool manager, e.g.
  * pin count, dirty flag, page id, etc.
+ *
+ * The data itself is not part of the Page: the buffer pool manager points every Page at its frame in a FrameArena,
+ * which keeps the book-keeping array compact and the frames page aligned. The book-keeping fields are atomic because
+ * the buffer pool pins and unpins resident pages without its latch.
  */
 class Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManager;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor. The page has no data until the buffer pool manager assigns it a frame. */
+  Page() = default;
 
   /** Default destructor. */
   ~Page() = default;
@@ -78,14 +83,16 @@ class Page {
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
 
-  /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
+  /** The actual data that is stored within a page, PAGE_SIZE bytes owned by the buffer pool's frame arena. */
+  char *data_ = nullptr;
   /** The ID of this page. */
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  /** The pin count of this page. */
-  int pin_count_ = 0;
+  std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
+  /** The pin count of this page, negative while the buffer pool manager is reassigning the frame. */
+  std::atomic<int> pin_count_{0};
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
-  bool is_dirty_ = false;
+  std::atomic<bool> is_dirty_{false};
+  /** True while the buffer pool manager reads this frame in or writes its previous content out without its latch. */
+  std::atomic<bool> is_io_in_progress_{false};
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
 };
@@ -0,0 +1,233 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.h
+//
+// Identification: src/include/storage/page/page_guard.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "storage/page/page.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+class ReadPageGuard;
+class WritePageGuard;
+
+/**
+ * BasicPageGuard keeps a page pinned for as long as it lives and unpins it when it is destroyed or dropped.
+ * It does not latch the page. The guard remembers whether the page was modified through it, so callers never pass a
+ * dirty flag by hand. Guards are move-only: moving one transfers the pin, and the moved-from guard is empty.
+ */
+class BasicPageGuard {
+ public:
+  BasicPageGuard() = default;
+
+  /**
+   * Creates a guard for a page that is already pinned.
+   * @param bpm the buffer pool manager the page was fetched from
+   * @param page the pinned page, nullptr for an empty guard
+   */
+  BasicPageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+  BasicPageGuard(const BasicPageGuard &) = delete;
+  BasicPageGuard &operator=(const BasicPageGuard &) = delete;
+
+  BasicPageGuard(BasicPageGuard &&that) noexcept;
+
+  /** Drops the page this guard holds, then takes over the page of that. */
+  BasicPageGuard &operator=(BasicPageGuard &&that) noexcept;
+
+  ~BasicPageGuard();
+
+  /**
+   * Unpins the page and empties the guard. Dropping an empty guard does nothing.
+   */
+  void Drop();
+
+  /**
+   * Latches the page for reading and hands the pin over to a ReadPageGuard. This guard is empty afterwards.
+   */
+  ReadPageGuard UpgradeRead();
+
+  /**
+   * Latches the page for writing and hands the pin over to a WritePageGuard. This guard is empty afterwards.
+   */
+  WritePageGuard UpgradeWrite();
+
+  /** @return true if the guard holds a page, false if the fetch failed or the guard was dropped or moved from */
+  explicit operator bool() const { return page_ != nullptr; }
+
+  /** @return the id of the guarded page */
+  page_id_t PageId() { return page_->GetPageId(); }
+
+  /** @return the guarded page, for page types like TablePage that derive from Page */
+  Page *GetPage() { return page_; }
+
+  /** @return the guarded page, which is marked dirty */
+  Page *GetPageMut() {
+    is_dirty_ = true;
+    return page_;
+  }
+
+  /** @return the data of the guarded page */
+  const char *GetData() { return page_->GetData(); }
+
+  /** @return the data of the guarded page, which is marked dirty */
+  char *GetDataMut() {
+    is_dirty_ = true;
+    return page_->GetData();
+  }
+
+  /** @return the data of the guarded page viewed as a T */
+  template <class T>
+  const T *As() {
+    return reinterpret_cast<const T *>(GetData());
+  }
+
+  /** @return the data of the guarded page viewed as a T, the page is marked dirty */
+  template <class T>
+  T *AsMut() {
+    return reinterpret_cast<T *>(GetDataMut());
+  }
+
+  /** Marks the page dirty, for changes made through a pointer that was obtained earlier. */
+  void MarkDirty() { is_dirty_ = true; }
+
+ private:
+  friend class ReadPageGuard;
+  friend class WritePageGuard;
+
+  BufferPoolManager *bpm_{nullptr};
+  Page *page_{nullptr};
+  bool is_dirty_{false};
+};
+
+/**
+ * ReadPageGuard keeps a page pinned and read-latched, and releases both when it is destroyed or dropped.
+ */
+class ReadPageGuard {
+ public:
+  ReadPageGuard() = default;
+
+  /**
+   * Creates a guard for a page that is already pinned and read-latched.
+   * @param bpm the buffer pool manager the page was fetched from
+   * @param page the pinned page, nullptr for an empty guard
+   */
+  ReadPageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  ReadPageGuard(const ReadPageGuard &) = delete;
+  ReadPageGuard &operator=(const ReadPageGuard &) = delete;
+
+  ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+
+  /** Drops the page this guard holds, then takes over the page of that. */
+  ReadPageGuard &operator=(ReadPageGuard &&that) noexcept;
+
+  ~ReadPageGuard();
+
+  /**
+   * Unlatches and unpins the page and empties the guard. Dropping an empty guard does nothing.
+   */
+  void Drop();
+
+  /** @return true if the guard holds a page */
+  explicit operator bool() const { return static_cast<bool>(guard_); }
+
+  /** @return the id of the guarded page */
+  page_id_t PageId() { return guard_.PageId(); }
+
+  /** @return the guarded page, for page types like TablePage that derive from Page */
+  Page *GetPage() { return guard_.GetPage(); }
+
+  /** @return the data of the guarded page */
+  const char *GetData() { return guard_.GetData(); }
+
+  /** @return the data of the guarded page viewed as a T */
+  template <class T>
+  const T *As() {
+    return guard_.As<T>();
+  }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+/**
+ * WritePageGuard keeps a page pinned and write-latched, and releases both when it is destroyed or dropped.
+ */
+class WritePageGuard {
+ public:
+  WritePageGuard() = default;
+
+  /**
+   * Creates a guard for a page that is already pinned and write-latched.
+   * @param bpm the buffer pool manager the page was fetched from
+   * @param page the pinned page, nullptr for an empty guard
+   */
+  WritePageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  WritePageGuard(const WritePageGuard &) = delete;
+  WritePageGuard &operator=(const WritePageGuard &) = delete;
+
+  WritePageGuard(WritePageGuard &&that) noexcept = default;
+
+  /** Drops the page this guard holds, then takes over the page of that. */
+  WritePageGuard &operator=(WritePageGuard &&that) noexcept;
+
+  ~WritePageGuard();
+
+  /**
+   * Unlatches and unpins the page and empties the guard. Dropping an empty guard does nothing.
+   */
+  void Drop();
+
+  /** @return true if the guard holds a page */
+  explicit operator bool() const { return static_cast<bool>(guard_); }
+
+  /** @return the id of the guarded page */
+  page_id_t PageId() { return guard_.PageId(); }
+
+  /** @return the guarded page, for page types like TablePage that derive from Page */
+  Page *GetPage() { return guard_.GetPage(); }
+
+  /** @return the guarded page, which is marked dirty */
+  Page *GetPageMut() { return guard_.GetPageMut(); }
+
+  /** @return the data of the guarded page */
+  const char *GetData() { return guard_.GetData(); }
+
+  /** @return the data of the guarded page, which is marked dirty */
+  char *GetDataMut() { return guard_.GetDataMut(); }
+
+  /** @return the data of the guarded page viewed as a T */
+  template <class T>
+  const T *As() {
+    return guard_.As<T>();
+  }
+
+  /** @return the data of the guarded page viewed as a T, the page is marked dirty */
+  template <class T>
+  T *AsMut() {
+    return guard_.AsMut<T>();
+  }
+
+  /** Marks the page dirty, for changes made through a pointer that was obtained earlier. */
+  void MarkDirty() { guard_.MarkDirty(); }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+}  // namespace bustub
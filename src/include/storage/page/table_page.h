@@ -62,6 +62,15 @@ class TablePage : public Page {
   /** @return the page ID of the next table page */
   page_id_t GetNextPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID); }
 
+  /**
+   * Reads the next page ID from raw page data, for buffer pool read-ahead.
+   * @param page_data the data of a table page
+   * @return the page ID of the next table page
+   */
+  static page_id_t NextPageIdOf(const char *page_data) {
+    return *reinterpret_cast<const page_id_t *>(page_data + OFFSET_NEXT_PAGE_ID);
+  }
+
   /** Set the page id of the previous page in the table. */
   void SetPrevPageId(page_id_t prev_page_id) {
     memcpy(GetData() + OFFSET_PREV_PAGE_ID, &prev_page_id, sizeof(page_id_t));
@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "recovery/log_manager.h"
 #include "storage/page/table_page.h"
@@ -99,6 +101,15 @@ class TableHeap {
    */
   bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn);
 
+  /**
+   * Read several tuples from the table, fetching the pages they live on with one batch call to the buffer pool.
+   * @param rids rids of the tuples to read; callers should keep the number of distinct pages well below the pool size
+   * @param[out] tuples the tuples, in the order of rids
+   * @param txn transaction performing the read
+   * @return for every rid, true if the read was successful (i.e. the tuple exists)
+   */
+  std::vector<bool> GetTuples(const std::vector<RID> &rids, std::vector<Tuple> *tuples, Transaction *txn);
+
   /** @return the begin iterator of this table */
   TableIterator Begin(Transaction *txn);
 
@@ -32,7 +32,10 @@ class TableIterator {
   TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
 
   TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        pages_since_read_ahead_(other.pages_since_read_ahead_) {}
 
   ~TableIterator() { delete tuple_; }
 
@@ -52,13 +55,19 @@ class TableIterator {
     table_heap_ = other.table_heap_;
     *tuple_ = *other.tuple_;
     txn_ = other.txn_;
+    pages_since_read_ahead_ = other.pages_since_read_ahead_;
     return *this;
   }
 
  private:
+  /** Asks the buffer pool to read the next READ_AHEAD_PAGES pages of the table, starting at page_id. */
+  void ReadAhead(page_id_t page_id);
+
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  /** Pages entered since the last read-ahead request. */
+  int pages_since_read_ahead_{0};
 };
 
 }  // namespace bustub
@@ -18,10 +18,15 @@ void CheckpointManager::BeginCheckpoint() {
   // Block all the transactions and ensure that both the WAL and all dirty buffer pool pages are persisted to disk,
   // creating a consistent checkpoint. Do NOT allow transactions to resume at the end of this method, resume them
   // in CheckpointManager::EndCheckpoint() instead. This is for grading purposes.
+  transaction_manager_->BlockAllTransactions();
+  log_manager_->Flush(log_manager_->GetNextLSN() - 1);
+  // With write batching on, the dirty pages go out as sorted runs followed by a single sync.
+  buffer_pool_manager_->FlushAllPages();
 }
 
 void CheckpointManager::EndCheckpoint() {
   // Allow transactions to resume, completing the checkpoint.
+  transaction_manager_->ResumeTransactions();
 }
 
 }  // namespace bustub
@@ -12,6 +12,12 @@
 
 #include "recovery/log_manager.h"
 
+#include <algorithm>
+#include <cstring>
+#include <thread>  // NOLINT
+
+#include "common/macros.h"
+
 namespace bustub {
 /*
  * set enable_logging = true
@@ -22,33 +28,162 @@ namespace bustub {
  *
  * This thread runs forever until system shutdown/StopFlushThread
  */
-void LogManager::RunFlushThread() {}
+void LogManager::RunFlushThread() {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (flush_thread_ != nullptr) {
+    return;
+  }
+  enable_logging = true;
+  stop_flush_thread_ = false;
+  flush_thread_ = new std::thread(&LogManager::FlushLoop, this);
+}
 
 /*
  * Stop and join the flush thread, set enable_logging = false
  */
-void LogManager::StopFlushThread() {}
+void LogManager::StopFlushThread() {
+  std::thread *flush_thread;
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    if (flush_thread_ == nullptr) {
+      return;
+    }
+    enable_logging = false;
+    stop_flush_thread_ = true;
+    flush_thread = flush_thread_;
+    flush_thread_ = nullptr;
+  }
+  cv_.notify_one();
+  flush_thread->join();
+  delete flush_thread;
+}
+
+void LogManager::FlushLoop() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (!stop_flush_thread_) {
+    cv_.wait_for(lock, log_timeout, [&] { return flush_requested_ || stop_flush_thread_; });
+    // Everything appended up to now goes out with this write, including the records of whoever asked for it.
+    flush_requested_ = false;
+    FlushBuffer(&lock);
+  }
+  // the records appended during the last write
+  FlushBuffer(&lock);
+}
+
+void LogManager::FlushBuffer(std::unique_lock<std::mutex> *lock) {
+  persist_cv_.wait(*lock, [&] { return !flushing_; });
+  // Close the buffer to further reservations. The other one is free since the last write has completed.
+  uint64_t reservation = reservation_.load();
+  do {
+    if (OffsetOf(reservation) == 0) {
+      return;
+    }
+  } while (!reservation_.compare_exchange_weak(reservation, Switched(reservation)));
+  int buffer = BufferOf(reservation);
+  int flush_size = OffsetOf(reservation);
+  lsn_t flush_lsn = LsnOf(reservation) - 1;
+  flushing_ = true;
+  append_cv_.notify_all();
+
+  lock->unlock();
+  // Every record below the watermark has been reserved, wait for the writers still serializing theirs.
+  while (filled_[buffer].load(std::memory_order_acquire) < flush_size) {
+    std::this_thread::yield();
+  }
+  filled_[buffer].store(0, std::memory_order_relaxed);
+  disk_manager_->WriteLog(buffers_[buffer], flush_size);
+  lock->lock();
+
+  flushing_ = false;
+  persistent_lsn_ = flush_lsn;
+  persist_cv_.notify_all();
+}
+
+void LogManager::Flush(lsn_t lsn) {
+  std::unique_lock<std::mutex> lock(latch_);
+  lsn = std::min<lsn_t>(lsn, GetNextLSN() - 1);
+  while (persistent_lsn_ < lsn) {
+    if (flush_thread_ == nullptr) {
+      FlushBuffer(&lock);
+      continue;
+    }
+    flush_requested_ = true;
+    cv_.notify_one();
+    persist_cv_.wait(lock);
+  }
+}
 
 /*
  * append a log record into log buffer
  * you MUST set the log record's lsn within this method
  * @return: lsn that is assigned to this log record
  *
- *
- * example below
- * // First, serialize the must have fields(20 bytes in total)
- * log_record.lsn_ = next_lsn_++;
- * memcpy(log_buffer_ + offset_, &log_record, 20);
- * int pos = offset_ + 20;
- *
- * if (log_record.log_record_type_ == LogRecordType::INSERT) {
- *    memcpy(log_buffer_ + pos, &log_record.insert_rid_, sizeof(RID));
- *    pos += sizeof(RID);
- *    // we have provided serialize function for tuple class
- *    log_record.insert_tuple_.SerializeTo(log_buffer_ + pos);
- *  }
- *
+ * The header fields are serialized one after another (20 bytes in total), followed by the fields of the record type
+ * in the order shown in log_record.h.
  */
-lsn_t LogManager::AppendLogRecord(LogRecord *log_record) { return INVALID_LSN; }
+lsn_t LogManager::AppendLogRecord(LogRecord *log_record) {
+  BUSTUB_ASSERT(log_record->size_ <= LOG_BUFFER_SIZE, "log record does not fit into the log buffer");
+  const uint64_t reserve = (uint64_t{1} << 32) + log_record->size_;
+  uint64_t reservation = reservation_.load();
+  while (true) {
+    if (OffsetOf(reservation) + log_record->size_ <= LOG_BUFFER_SIZE) {
+      if (reservation_.compare_exchange_weak(reservation, reservation + reserve)) {
+        break;
+      }
+      continue;
+    }
+    // The buffer is full: hand it to the flush thread, which makes room by switching to the other one.
+    std::unique_lock<std::mutex> lock(latch_);
+    if (reservation_.load() == reservation) {
+      if (flush_thread_ == nullptr) {
+        FlushBuffer(&lock);
+      } else {
+        flush_requested_ = true;
+        cv_.notify_one();
+        append_cv_.wait(lock);
+      }
+    }
+    reservation = reservation_.load();
+  }
+
+  log_record->lsn_ = LsnOf(reservation);
+  int buffer = BufferOf(reservation);
+  char *pos = buffers_[buffer] + OffsetOf(reservation);
+  auto append = [&pos](const void *field, size_t size) {
+    memcpy(pos, field, size);
+    pos += size;
+  };
+  append(&log_record->size_, sizeof(int32_t));
+  append(&log_record->lsn_, sizeof(lsn_t));
+  append(&log_record->txn_id_, sizeof(txn_id_t));
+  append(&log_record->prev_lsn_, sizeof(lsn_t));
+  append(&log_record->log_record_type_, sizeof(LogRecordType));
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      append(&log_record->insert_rid_, sizeof(RID));
+      log_record->insert_tuple_.SerializeTo(pos);
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      append(&log_record->delete_rid_, sizeof(RID));
+      log_record->delete_tuple_.SerializeTo(pos);
+      break;
+    case LogRecordType::UPDATE:
+      append(&log_record->update_rid_, sizeof(RID));
+      log_record->old_tuple_.SerializeTo(pos);
+      pos += sizeof(int32_t) + log_record->old_tuple_.GetLength();
+      log_record->new_tuple_.SerializeTo(pos);
+      break;
+    case LogRecordType::NEWPAGE:
+      append(&log_record->prev_page_id_, sizeof(page_id_t));
+      append(&log_record->page_id_, sizeof(page_id_t));
+      break;
+    default:
+      break;
+  }
+  filled_[buffer].fetch_add(log_record->size_, std::memory_order_release);
+  return log_record->lsn_;
+}
 
 }  // namespace bustub
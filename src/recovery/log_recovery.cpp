@@ -12,15 +12,102 @@
 
 #include "recovery/log_recovery.h"
 
+#include <algorithm>
+#include <cstring>
+#include <queue>
+
+#include "common/logger.h"
+#include "storage/page/page_guard.h"
 #include "storage/page/table_page.h"
 
 namespace bustub {
+
+namespace {
+
+/** The number of batches a redo thread may have queued before the reader waits for it. */
+constexpr size_t MAX_QUEUED_BATCHES = 4;
+
+}  // namespace
+
 /*
  * deserialize a log record from log buffer
  * @return: true means deserialize succeed, otherwise can't deserialize cause
  * incomplete log record
+ *
+ * data must point into log_buffer_, whose first buffer_size_ bytes hold what has been read.
  */
-bool LogRecovery::DeserializeLogRecord(const char *data, LogRecord *log_record) { return false; }
+bool LogRecovery::DeserializeLogRecord(const char *data, LogRecord *log_record) {
+  const char *end = log_buffer_ + buffer_size_;
+  if (end - data < LogRecord::HEADER_SIZE) {
+    return false;
+  }
+  int32_t size;
+  memcpy(&size, data, sizeof(int32_t));
+  // the end of the log is zeros
+  if (size < LogRecord::HEADER_SIZE || size > end - data) {
+    return false;
+  }
+  const char *pos = data;
+  const char *record_end = data + size;
+  auto read = [&pos](void *field, size_t size) {
+    memcpy(field, pos, size);
+    pos += size;
+  };
+  // a tuple is its size followed by its data, which has to end within the record
+  auto read_tuple = [&pos, record_end](Tuple *tuple) {
+    uint32_t tuple_size;
+    if (record_end - pos < static_cast<int64_t>(sizeof(uint32_t))) {
+      return false;
+    }
+    memcpy(&tuple_size, pos, sizeof(uint32_t));
+    if (tuple_size > record_end - pos - sizeof(uint32_t)) {
+      return false;
+    }
+    tuple->DeserializeFrom(pos);
+    pos += sizeof(uint32_t) + tuple_size;
+    return true;
+  };
+  read(&log_record->size_, sizeof(int32_t));
+  read(&log_record->lsn_, sizeof(lsn_t));
+  read(&log_record->txn_id_, sizeof(txn_id_t));
+  read(&log_record->prev_lsn_, sizeof(lsn_t));
+  read(&log_record->log_record_type_, sizeof(LogRecordType));
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      if (record_end - pos < static_cast<int64_t>(sizeof(RID))) {
+        return false;
+      }
+      read(&log_record->insert_rid_, sizeof(RID));
+      return read_tuple(&log_record->insert_tuple_);
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      if (record_end - pos < static_cast<int64_t>(sizeof(RID))) {
+        return false;
+      }
+      read(&log_record->delete_rid_, sizeof(RID));
+      return read_tuple(&log_record->delete_tuple_);
+    case LogRecordType::UPDATE:
+      if (record_end - pos < static_cast<int64_t>(sizeof(RID))) {
+        return false;
+      }
+      read(&log_record->update_rid_, sizeof(RID));
+      return read_tuple(&log_record->old_tuple_) && read_tuple(&log_record->new_tuple_);
+    case LogRecordType::NEWPAGE:
+      if (size != LogRecord::HEADER_SIZE + 2 * static_cast<int32_t>(sizeof(page_id_t))) {
+        return false;
+      }
+      read(&log_record->prev_page_id_, sizeof(page_id_t));
+      read(&log_record->page_id_, sizeof(page_id_t));
+      return true;
+    case LogRecordType::BEGIN:
+    case LogRecordType::COMMIT:
+    case LogRecordType::ABORT:
+      return size == LogRecord::HEADER_SIZE;
+    default:
+      return false;
+  }
+}
 
 /*
  *redo phase on TABLE PAGE level(table/table_page.h)
@@ -29,12 +116,243 @@ bool LogRecovery::DeserializeLogRecord(const char *data, LogRecord *log_record)
  *LSN with log_record's sequence number, and also build active_txn_ table &
  *lsn_mapping_ table
  */
-void LogRecovery::Redo() {}
+void LogRecovery::Redo() {
+  std::vector<RedoPartition> partitions(num_redo_threads_);
+  std::vector<std::thread> threads;
+  threads.reserve(num_redo_threads_);
+  for (auto &partition : partitions) {
+    threads.emplace_back(&LogRecovery::RunRedoPartition, this, &partition);
+  }
+  auto dispatch = [&](std::vector<std::vector<RedoTask>> *batches) {
+    for (size_t i = 0; i < num_redo_threads_; i++) {
+      if ((*batches)[i].empty()) {
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(partitions[i].latch_);
+      // keep the records in memory bounded when the redo threads fall behind
+      partitions[i].cv_.wait(lock, [&] { return partitions[i].batches_.size() < MAX_QUEUED_BATCHES; });
+      partitions[i].batches_.push_back(std::move((*batches)[i]));
+      partitions[i].cv_.notify_all();
+      (*batches)[i].clear();
+    }
+  };
+
+  std::vector<std::vector<RedoTask>> batches(num_redo_threads_);
+  offset_ = 0;
+  while (disk_manager_->ReadLog(log_buffer_, LOG_BUFFER_SIZE, offset_)) {
+    buffer_size_ = LOG_BUFFER_SIZE;
+    int pos = 0;
+    LogRecord log_record;
+    while (DeserializeLogRecord(log_buffer_ + pos, &log_record)) {
+      lsn_mapping_[log_record.lsn_] = offset_ + pos;
+      max_lsn_ = std::max(max_lsn_, log_record.lsn_);
+      pos += log_record.size_;
+      switch (log_record.log_record_type_) {
+        case LogRecordType::COMMIT:
+        case LogRecordType::ABORT:
+          active_txn_.erase(log_record.txn_id_);
+          continue;
+        case LogRecordType::BEGIN:
+          active_txn_[log_record.txn_id_] = log_record.lsn_;
+          continue;
+        case LogRecordType::INSERT:
+          batches[log_record.insert_rid_.GetPageId() % num_redo_threads_].emplace_back(
+              log_record.insert_rid_.GetPageId(), log_record);
+          break;
+        case LogRecordType::MARKDELETE:
+        case LogRecordType::APPLYDELETE:
+        case LogRecordType::ROLLBACKDELETE:
+          batches[log_record.delete_rid_.GetPageId() % num_redo_threads_].emplace_back(
+              log_record.delete_rid_.GetPageId(), log_record);
+          break;
+        case LogRecordType::UPDATE:
+          batches[log_record.update_rid_.GetPageId() % num_redo_threads_].emplace_back(
+              log_record.update_rid_.GetPageId(), log_record);
+          break;
+        case LogRecordType::NEWPAGE:
+          batches[log_record.page_id_ % num_redo_threads_].emplace_back(log_record.page_id_, log_record);
+          if (log_record.prev_page_id_ != INVALID_PAGE_ID) {
+            batches[log_record.prev_page_id_ % num_redo_threads_].emplace_back(log_record.prev_page_id_, log_record);
+          }
+          break;
+        default:
+          break;
+      }
+      active_txn_[log_record.txn_id_] = log_record.lsn_;
+    }
+    dispatch(&batches);
+    if (pos == 0) {
+      // not even one record, so this is the end of the log or a record torn by the crash
+      break;
+    }
+    // the next read starts at the record that did not fit
+    offset_ += pos;
+  }
+
+  for (auto &partition : partitions) {
+    std::lock_guard<std::mutex> guard(partition.latch_);
+    partition.done_ = true;
+    partition.cv_.notify_all();
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+void LogRecovery::RunRedoPartition(RedoPartition *partition) {
+  Transaction txn(INVALID_TXN_ID);
+  while (true) {
+    std::vector<RedoTask> batch;
+    {
+      std::unique_lock<std::mutex> lock(partition->latch_);
+      partition->cv_.wait(lock, [&] { return !partition->batches_.empty() || partition->done_; });
+      if (partition->batches_.empty()) {
+        return;
+      }
+      batch = std::move(partition->batches_.front());
+      partition->batches_.pop_front();
+      partition->cv_.notify_all();
+    }
+    for (auto &[page_id, log_record] : batch) {
+      RedoLogRecord(page_id, &log_record, &txn);
+    }
+  }
+}
+
+void LogRecovery::RedoLogRecord(page_id_t page_id, LogRecord *log_record, Transaction *txn) {
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(page_id);
+  if (!guard) {
+    LOG_DEBUG("can't fetch page %d to redo lsn %d", page_id, log_record->lsn_);
+    return;
+  }
+  auto *page = static_cast<TablePage *>(guard.GetPage());
+  if (log_record->log_record_type_ == LogRecordType::NEWPAGE && page_id == log_record->prev_page_id_) {
+    // The link to the new page is not covered by the page LSN of the page before it, but setting it is idempotent.
+    if (page->GetNextPageId() != log_record->page_id_) {
+      static_cast<TablePage *>(guard.GetPageMut())->SetNextPageId(log_record->page_id_);
+    }
+    return;
+  }
+  if (page->GetLSN() >= log_record->lsn_) {
+    return;
+  }
+  page = static_cast<TablePage *>(guard.GetPageMut());
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT: {
+      // The page is in the state it was in when the tuple was inserted, so the tuple gets the same slot again.
+      RID rid;
+      page->InsertTuple(log_record->insert_tuple_, &rid, txn, nullptr, nullptr);
+      if (!(rid == log_record->insert_rid_)) {
+        LOG_DEBUG("redo of lsn %d inserted at a different slot", log_record->lsn_);
+      }
+      break;
+    }
+    case LogRecordType::MARKDELETE:
+      page->MarkDelete(log_record->delete_rid_, txn, nullptr, nullptr);
+      break;
+    case LogRecordType::APPLYDELETE:
+      page->ApplyDelete(log_record->delete_rid_, txn, nullptr);
+      break;
+    case LogRecordType::ROLLBACKDELETE:
+      page->RollbackDelete(log_record->delete_rid_, txn, nullptr);
+      break;
+    case LogRecordType::UPDATE: {
+      Tuple old_tuple;
+      page->UpdateTuple(log_record->new_tuple_, &old_tuple, log_record->update_rid_, txn, nullptr, nullptr);
+      break;
+    }
+    case LogRecordType::NEWPAGE:
+      page->Init(page_id, PAGE_SIZE, log_record->prev_page_id_, nullptr, txn);
+      break;
+    default:
+      break;
+  }
+  page->SetLSN(log_record->lsn_);
+}
 
 /*
  *undo phase on TABLE PAGE level(table/table_page.h)
  *iterate through active txn map and undo each operation
+ *
+ * The records of all these transactions are undone together from the latest one back, the same order in which they
+ * were made.
  */
-void LogRecovery::Undo() {}
+void LogRecovery::Undo() {
+  Transaction txn(INVALID_TXN_ID);
+  std::priority_queue<lsn_t> to_undo;
+  for (const auto &[txn_id, lsn] : active_txn_) {
+    to_undo.push(lsn);
+  }
+  while (!to_undo.empty()) {
+    lsn_t lsn = to_undo.top();
+    to_undo.pop();
+    auto mapping = lsn_mapping_.find(lsn);
+    if (mapping == lsn_mapping_.end() || !disk_manager_->ReadLog(log_buffer_, LOG_BUFFER_SIZE, mapping->second)) {
+      LOG_DEBUG("can't find lsn %d to undo", lsn);
+      continue;
+    }
+    buffer_size_ = LOG_BUFFER_SIZE;
+    LogRecord log_record;
+    if (!DeserializeLogRecord(log_buffer_, &log_record)) {
+      LOG_DEBUG("can't read lsn %d to undo", lsn);
+      continue;
+    }
+    UndoLogRecord(&log_record, &txn);
+    if (log_record.prev_lsn_ != INVALID_LSN) {
+      to_undo.push(log_record.prev_lsn_);
+    }
+  }
+  active_txn_.clear();
+  lsn_mapping_.clear();
+}
+
+void LogRecovery::UndoLogRecord(LogRecord *log_record, Transaction *txn) {
+  page_id_t page_id;
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      page_id = log_record->insert_rid_.GetPageId();
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      page_id = log_record->delete_rid_.GetPageId();
+      break;
+    case LogRecordType::UPDATE:
+      page_id = log_record->update_rid_.GetPageId();
+      break;
+    default:
+      // BEGIN has nothing to undo, and a new page stays in the table as an empty one
+      return;
+  }
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(page_id);
+  if (!guard) {
+    LOG_DEBUG("can't fetch page %d to undo lsn %d", page_id, log_record->lsn_);
+    return;
+  }
+  auto *page = static_cast<TablePage *>(guard.GetPageMut());
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      page->ApplyDelete(log_record->insert_rid_, txn, nullptr);
+      break;
+    case LogRecordType::MARKDELETE:
+      page->RollbackDelete(log_record->delete_rid_, txn, nullptr);
+      break;
+    case LogRecordType::APPLYDELETE: {
+      RID rid;
+      page->InsertTuple(log_record->delete_tuple_, &rid, txn, nullptr, nullptr);
+      break;
+    }
+    case LogRecordType::ROLLBACKDELETE:
+      page->MarkDelete(log_record->delete_rid_, txn, nullptr, nullptr);
+      break;
+    case LogRecordType::UPDATE: {
+      Tuple new_tuple;
+      page->UpdateTuple(log_record->old_tuple_, &new_tuple, log_record->update_rid_, txn, nullptr, nullptr);
+      break;
+    }
+    default:
+      break;
+  }
+}
 
 }  // namespace bustub
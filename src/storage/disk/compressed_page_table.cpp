@@ -0,0 +1,187 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_table.cpp
+//
+// Identification: src/storage/disk/compressed_page_table.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/compressed_page_table.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+CompressedPageTable::CompressedPageTable(int map_fd, off_t map_size) : map_fd_(map_fd) {
+  extents_.resize(map_size / sizeof(Extent), Extent{0, 0});
+  if (!extents_.empty() && pread(map_fd_, extents_.data(), extents_.size() * sizeof(Extent), 0) < 0) {
+    throw Exception("can't read compressed page table");
+  }
+  std::vector<std::pair<uint32_t, uint32_t>> used;
+  for (auto &extent : extents_) {
+    if (extent.length_ > static_cast<uint32_t>(PAGE_SIZE)) {
+      LOG_DEBUG("ignoring corrupt compressed page table entry");
+      extent = Extent{0, 0};
+    }
+    if (extent.length_ == 0) {
+      continue;
+    }
+    used.emplace_back(extent.sector_, extent.NumSectors());
+    end_sector_ = std::max(end_sector_, extent.sector_ + extent.NumSectors());
+    stored_bytes_ += extent.length_;
+    num_stored_pages_++;
+  }
+  // everything between the mapped extents is free
+  std::sort(used.begin(), used.end());
+  uint32_t sector = 0;
+  for (const auto &[first, num_sectors] : used) {
+    if (first > sector) {
+      FreeSectors(sector, first - sector);
+    }
+    sector = std::max(sector, first + num_sectors);
+  }
+}
+
+CompressedPageTable::Extent CompressedPageTable::Lookup(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (page_id < 0 || static_cast<size_t>(page_id) >= extents_.size()) {
+    return Extent{0, 0};
+  }
+  return extents_[page_id];
+}
+
+CompressedPageTable::Extent CompressedPageTable::Allocate(uint32_t length) {
+  BUSTUB_ASSERT(length > 0 && length <= static_cast<uint32_t>(PAGE_SIZE), "invalid length");
+  Extent extent{0, length};
+  uint32_t num_sectors = extent.NumSectors();
+  std::lock_guard<std::mutex> guard(latch_);
+  // the smallest free extent that is large enough, split if it is larger
+  auto best = free_by_size_.lower_bound({num_sectors, 0});
+  if (best != free_by_size_.end()) {
+    auto [size, sector] = *best;
+    TakeSectors(free_by_sector_.find(sector));
+    if (size > num_sectors) {
+      FreeSectors(sector + num_sectors, size - num_sectors);
+    }
+    extent.sector_ = sector;
+    return extent;
+  }
+  extent.sector_ = end_sector_;
+  end_sector_ += num_sectors;
+  return extent;
+}
+
+void CompressedPageTable::Map(page_id_t page_id, Extent extent) {
+  BUSTUB_ASSERT(page_id >= 0, "invalid page id");
+  std::lock_guard<std::mutex> guard(latch_);
+  if (static_cast<size_t>(page_id) >= extents_.size()) {
+    extents_.resize(std::max<size_t>(page_id + 1, 2 * extents_.size()), Extent{0, 0});
+  }
+  Extent old = extents_[page_id];
+  extents_[page_id] = extent;
+  Persist(page_id);
+  if (old.length_ != 0) {
+    unsynced_free_.emplace_back(old.sector_, old.NumSectors());
+    stored_bytes_ -= old.length_;
+    num_stored_pages_--;
+  }
+  stored_bytes_ += extent.length_;
+  num_stored_pages_++;
+}
+
+void CompressedPageTable::Unmap(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (page_id < 0 || static_cast<size_t>(page_id) >= extents_.size() || extents_[page_id].length_ == 0) {
+    return;
+  }
+  Extent old = extents_[page_id];
+  extents_[page_id] = Extent{0, 0};
+  Persist(page_id);
+  unsynced_free_.emplace_back(old.sector_, old.NumSectors());
+  stored_bytes_ -= old.length_;
+  num_stored_pages_--;
+}
+
+void CompressedPageTable::Release(Extent extent) {
+  std::lock_guard<std::mutex> guard(latch_);
+  FreeSectors(extent.sector_, extent.NumSectors());
+}
+
+uint64_t CompressedPageTable::GetStoredBytes() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return stored_bytes_;
+}
+
+size_t CompressedPageTable::GetNumStoredPages() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return num_stored_pages_;
+}
+
+bool CompressedPageTable::Sync() {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (map_fd_ >= 0 && fdatasync(map_fd_) != 0) {
+    return false;
+  }
+  // no entry on disk points to these extents any more
+  for (const auto &[sector, num_sectors] : unsynced_free_) {
+    FreeSectors(sector, num_sectors);
+  }
+  unsynced_free_.clear();
+  return true;
+}
+
+void CompressedPageTable::Close() {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (map_fd_ >= 0) {
+    close(map_fd_);
+    map_fd_ = -1;
+  }
+}
+
+void CompressedPageTable::FreeSectors(uint32_t sector, uint32_t num_sectors) {
+  auto next = free_by_sector_.lower_bound(sector);
+  BUSTUB_ASSERT(next == free_by_sector_.end() || next->first >= sector + num_sectors, "sectors freed twice");
+  if (next != free_by_sector_.end() && next->first == sector + num_sectors) {
+    num_sectors += next->second;
+    TakeSectors(next++);
+  }
+  if (next != free_by_sector_.begin()) {
+    auto prev = std::prev(next);
+    BUSTUB_ASSERT(prev->first + prev->second <= sector, "sectors freed twice");
+    if (prev->first + prev->second == sector) {
+      sector = prev->first;
+      num_sectors += prev->second;
+      TakeSectors(prev);
+    }
+  }
+  free_by_sector_.emplace(sector, num_sectors);
+  free_by_size_.emplace(num_sectors, sector);
+}
+
+void CompressedPageTable::TakeSectors(std::map<uint32_t, uint32_t>::iterator free_extent) {
+  free_by_size_.erase({free_extent->second, free_extent->first});
+  free_by_sector_.erase(free_extent);
+}
+
+void CompressedPageTable::Persist(page_id_t page_id) {
+  if (map_fd_ >= 0 &&
+      pwrite(map_fd_, &extents_[page_id], sizeof(Extent), static_cast<off_t>(page_id) * sizeof(Extent)) < 0) {
+    LOG_DEBUG("I/O error while writing the compressed page table: %s", strerror(errno));
+  }
+}
+
+}  // namespace bustub
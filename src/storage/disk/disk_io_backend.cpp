@@ -0,0 +1,385 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_io_backend.cpp
+//
+// Identification: src/storage/disk/disk_io_backend.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_io_backend.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>  // NOLINT
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define BUSTUB_HAVE_IO_URING 1
+#endif
+
+#include "common/logger.h"
+
+namespace bustub {
+
+DiskIORequest *DiskIOBackend::MakeRequest(bool is_write, off_t offset, size_t length, char *data,
+                                          std::function<bool(const char *)> on_success) {
+  auto *request = new DiskIORequest{is_write, offset, length, data, {}, {}, nullptr, std::move(on_success), nullptr};
+  if (direct_ && !IsAligned(data)) {
+    request->user_data_ = data;
+    size_t aligned_length = (length + DIRECT_IO_ALIGNMENT - 1) / DIRECT_IO_ALIGNMENT * DIRECT_IO_ALIGNMENT;
+    request->page_data_ = static_cast<char *>(aligned_alloc(DIRECT_IO_ALIGNMENT, aligned_length));
+    if (is_write) {
+      memcpy(request->page_data_, data, length);
+    }
+  }
+  return request;
+}
+
+std::future<bool> DiskIOBackend::Read(page_id_t page_id, char *page_data,
+                                      std::function<bool(const char *)> on_success) {
+  return ReadAt(OffsetOf(page_id), page_data, PAGE_SIZE, std::move(on_success));
+}
+
+std::future<bool> DiskIOBackend::Write(page_id_t page_id, const char *page_data,
+                                       std::function<bool(const char *)> on_success) {
+  return WriteAt(OffsetOf(page_id), page_data, PAGE_SIZE, std::move(on_success));
+}
+
+std::future<bool> DiskIOBackend::ReadAt(off_t offset, char *data, size_t length,
+                                        std::function<bool(const char *)> on_success) {
+  DiskIORequest *request = MakeRequest(false, offset, length, data, std::move(on_success));
+  std::future<bool> done = request->done_.get_future();
+  Submit(request);
+  return done;
+}
+
+std::future<bool> DiskIOBackend::WriteAt(off_t offset, const char *data, size_t length,
+                                         std::function<bool(const char *)> on_success,
+                                         std::function<void()> on_failure) {
+  // the buffer is only read from, iovec just cannot say so
+  DiskIORequest *request = MakeRequest(true, offset, length, const_cast<char *>(data), std::move(on_success));
+  request->on_failure_ = std::move(on_failure);
+  std::future<bool> done = request->done_.get_future();
+  Submit(request);
+  return done;
+}
+
+void DiskIOBackend::Complete(DiskIORequest *request, int64_t result) {
+  auto length = static_cast<int64_t>(request->length_);
+  bool ok = result == length;
+  if (result < 0) {
+    LOG_DEBUG("I/O error at offset %jd: %s", static_cast<intmax_t>(request->offset_),
+              strerror(static_cast<int>(-result)));
+  } else if (!request->is_write_ && result < length) {
+    // the file ends inside or before the requested bytes
+    memset(request->page_data_ + result, 0, length - result);
+    ok = true;
+  }
+  if (ok && request->on_success_) {
+    ok = request->on_success_(request->page_data_);
+  } else if (!ok && request->on_failure_) {
+    request->on_failure_();
+  }
+  if (request->user_data_ != nullptr) {
+    if (!request->is_write_) {
+      memcpy(request->user_data_, request->page_data_, length);
+    }
+    free(request->page_data_);
+  }
+  request->done_.set_value(ok);
+  delete request;
+}
+
+int64_t DiskIOBackend::Transfer(int fd, bool is_write, off_t offset, char *data, int64_t length, int64_t done) {
+  while (done < length) {
+    ssize_t n = is_write ? pwrite(fd, data + done, length - done, offset + done)
+                         : pread(fd, data + done, length - done, offset + done);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      return -errno;
+    }
+    done += n;
+    // Going on after a short read would only find the end of the file again, and with O_DIRECT the offset would not
+    // be aligned any more.
+    if (n == 0 || (!is_write && done < length)) {
+      break;
+    }
+  }
+  return done;
+}
+
+namespace {
+
+/**
+ * Runs pread/pwrite on a pool of threads, one request per thread at a time.
+ */
+class ThreadPoolIOBackend : public DiskIOBackend {
+ public:
+  ThreadPoolIOBackend(int fd, size_t queue_depth, bool direct) : DiskIOBackend(fd, queue_depth, direct) {
+    size_t num_workers = std::min<size_t>(queue_depth, MAX_WORKERS);
+    for (size_t i = 0; i < num_workers; ++i) {
+      workers_.emplace_back([this] { Work(); });
+    }
+  }
+
+  ~ThreadPoolIOBackend() override {
+    {
+      std::lock_guard<std::mutex> guard(latch_);
+      stopping_ = true;
+    }
+    work_cv_.notify_all();
+    for (auto &worker : workers_) {
+      worker.join();
+    }
+  }
+
+  Type GetType() const override { return Type::THREAD_POOL; }
+
+ protected:
+  void Submit(DiskIORequest *request) override {
+    std::unique_lock<std::mutex> lock(latch_);
+    slot_cv_.wait(lock, [&] { return in_flight_ < queue_depth_; });
+    in_flight_++;
+    queue_.push_back(request);
+    lock.unlock();
+    work_cv_.notify_one();
+  }
+
+ private:
+  static constexpr size_t MAX_WORKERS = 16;
+
+  void Work() {
+    std::unique_lock<std::mutex> lock(latch_);
+    while (true) {
+      work_cv_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      DiskIORequest *request = queue_.front();
+      queue_.pop_front();
+      lock.unlock();
+      Complete(request, Transfer(fd_, request->is_write_, request->offset_, request->page_data_, request->length_));
+      lock.lock();
+      in_flight_--;
+      slot_cv_.notify_one();
+    }
+  }
+
+  std::mutex latch_;
+  std::condition_variable work_cv_;
+  std::condition_variable slot_cv_;
+  std::deque<DiskIORequest *> queue_;
+  // requests queued or being transferred
+  size_t in_flight_ = 0;
+  bool stopping_ = false;
+  std::vector<std::thread> workers_;
+};
+
+#ifdef BUSTUB_HAVE_IO_URING
+
+/**
+ * Submits requests to an io_uring and reaps their completions on a dedicated thread. The rings are set up with the
+ * raw system calls, so no liburing is needed.
+ */
+class IoUringBackend : public DiskIOBackend {
+ public:
+  IoUringBackend(int fd, size_t queue_depth, bool direct) : DiskIOBackend(fd, queue_depth, direct) {}
+
+  ~IoUringBackend() override {
+    if (ring_fd_ < 0) {
+      return;
+    }
+    if (reaper_.joinable()) {
+      std::unique_lock<std::mutex> lock(latch_);
+      slot_cv_.wait(lock, [&] { return in_flight_ == 0; });
+      // a no-op without a request tells the reaper to stop
+      io_uring_sqe *sqe = NextSqe();
+      sqe->opcode = IORING_OP_NOP;
+      PushSqe();
+      lock.unlock();
+      reaper_.join();
+    }
+    if (sqes_ != MAP_FAILED) {
+      munmap(sqes_, sqes_size_);
+    }
+    if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != MAP_FAILED) {
+      munmap(sq_ring_, sq_ring_size_);
+    }
+    close(ring_fd_);
+  }
+
+  /**
+   * Sets the rings up and starts the reaper.
+   * @return false if the kernel does not support io_uring or does not allow it
+   */
+  bool Init() {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, static_cast<unsigned>(queue_depth_), &params));
+    if (ring_fd_ < 0) {
+      LOG_DEBUG("io_uring_setup failed: %s", strerror(errno));
+      return false;
+    }
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0U;
+    if (single_mmap) {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                    IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+      return false;
+    }
+    cq_ring_ = single_mmap ? sq_ring_
+                           : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                                  IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      return false;
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sqes_ == MAP_FAILED) {
+      return false;
+    }
+
+    auto *sq = static_cast<char *>(sq_ring_);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    auto *cq = static_cast<char *>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    reaper_ = std::thread([this] { Reap(); });
+    return true;
+  }
+
+  Type GetType() const override { return Type::IO_URING; }
+
+ protected:
+  void Submit(DiskIORequest *request) override {
+    request->iov_.iov_base = request->page_data_;
+    request->iov_.iov_len = request->length_;
+    std::unique_lock<std::mutex> lock(latch_);
+    slot_cv_.wait(lock, [&] { return in_flight_ < queue_depth_; });
+    in_flight_++;
+    io_uring_sqe *sqe = NextSqe();
+    sqe->opcode = request->is_write_ ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd = fd_;
+    sqe->addr = reinterpret_cast<uint64_t>(&request->iov_);
+    sqe->len = 1;
+    sqe->off = request->offset_;
+    sqe->user_data = reinterpret_cast<uint64_t>(request);
+    PushSqe();
+  }
+
+ private:
+  /** @return the zeroed entry at the tail of the submission queue, must be called with latch_ held */
+  io_uring_sqe *NextSqe() {
+    unsigned index = *sq_tail_ & sq_mask_;
+    auto *sqe = static_cast<io_uring_sqe *>(sqes_) + index;
+    memset(sqe, 0, sizeof(*sqe));
+    sq_array_[index] = index;
+    return sqe;
+  }
+
+  /** Hands the entry returned by NextSqe to the kernel, must be called with latch_ held. */
+  void PushSqe() {
+    __atomic_store_n(sq_tail_, *sq_tail_ + 1, __ATOMIC_RELEASE);
+    while (syscall(__NR_io_uring_enter, ring_fd_, 1, 0, 0, nullptr, 0) < 0) {
+      // the queue never holds more than queue_depth_ requests, so only transient errors are expected here
+      if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+        LOG_DEBUG("io_uring_enter failed: %s", strerror(errno));
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  void Reap() {
+    while (true) {
+      unsigned head = *cq_head_;
+      if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+        syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        continue;
+      }
+      io_uring_cqe *cqe = &cqes_[head & cq_mask_];
+      auto *request = reinterpret_cast<DiskIORequest *>(cqe->user_data);
+      int64_t result = cqe->res;
+      __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+      if (request == nullptr) {
+        return;
+      }
+      // A short read ends at the end of the file. A short write is finished synchronously rather than resubmitted.
+      if (request->is_write_ && result >= 0 && result < static_cast<int64_t>(request->length_)) {
+        result = Transfer(fd_, request->is_write_, request->offset_, request->page_data_, request->length_, result);
+      }
+      Complete(request, result);
+      std::lock_guard<std::mutex> guard(latch_);
+      in_flight_--;
+      slot_cv_.notify_one();
+    }
+  }
+
+  int ring_fd_ = -1;
+  void *sq_ring_ = MAP_FAILED;
+  void *cq_ring_ = MAP_FAILED;
+  void *sqes_ = MAP_FAILED;
+  size_t sq_ring_size_ = 0;
+  size_t cq_ring_size_ = 0;
+  size_t sqes_size_ = 0;
+  unsigned *sq_tail_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned *sq_array_ = nullptr;
+  unsigned *cq_head_ = nullptr;
+  unsigned *cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  io_uring_cqe *cqes_ = nullptr;
+
+  // serializes submissions and protects in_flight_
+  std::mutex latch_;
+  std::condition_variable slot_cv_;
+  size_t in_flight_ = 0;
+  std::thread reaper_;
+};
+
+#endif
+
+}  // namespace
+
+std::unique_ptr<DiskIOBackend> DiskIOBackend::Create(int fd, size_t queue_depth, bool use_io_uring, bool direct) {
+  queue_depth = std::max<size_t>(queue_depth, 1);
+#ifdef BUSTUB_HAVE_IO_URING
+  if (use_io_uring) {
+    auto backend = std::make_unique<IoUringBackend>(fd, queue_depth, direct);
+    if (backend->Init()) {
+      return backend;
+    }
+  }
+#endif
+  return std::make_unique<ThreadPoolIOBackend>(fd, queue_depth, direct);
+}
+
+}  // namespace bustub
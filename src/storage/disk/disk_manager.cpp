@@ -10,116 +10,534 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <thread>  // NOLINT
 
 #include "common/exception.h"
 #include "common/logger.h"
+#include "common/macros.h"
+#include "common/util/crc32c.h"
+#include "common/util/lz4.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
 
 static char *buffer_used;
 
+namespace {
+
+// what GetMappedPage returns for pages past the end of the file
+alignas(PAGE_SIZE) const char ZERO_PAGE[PAGE_SIZE] = {};
+
+std::future<bool> ReadyFuture(bool result) {
+  std::promise<bool> done;
+  done.set_value(result);
+  return done.get_future();
+}
+
+}  // namespace
+
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), next_page_id_(0), num_flushes_(0), num_writes_(0), flush_log_(false), flush_log_f_(nullptr) {
+DiskManager::DiskManager(const std::string &db_file, OpenMode mode)
+    : file_name_(db_file),
+      read_only_(mode == OpenMode::READ_ONLY),
+      next_page_id_(0),
+      num_flushes_(0),
+      num_writes_(0),
+      flush_log_(false),
+      flush_log_f_(nullptr) {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
     return;
   }
   log_name_ = file_name_.substr(0, n) + ".log";
+  fsm_name_ = file_name_.substr(0, n) + ".fsm";
+  crc_name_ = file_name_.substr(0, n) + ".crc";
+  map_name_ = file_name_.substr(0, n) + ".map";
+  if (read_only_) {
+    // The log is neither written nor replayed, so it is not opened at all.
+    MapDbFile();
+    LoadCompressedPageTable(true);
+    LoadFreeSpaceMap(true);
+    LoadChecksums(true);
+    return;
+  }
 
-  log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-  // directory or file does not exist
-  if (!log_io_.is_open()) {
-    log_io_.clear();
-    // create a new file
-    log_io_.open(log_name_, std::ios::binary | std::ios::trunc | std::ios::app | std::ios::out);
-    log_io_.close();
-    // reopen with original mode
-    log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-    if (!log_io_.is_open()) {
-      throw Exception("can't open dblog file");
-    }
-  }
-
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io_.is_open()) {
-      throw Exception("can't open db file");
-    }
+  log_fd_ = open(log_name_.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+  if (log_fd_ < 0) {
+    throw Exception("can't open dblog file");
+  }
+
+  // A free space map left behind by a db file that has since been removed must not be applied to a new one.
+  bool db_file_existed = access(db_file.c_str(), F_OK) == 0;
+  LoadCompressedPageTable(db_file_existed);
+  // compressed pages do not sit at aligned offsets
+  direct_io_ = enable_direct_io && page_table_ == nullptr;
+  db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | (direct_io_ ? O_DIRECT : 0), 0644);
+  if (db_fd_ < 0 && direct_io_ && errno == EINVAL) {
+    LOG_DEBUG("file system does not support direct I/O");
+    direct_io_ = false;
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  }
+  if (db_fd_ < 0) {
+    throw Exception("can't open db file");
   }
+  struct stat stat_buf;
+  db_file_size_ = fstat(db_fd_, &stat_buf) == 0 ? static_cast<int64_t>(stat_buf.st_size) : 0;
+  LoadFreeSpaceMap(db_file_existed);
+  LoadChecksums(db_file_existed);
   buffer_used = nullptr;
 }
 
+DiskManager::~DiskManager() { CloseDbFiles(); }
+
+void DiskManager::MapDbFile() {
+  db_fd_ = open(file_name_.c_str(), O_RDONLY);
+  if (db_fd_ < 0) {
+    throw Exception("can't open db file");
+  }
+  struct stat stat_buf;
+  db_file_size_ = fstat(db_fd_, &stat_buf) == 0 ? static_cast<int64_t>(stat_buf.st_size) : 0;
+  if (db_file_size_ == 0) {
+    return;  // an empty mapping is not allowed, every page reads as zeros
+  }
+  // The pages are faulted in as they are first touched, so this is cheap however large the file is.
+  void *mapping = mmap(nullptr, db_file_size_, PROT_READ, MAP_SHARED, db_fd_, 0);
+  if (mapping == MAP_FAILED) {
+    throw Exception("can't map db file");
+  }
+  mapping_ = static_cast<const char *>(mapping);
+  mapped_size_ = db_file_size_;
+}
+
+const char *DiskManager::GetMappedPage(page_id_t page_id) const {
+  BUSTUB_ASSERT(read_only_, "only a read-only db file is mapped");
+  // A last page that the file ends inside of is still mapped: the rest of its memory page reads as zeros.
+  size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
+  if (page_id < 0 || offset >= mapped_size_) {
+    return ZERO_PAGE;
+  }
+  return mapping_ + offset;
+}
+
 /**
  * Close all file streams
  */
 void DiskManager::ShutDown() {
-  db_io_.close();
-  log_io_.close();
+  if (!read_only_) {
+    SyncSideFiles();
+  }
+  CloseDbFiles();
+  if (log_fd_ >= 0) {
+    close(log_fd_);
+    log_fd_ = -1;
+  }
+}
+
+bool DiskManager::SyncSideFiles() {
+  bool ok = true;
+  // a page allocated since the last sync must not come back as free after a crash
+  if (fsm_fd_ >= 0 && fdatasync(fsm_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing the free space map: %s", strerror(errno));
+    ok = false;
+  }
+  // the checksums are written after their pages, a page made durable without its checksum fails to verify
+  if (crc_fd_ >= 0 && fdatasync(crc_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing checksums: %s", strerror(errno));
+    ok = false;
+  }
+  return ok;
+}
+
+void DiskManager::CloseDbFiles() {
+  // waits for the asynchronous I/O still in flight
+  async_backend_.reset();
+  if (mapping_ != nullptr) {
+    munmap(const_cast<char *>(mapping_), mapped_size_);
+    mapping_ = nullptr;
+    mapped_size_ = 0;
+  }
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+    db_fd_ = -1;
+  }
+  if (fsm_fd_ >= 0) {
+    close(fsm_fd_);
+    fsm_fd_ = -1;
+  }
+  if (crc_fd_ >= 0) {
+    close(crc_fd_);
+    crc_fd_ = -1;
+  }
+  if (page_table_ != nullptr) {
+    page_table_->Close();
+  }
 }
 
 /**
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
-  // set write cursor to offset
+  if (read_only_) {
+    LOG_DEBUG("can't write page %d of a read-only db file", page_id);
+    return;
+  }
   num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
+  if (page_table_ != nullptr) {
+    if (WriteCompressedPage(page_id, page_data)) {
+      RecordChecksums(page_id, &page_data, 1);
+    }
+    return;
+  }
+  alignas(DiskIOBackend::DIRECT_IO_ALIGNMENT) char bounce[PAGE_SIZE];
+  if (direct_io_ && !DiskIOBackend::IsAligned(page_data)) {
+    memcpy(bounce, page_data, PAGE_SIZE);
+    page_data = bounce;
+  }
+  // the buffer is only read from
+  int64_t written = DiskIOBackend::TransferPage(db_fd_, true, page_id, const_cast<char *>(page_data));
   // check for I/O error
-  if (db_io_.bad()) {
+  if (written != PAGE_SIZE) {
     LOG_DEBUG("I/O error while writing");
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  GrowFileSize(page_id);
+  RecordChecksums(page_id, &page_data, 1);
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
-void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  int offset = page_id * PAGE_SIZE;
+bool DiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  if (page_table_ != nullptr) {
+    return ReadCompressedPage(page_id, page_data) && VerifyChecksum(page_id, page_data);
+  }
+  int64_t offset = static_cast<int64_t>(page_id) * PAGE_SIZE;
   // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
+  if (offset > db_file_size_.load()) {
     LOG_DEBUG("I/O error reading past end of file");
     // std::cerr << "I/O error while reading" << std::endl;
+    // a page that was never written reads as zeros, as it does from the asynchronous backend
+    memset(page_data, 0, PAGE_SIZE);
+    return true;
+  }
+  alignas(DiskIOBackend::DIRECT_IO_ALIGNMENT) char bounce[PAGE_SIZE];
+  char *buffer = direct_io_ && !DiskIOBackend::IsAligned(page_data) ? bounce : page_data;
+  int64_t read_count = DiskIOBackend::TransferPage(db_fd_, false, page_id, buffer);
+  if (read_count < 0) {
+    LOG_DEBUG("I/O error while reading");
+    return false;
+  }
+  if (buffer != page_data) {
+    memcpy(page_data, buffer, std::max<int64_t>(read_count, 0));
+  }
+  // if file ends before reading PAGE_SIZE
+  if (read_count < PAGE_SIZE) {
+    LOG_DEBUG("Read less than a page");
+    // std::cerr << "Read less than a page" << std::endl;
+    memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+  }
+  return VerifyChecksum(page_id, page_data);
+}
+
+/**
+ * Read the contents of several pages, sorted by page id. All reads are queued before the first one is waited for,
+ * so the device sees them together.
+ */
+bool DiskManager::ReadPages(const std::vector<std::pair<page_id_t, char *>> &pages) {
+  std::vector<std::future<bool>> reads;
+  reads.reserve(pages.size());
+  for (const auto &[page_id, page_data] : pages) {
+    reads.push_back(ReadPageAsync(page_id, page_data));
+  }
+  bool ok = true;
+  for (auto &read : reads) {
+    ok = read.get() && ok;
+  }
+  return ok;
+}
+
+/**
+ * Write several pages, sorted by page id so that the file is written sequentially, then sync the file once
+ */
+bool DiskManager::WritePages(const std::vector<std::pair<page_id_t, const char *>> &pages) {
+  if (read_only_) {
+    return pages.empty();
+  }
+  std::vector<std::pair<page_id_t, const char *>> sorted(pages);
+  std::stable_sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+  bool ok = true;
+  if (page_table_ != nullptr) {
+    // Compressed pages go wherever there is room, so there are no runs to write at once. In a new file, extents are
+    // allocated in order, so the pages still end up next to each other.
+    for (const auto &[page_id, page_data] : sorted) {
+      if (WriteCompressedPage(page_id, page_data)) {
+        RecordChecksums(page_id, &page_data, 1);
+      } else {
+        ok = false;
+      }
+    }
   } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    if (db_io_.bad()) {
-      LOG_DEBUG("I/O error while reading");
-      return;
+    for (size_t start = 0, end; start < sorted.size(); start = end) {
+      end = start + 1;
+      while (end < sorted.size() && end - start < MAX_WRITE_RUN && sorted[end].first == sorted[end - 1].first + 1) {
+        end++;
+      }
+      ok = WritePageRun(sorted.data() + start, end - start) && ok;
+    }
+  }
+  num_writes_ += static_cast<int>(pages.size());
+  if (fdatasync(db_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing: %s", strerror(errno));
+    ok = false;
+  }
+  if (!SyncSideFiles()) {
+    ok = false;
+  }
+  if (page_table_ != nullptr && !page_table_->Sync()) {
+    LOG_DEBUG("I/O error while syncing the compressed page table: %s", strerror(errno));
+    ok = false;
+  }
+  return ok;
+}
+
+bool DiskManager::WritePageRun(const std::pair<page_id_t, const char *> *pages, size_t num_pages) {
+  struct iovec iov[MAX_WRITE_RUN];
+  std::unique_ptr<char, decltype(&free)> bounce(nullptr, &free);
+  while (num_pages > 0) {
+    for (size_t i = 0; i < num_pages; ++i) {
+      const char *page_data = pages[i].second;
+      if (direct_io_ && !DiskIOBackend::IsAligned(page_data)) {
+        if (bounce == nullptr) {
+          void *buffer = aligned_alloc(DiskIOBackend::DIRECT_IO_ALIGNMENT, MAX_WRITE_RUN * PAGE_SIZE);
+          bounce.reset(static_cast<char *>(buffer));
+        }
+        page_data = static_cast<char *>(memcpy(bounce.get() + i * PAGE_SIZE, page_data, PAGE_SIZE));
+      }
+      // the buffers are only read from
+      iov[i].iov_base = const_cast<char *>(page_data);
+      iov[i].iov_len = PAGE_SIZE;
+    }
+    off_t offset = static_cast<off_t>(pages[0].first) * PAGE_SIZE;
+    ssize_t written = pwritev(db_fd_, iov, static_cast<int>(num_pages), offset);
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+    if (written <= 0) {
+      LOG_DEBUG("I/O error while writing");
+      return false;
+    }
+    // A short write may stop inside a page; finish that page on its own and go on with the rest of the run.
+    size_t done = written / PAGE_SIZE;
+    if (written % PAGE_SIZE != 0) {
+      if (DiskIOBackend::TransferPage(db_fd_, true, pages[done].first, static_cast<char *>(iov[done].iov_base),
+                                      written % PAGE_SIZE) != PAGE_SIZE) {
+        LOG_DEBUG("I/O error while writing");
+        return false;
+      }
+      done++;
     }
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      db_io_.clear();
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    GrowFileSize(pages[done - 1].first);
+    const char *written_pages[MAX_WRITE_RUN];
+    for (size_t i = 0; i < done; ++i) {
+      written_pages[i] = pages[i].second;
     }
+    RecordChecksums(pages[0].first, written_pages, done);
+    pages += done;
+    num_pages -= done;
   }
+  return true;
+}
+
+std::future<bool> DiskManager::WritePageAsync(page_id_t page_id, const char *page_data) {
+  if (read_only_) {
+    return ReadyFuture(false);
+  }
+  num_writes_ += 1;
+  if (page_table_ != nullptr) {
+    return WriteCompressedPageAsync(page_id, page_data);
+  }
+  // A read of the page racing with the write may see the file end inside the page and get zeros, which it could
+  // have gotten anyway.
+  GrowFileSize(page_id);
+  return GetAsyncBackend()->Write(page_id, page_data, [this, page_id](const char *written) {
+    RecordChecksums(page_id, &written, 1);
+    return true;
+  });
+}
+
+std::future<bool> DiskManager::ReadPageAsync(page_id_t page_id, char *page_data) {
+  if (page_table_ != nullptr) {
+    return ReadCompressedPageAsync(page_id, page_data);
+  }
+  if (page_checksum_mode != PageChecksumMode::VERIFY) {
+    return GetAsyncBackend()->Read(page_id, page_data);
+  }
+  return GetAsyncBackend()->Read(page_id, page_data,
+                                 [this, page_id](const char *read) { return VerifyChecksum(page_id, read); });
+}
+
+const char *DiskManager::CompressPage(const char *page_data, char *buffer, uint32_t *length) {
+  // Only a page that saves at least a sector is worth decompressing on every read.
+  size_t size = Lz4::Compress(page_data, PAGE_SIZE, buffer, PAGE_SIZE - CompressedPageTable::SECTOR_SIZE);
+  if (size == 0) {
+    *length = PAGE_SIZE;
+    return page_data;
+  }
+  *length = static_cast<uint32_t>(size);
+  return buffer;
+}
+
+bool DiskManager::DecompressPage(page_id_t page_id, const char *stored, uint32_t length, char *page_data) {
+  if (Lz4::Decompress(stored, length, page_data, PAGE_SIZE) == PAGE_SIZE) {
+    return true;
+  }
+  num_checksum_failures_++;
+  LOG_DEBUG("page %d does not decompress", page_id);
+  return false;
+}
+
+bool DiskManager::WriteCompressedPage(page_id_t page_id, const char *page_data) {
+  char buffer[PAGE_SIZE];
+  uint32_t length;
+  const char *stored = CompressPage(page_data, buffer, &length);
+  CompressedPageTable::Extent extent = page_table_->Allocate(length);
+  // the buffer is only read from
+  if (DiskIOBackend::Transfer(db_fd_, true, extent.Offset(), const_cast<char *>(stored), length) != length) {
+    LOG_DEBUG("I/O error while writing");
+    page_table_->Release(extent);
+    return false;
+  }
+  page_table_->Map(page_id, extent);
+  return true;
+}
+
+bool DiskManager::ReadCompressedPage(page_id_t page_id, char *page_data) {
+  CompressedPageTable::Extent extent = page_table_->Lookup(page_id);
+  if (extent.length_ == 0) {
+    memset(page_data, 0, PAGE_SIZE);
+    return true;
+  }
+  char buffer[PAGE_SIZE];
+  char *target = extent.length_ == PAGE_SIZE ? page_data : buffer;
+  if (DiskIOBackend::Transfer(db_fd_, false, extent.Offset(), target, extent.length_) != extent.length_) {
+    LOG_DEBUG("I/O error while reading");
+    return false;
+  }
+  return target == page_data || DecompressPage(page_id, buffer, extent.length_, page_data);
+}
+
+std::future<bool> DiskManager::WriteCompressedPageAsync(page_id_t page_id, const char *page_data) {
+  std::shared_ptr<char[]> buffer(new char[PAGE_SIZE]);
+  uint32_t length;
+  const char *stored = CompressPage(page_data, buffer.get(), &length);
+  // The checksum is of the page the compressed bytes were made from, so it is taken before the write is queued.
+  uint32_t checksum = page_checksum_mode == PageChecksumMode::OFF ? 0 : PageChecksum(page_data);
+  CompressedPageTable::Extent extent = page_table_->Allocate(length);
+  return GetAsyncBackend()->WriteAt(
+      extent.Offset(), stored, length,
+      [this, page_id, extent, checksum, buffer](const char * /*written*/) {
+        page_table_->Map(page_id, extent);
+        StoreChecksums(page_id, &checksum, 1);
+        return true;
+      },
+      [this, extent] { page_table_->Release(extent); });
+}
+
+std::future<bool> DiskManager::ReadCompressedPageAsync(page_id_t page_id, char *page_data) {
+  CompressedPageTable::Extent extent = page_table_->Lookup(page_id);
+  if (extent.length_ == 0) {
+    memset(page_data, 0, PAGE_SIZE);
+    return ReadyFuture(true);
+  }
+  if (extent.length_ == PAGE_SIZE) {
+    return GetAsyncBackend()->ReadAt(extent.Offset(), page_data, PAGE_SIZE,
+                                     [this, page_id](const char *read) { return VerifyChecksum(page_id, read); });
+  }
+  // the compressed bytes go to a buffer that lives as long as the request
+  std::shared_ptr<char[]> buffer(new char[extent.length_]);
+  return GetAsyncBackend()->ReadAt(extent.Offset(), buffer.get(), extent.length_,
+                                   [this, page_id, page_data, length = extent.length_, buffer](const char *read) {
+                                     return DecompressPage(page_id, read, length, page_data) &&
+                                            VerifyChecksum(page_id, page_data);
+                                   });
+}
+
+uint32_t DiskManager::PageChecksum(const char *page_data) {
+  uint32_t checksum = Crc32c::Compute(page_data, PAGE_SIZE);
+  return checksum == 0 ? 1 : checksum;
+}
+
+void DiskManager::RecordChecksums(page_id_t page_id, const char *const *pages, size_t num_pages) {
+  bool off = page_checksum_mode == PageChecksumMode::OFF;
+  uint32_t checksums[MAX_WRITE_RUN];
+  BUSTUB_ASSERT(num_pages <= MAX_WRITE_RUN, "too many pages");
+  for (size_t i = 0; i < num_pages; ++i) {
+    checksums[i] = off ? 0 : PageChecksum(pages[i]);
+  }
+  StoreChecksums(page_id, checksums, num_pages);
+}
+
+void DiskManager::StoreChecksums(page_id_t page_id, const uint32_t *checksums, size_t num_pages) {
+  // real checksums are never 0
+  bool off = std::all_of(checksums, checksums + num_pages, [](uint32_t checksum) { return checksum == 0; });
+  auto first = static_cast<size_t>(page_id);
+  std::lock_guard<std::mutex> guard(checksum_latch_);
+  if (first + num_pages > checksums_.size()) {
+    if (off && first >= checksums_.size()) {
+      return;  // nothing to clear
+    }
+    checksums_.resize(std::max(first + num_pages, 2 * checksums_.size()), 0);
+  }
+  if (memcmp(&checksums_[first], checksums, num_pages * sizeof(uint32_t)) == 0) {
+    return;
+  }
+  memcpy(&checksums_[first], checksums, num_pages * sizeof(uint32_t));
+  if (pwrite(crc_fd_, checksums, num_pages * sizeof(uint32_t), first * sizeof(uint32_t)) < 0) {
+    LOG_DEBUG("I/O error while writing checksums: %s", strerror(errno));
+  }
+}
+
+bool DiskManager::VerifyChecksum(page_id_t page_id, const char *page_data) {
+  if (page_checksum_mode != PageChecksumMode::VERIFY) {
+    return true;
+  }
+  uint32_t expected = 0;
+  {
+    std::lock_guard<std::mutex> guard(checksum_latch_);
+    if (static_cast<size_t>(page_id) < checksums_.size()) {
+      expected = checksums_[page_id];
+    }
+  }
+  if (expected == 0 || PageChecksum(page_data) == expected) {
+    return true;
+  }
+  num_checksum_failures_++;
+  LOG_DEBUG("checksum mismatch on page %d", page_id);
+  return false;
+}
+
+DiskIOBackend *DiskManager::GetAsyncBackend() {
+  std::call_once(async_backend_once_, [&] {
+    async_backend_ = DiskIOBackend::Create(db_fd_, disk_io_queue_depth, enable_io_uring, direct_io_);
+  });
+  return async_backend_.get();
 }
 
 /**
@@ -127,6 +545,10 @@ void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
  * Only return when sync is done, and only perform sequence write
  */
 void DiskManager::WriteLog(char *log_data, int size) {
+  if (read_only_) {
+    LOG_DEBUG("can't write the log of a read-only db file");
+    return;
+  }
   // enforce swap log buffer
   assert(log_data != buffer_used);
   buffer_used = log_data;
@@ -143,16 +565,22 @@ void DiskManager::WriteLog(char *log_data, int size) {
   }
 
   num_flushes_ += 1;
-  // sequence write
-  log_io_.write(log_data, size);
-
-  // check for I/O error
-  if (log_io_.bad()) {
-    LOG_DEBUG("I/O error while writing log");
+  // sequence write, then sync so that the records are durable once this returns
+  for (int written = 0; written < size;) {
+    ssize_t result = write(log_fd_, log_data + written, size - written);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result <= 0) {
+      LOG_DEBUG("I/O error while writing log: %s", strerror(errno));
+      return;
+    }
+    written += result;
+  }
+  if (fdatasync(log_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing log: %s", strerror(errno));
     return;
   }
-  // needs to flush to keep disk file in sync
-  log_io_.flush();
   flush_log_ = false;
 }
 
@@ -162,22 +590,28 @@ void DiskManager::WriteLog(char *log_data, int size) {
  * @return: false means already reach the end
  */
 bool DiskManager::ReadLog(char *log_data, int size, int offset) {
-  if (offset >= GetFileSize(log_name_)) {
+  if (read_only_ || offset >= GetFileSize(log_name_)) {
     // LOG_DEBUG("end of log file");
     // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
     return false;
   }
-  log_io_.seekp(offset);
-  log_io_.read(log_data, size);
-
-  if (log_io_.bad()) {
-    LOG_DEBUG("I/O error while reading log");
-    return false;
+  int read_count = 0;
+  while (read_count < size) {
+    ssize_t result = pread(log_fd_, log_data + read_count, size - read_count, offset + read_count);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result < 0) {
+      LOG_DEBUG("I/O error while reading log: %s", strerror(errno));
+      return false;
+    }
+    if (result == 0) {
+      break;
+    }
+    read_count += result;
   }
   // if log file ends before reading "size"
-  int read_count = log_io_.gcount();
   if (read_count < size) {
-    log_io_.clear();
     memset(log_data + read_count, 0, size - read_count);
   }
 
@@ -186,16 +620,170 @@ bool DiskManager::ReadLog(char *log_data, int size, int offset) {
 
 /**
  * Allocate new page (operations like create index/table)
- * For now just keep an increasing counter
+ * Reuse the lowest deallocated page of the requested residue class, or extend the file
  */
-page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
+page_id_t DiskManager::AllocatePage(uint32_t stride, uint32_t offset) {
+  BUSTUB_ASSERT(offset < stride, "offset must be below the stride");
+  if (read_only_) {
+    return INVALID_PAGE_ID;
+  }
+  auto first_of_class = [&](page_id_t page_id) {
+    return page_id + static_cast<page_id_t>((stride + offset - static_cast<uint32_t>(page_id) % stride) % stride);
+  };
+  std::lock_guard<std::mutex> guard(allocation_latch_);
+  page_id_t end = next_page_id_;
+  page_id_t page_id = INVALID_PAGE_ID;
+  // Only scan when some page below the end is free.
+  if (num_allocated_pages_ < static_cast<size_t>(end)) {
+    for (page_id_t candidate = first_of_class(first_free_hint_); candidate < end;) {
+      size_t word = static_cast<size_t>(candidate) / 64;
+      if (stride == 1 && candidate % 64 == 0 && word < allocated_.size() && allocated_[word] == ~uint64_t{0}) {
+        candidate += 64;
+        continue;
+      }
+      if (!IsAllocatedLocked(candidate)) {
+        page_id = candidate;
+        break;
+      }
+      candidate += static_cast<page_id_t>(stride);
+    }
+  }
+  if (page_id == INVALID_PAGE_ID) {
+    page_id = first_of_class(end);
+  }
+  if (stride == 1) {
+    // every page between the hint and this one is allocated
+    first_free_hint_ = page_id + 1;
+  }
+  SetAllocated(page_id, true);
+  next_page_id_ = std::max(end, page_id + 1);
+  return page_id;
+}
 
 /**
  * Deallocate page (operations like drop index/table)
- * Need bitmap in header page for tracking pages
- * This does not actually need to do anything for now.
+ * The page may be handed out again by AllocatePage
  */
-void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {}
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(allocation_latch_);
+  if (read_only_ || page_id < 0 || !IsAllocatedLocked(page_id)) {
+    return;
+  }
+  SetAllocated(page_id, false);
+  first_free_hint_ = std::min(first_free_hint_, page_id);
+  if (page_table_ != nullptr) {
+    // the sectors of the page can be reused right away
+    page_table_->Unmap(page_id);
+  }
+}
+
+bool DiskManager::IsAllocated(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(allocation_latch_);
+  return page_id >= 0 && IsAllocatedLocked(page_id);
+}
+
+bool DiskManager::IsAllocatedLocked(page_id_t page_id) const {
+  size_t word = static_cast<size_t>(page_id) / 64;
+  return word < allocated_.size() && (allocated_[word] & (uint64_t{1} << (page_id % 64))) != 0;
+}
+
+void DiskManager::SetAllocated(page_id_t page_id, bool allocated) {
+  size_t word = static_cast<size_t>(page_id) / 64;
+  if (word >= allocated_.size()) {
+    allocated_.resize(std::max(word + 1, 2 * allocated_.size()), 0);
+  }
+  uint64_t bit = uint64_t{1} << (page_id % 64);
+  allocated_[word] = allocated ? allocated_[word] | bit : allocated_[word] & ~bit;
+  num_allocated_pages_ = allocated ? num_allocated_pages_ + 1 : num_allocated_pages_ - 1;
+  // Only the word that changed is written; the map is small and stays in the page cache.
+  if (fsm_fd_ >= 0 && !read_only_ &&
+      pwrite(fsm_fd_, &allocated_[word], sizeof(uint64_t), word * sizeof(uint64_t)) < 0) {
+    LOG_DEBUG("I/O error while writing the free space map: %s", strerror(errno));
+  }
+}
+
+int DiskManager::OpenSideFile(const std::string &name, bool db_file_existed, off_t *size) {
+  struct stat stat_buf;
+  if (read_only_) {
+    int fd = open(name.c_str(), O_RDONLY);
+    *size = fd >= 0 && fstat(fd, &stat_buf) == 0 ? stat_buf.st_size : 0;
+    return fd;
+  }
+  int fd = open(name.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    throw Exception("can't open " + name);
+  }
+  *size = fstat(fd, &stat_buf) == 0 ? stat_buf.st_size : 0;
+  if (!db_file_existed && *size != 0) {
+    if (ftruncate(fd, 0) != 0) {
+      LOG_DEBUG("can't truncate %s", name.c_str());
+    }
+    *size = 0;
+  }
+  return fd;
+}
+
+void DiskManager::LoadFreeSpaceMap(bool db_file_existed) {
+  off_t fsm_size;
+  fsm_fd_ = OpenSideFile(fsm_name_, db_file_existed, &fsm_size);
+  if (!db_file_existed) {
+    return;
+  }
+  if (fsm_size == 0) {
+    // A db file from before there was a free space map: every page in the file is taken to be allocated.
+    for (page_id_t page_id = 0; page_id < db_file_size_ / PAGE_SIZE; ++page_id) {
+      SetAllocated(page_id, true);
+    }
+  } else {
+    allocated_.resize(fsm_size / sizeof(uint64_t), 0);
+    if (pread(fsm_fd_, allocated_.data(), allocated_.size() * sizeof(uint64_t), 0) < 0) {
+      throw Exception("can't read free space map");
+    }
+    for (uint64_t word : allocated_) {
+      num_allocated_pages_ += __builtin_popcountll(word);
+    }
+  }
+  // The next page id is one past the last allocated page, not the end of the file: pages may be allocated before
+  // they are first written.
+  for (size_t word = allocated_.size(); word > 0; --word) {
+    if (allocated_[word - 1] != 0) {
+      next_page_id_ = static_cast<page_id_t>((word - 1) * 64 + 64 - __builtin_clzll(allocated_[word - 1]));
+      break;
+    }
+  }
+}
+
+void DiskManager::LoadCompressedPageTable(bool db_file_existed) {
+  struct stat stat_buf;
+  bool has_table = db_file_existed && stat(map_name_.c_str(), &stat_buf) == 0 && stat_buf.st_size > 0;
+  bool db_file_empty = !db_file_existed || (stat(file_name_.c_str(), &stat_buf) == 0 && stat_buf.st_size == 0);
+  if (read_only_) {
+    if (has_table) {
+      throw Exception("can't map a compressed db file");
+    }
+    return;
+  }
+  // Once pages have been written, the db file keeps its layout whatever enable_page_compression says.
+  if (!has_table && !(db_file_empty && enable_page_compression)) {
+    if (!db_file_existed) {
+      unlink(map_name_.c_str());
+    }
+    return;
+  }
+  off_t map_size;
+  int map_fd = OpenSideFile(map_name_, db_file_existed, &map_size);
+  page_table_ = std::make_unique<CompressedPageTable>(map_fd, map_size);
+}
+
+void DiskManager::LoadChecksums(bool db_file_existed) {
+  off_t crc_size;
+  crc_fd_ = OpenSideFile(crc_name_, db_file_existed, &crc_size);
+  // A db file from before there were checksums has none, so its pages are not verified until they are written.
+  checksums_.resize(crc_size / sizeof(uint32_t), 0);
+  if (crc_size != 0 && pread(crc_fd_, checksums_.data(), checksums_.size() * sizeof(uint32_t), 0) < 0) {
+    throw Exception("can't read checksums");
+  }
+}
 
 /**
  * Returns number of flushes made so far
@@ -212,6 +800,13 @@ int DiskManager::GetNumWrites() const { return num_writes_; }
  */
 bool DiskManager::GetFlushState() const { return flush_log_; }
 
+void DiskManager::GrowFileSize(page_id_t page_id) {
+  int64_t end = (static_cast<int64_t>(page_id) + 1) * PAGE_SIZE;
+  int64_t size = db_file_size_.load();
+  while (size < end && !db_file_size_.compare_exchange_weak(size, end)) {
+  }
+}
+
 /**
  * Private helper function to get disk file size
  */
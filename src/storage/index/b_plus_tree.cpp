@@ -11,6 +11,7 @@
 
 #include "storage/index/b_plus_tree.h"
 #include <string>
+#include <type_traits>
 #include "common/exception.h"
 #include "common/rid.h"
 #include "storage/page/header_page.h"
@@ -42,36 +43,25 @@ bool BPLUSTREE_TYPE::IsEmpty() const { return root_page_id_ == INVALID_PAGE_ID;
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) {
-  dummy_page.RLatch();
+  root_latch_.RLock();
   if (IsEmpty()) {
-    dummy_page.RUnlatch();
+    root_latch_.RUnlock();
     return false;
   }
-  Page *page = buffer_pool_manager_->FetchPage(root_page_id_);
-  page->RLatch();
-  dummy_page.RUnlatch();
-  TreePage *p = reinterpret_cast<TreePage *>(page->GetData());
+  auto guard = buffer_pool_manager_->FetchPageRead(root_page_id_);
+  root_latch_.RUnlock();
+  auto p = guard.template As<TreePage>();
   while (!p->IsLeafPage()) {
-    // cast to leaf page
-    // auto internalNode = static_cast<InternalPage *>(p);
-    page_id_t childPid;
-    childPid = static_cast<InternalPage *>(p)->Lookup(key, comparator_);
-
-    Page *childPage = buffer_pool_manager_->FetchPage(childPid);
-    childPage->RLatch();
-    page->RUnlatch();
-    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
-    page = childPage;
-    p = reinterpret_cast<TreePage *>(childPage->GetData());
-  }
-  LeafPage *targetLeaf = static_cast<LeafPage *>(p);
+    // the child is latched before the assignment releases its parent
+    guard = buffer_pool_manager_->FetchPageRead(static_cast<const InternalPage *>(p)->Lookup(key, comparator_));
+    p = guard.template As<TreePage>();
+  }
+  auto targetLeaf = static_cast<const LeafPage *>(p);
 
   ValueType value{};
   if (targetLeaf->Lookup(key, &value, comparator_)) {
     result->push_back(value);
   }
-  page->RUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
   return !result->empty();
 }
 
@@ -100,76 +90,37 @@ bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
 // assuming that no split needed, if not,return false immediately
 INDEX_TEMPLATE_ARGUMENTS
 int BPLUSTREE_TYPE::optimisticInsert(const KeyType &key, const ValueType &value, Transaction *transaction) {
-  std::deque<Page *> rLatchPages;
-  dummy_page.RLatch();
-  rLatchPages.push_back(&dummy_page);
+  std::deque<ReadPageGuard> rLatchPages;
+  root_latch_.RLock();
+  bool root_latched = true;
   if (IsEmpty()) {  // 这种情况属于需要修改root_page_id，所以应该直接失败，交给concurrentInsert处理
-    dummy_page.RUnlatch();
+    root_latch_.RUnlock();
     return 0;
   }
   // 0. find the leaf treePage
-  Page *page = buffer_pool_manager_->FetchPage(root_page_id_);
-  BPlusTreePage *treePage = reinterpret_cast<BPlusTreePage *>(page->GetData());
-  if (treePage->IsLeafPage()) {
-    page->WLatch();
-  } else {
-    page->RLatch();
-    rLatchPages.push_back(page);
-  }
-  while (!treePage->IsLeafPage()) {
-    page_id_t childPid = static_cast<InternalPage *>(treePage)->Lookup(key, comparator_);
-    Page *childPage = buffer_pool_manager_->FetchPage(childPid);
-    BPlusTreePage *childTreePage = reinterpret_cast<BPlusTreePage *>(childPage->GetData());
-
-    // 能不能在这里，先判断它是不是leaf node,如果是就直接获取wlatch.判断的时候就读取了page数据...读取就必须获取rlatch?
-    // 不影响
-    if (childTreePage->IsLeafPage()) {
-      childPage->WLatch();
-    } else {
-      childPage->RLatch();
-      rLatchPages.push_back(childPage);
-    }
-
-    if (childTreePage->IsSafeForInsert()) {  // can release all latches above
-      // unlatch and unpin
-      // TO DO(rewindding): figure out unlock order.. top-down or down-top
-      while (rLatchPages.size() > 1) {  // 不能unlach此时的childPage
-        Page *p = rLatchPages.front();
-        rLatchPages.pop_front();
-        p->RUnlatch();
-        buffer_pool_manager_->UnpinPage(p->GetPageId(), false);
-      }
+  // 能不能在这里，先判断它是不是leaf node,如果是就直接获取wlatch.判断的时候就读取了page数据...读取就必须获取rlatch?
+  // 不影响
+  auto guard = buffer_pool_manager_->FetchPageBasic(root_page_id_);
+  while (!guard.template As<TreePage>()->IsLeafPage()) {
+    rLatchPages.push_back(guard.UpgradeRead());
+    auto node = rLatchPages.back().template As<InternalPage>();
+    if (node->IsSafeForInsert()) {  // can release all latches above
+      ReleaseAncestors(&rLatchPages, &root_latched);
     }
-    page = childPage;
-    treePage = childTreePage;
+    guard = buffer_pool_manager_->FetchPageBasic(node->Lookup(key, comparator_));
   }
   // 此时一定获取了target page的WLatch.
-  if (!treePage->IsSafeForInsert()) {  // should split! optimistic insert failed.
-    // unlatch and unpin all before return
-    while (!rLatchPages.empty()) {
-      Page *p = rLatchPages.front();
-      rLatchPages.pop_front();
-      p->RUnlatch();
-      buffer_pool_manager_->UnpinPage(p->GetPageId(), false);
-    }
-    page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  auto leaf_guard = guard.UpgradeWrite();
+  bool safe = leaf_guard.template As<LeafPage>()->IsSafeForInsert();
+  // the leaf is all that is left to change, the guards release the rest on return
+  ReleaseAncestors(&rLatchPages, &root_latched);
+  if (!safe) {  // should split! optimistic insert failed.
     return 0;
   }
   // don't need split
-  int size = reinterpret_cast<LeafPage *>(treePage)->GetSize();
-  int insertSize = reinterpret_cast<LeafPage *>(treePage)->Insert(key, value, comparator_);
-
-  // unlatch and unpin all before return
-  while (!rLatchPages.empty()) {
-    Page *p = rLatchPages.front();
-    rLatchPages.pop_front();
-    p->RUnlatch();
-    buffer_pool_manager_->UnpinPage(p->GetPageId(), false);
-  }
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
-
+  auto leaf = leaf_guard.template AsMut<LeafPage>();
+  int size = leaf->GetSize();
+  int insertSize = leaf->Insert(key, value, comparator_);
   if (size + 1 != insertSize) {
     return -1;  // duplicate key insert failed.
   }
@@ -177,65 +128,41 @@ int BPLUSTREE_TYPE::optimisticInsert(const KeyType &key, const ValueType &value,
   return 1;
 }
 
-// question :what happened if i lock a page and unpin this page?
 // get latch and insert to the whole tree
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::concurrentInsert(const KeyType &key, const ValueType &value, Transaction *transaction) {
   // this should not be a empty tree when this function been called
-  std::deque<Page *> wLatchPages;
-  dummy_page.WLatch();
-  wLatchPages.push_back(&dummy_page);
+  std::deque<WritePageGuard> wLatchPages;
+  root_latch_.WLock();
+  bool root_latched = true;
   if (IsEmpty()) {
     try {
       StartNewTree(key, value);
     } catch (char *exception) {
-      dummy_page.WUnlatch();
+      root_latch_.WUnlock();
       return false;
     }
-    // no need to unpin.
-    dummy_page.WUnlatch();
+    root_latch_.WUnlock();
     return true;
   }
-  Page *root_page = buffer_pool_manager_->FetchPage(root_page_id_);
-  root_page->WLatch();
-  wLatchPages.push_back(root_page);
-
-  TreePage *treePage = reinterpret_cast<TreePage *>(root_page->GetData());
-  // unlock this only if root page is safe to insert
-
-  while (!treePage->IsLeafPage()) {
-    // get the child page
-    // cast to internal node
-    page_id_t child_page_id = static_cast<InternalPage *>(treePage)->Lookup(key, comparator_);
-    Page *childPage = buffer_pool_manager_->FetchPage(child_page_id);
-    childPage->WLatch();
-    TreePage *child_node = reinterpret_cast<TreePage *>(childPage->GetData());
-    if (child_node->IsSafeForInsert()) {
+  // unlock the root only once a page below it is safe to insert
+  wLatchPages.push_back(buffer_pool_manager_->FetchPageWrite(root_page_id_));
+  while (!wLatchPages.back().template As<TreePage>()->IsLeafPage()) {
+    page_id_t child_page_id = wLatchPages.back().template As<InternalPage>()->Lookup(key, comparator_);
+    wLatchPages.push_back(buffer_pool_manager_->FetchPageWrite(child_page_id));
+    if (wLatchPages.back().template As<TreePage>()->IsSafeForInsert()) {
       // this node is safe, release all the latches above (unlock and unpin)
-      while (!wLatchPages.empty()) {
-        Page *p = wLatchPages.front();
-        wLatchPages.pop_front();
-        p->WUnlatch();
-        buffer_pool_manager_->UnpinPage(p->GetPageId(), false);
-      }
+      ReleaseAncestors(&wLatchPages, &root_latched);
     }
-    wLatchPages.push_back(childPage);
-    treePage = child_node;
   }
-  LeafPage *targetLeafTreePage = static_cast<LeafPage *>(treePage);
+  LeafPage *targetLeafTreePage = wLatchPages.back().template AsMut<LeafPage>();
   int pageSize = targetLeafTreePage->GetSize();
   int insertSize = targetLeafTreePage->Insert(key, value, comparator_);
   if (targetLeafTreePage->GetSize() >= targetLeafTreePage->GetMaxSize()) {  // leaf node should split
     Split<LeafPage>(targetLeafTreePage);
   }
-  // release all the latches
-  // unpin all the pages here
-  while (!wLatchPages.empty()) {
-    Page *p = wLatchPages.front();
-    wLatchPages.pop_front();
-    p->WUnlatch();
-    buffer_pool_manager_->UnpinPage(p->GetPageId(), p->GetPageId() == targetLeafTreePage->GetPageId());
-  }
+  // release all the latches, the guards unpin the pages
+  ReleaseAncestors(&wLatchPages, &root_latched);
   // LOG_DEBUG("con insert,key:%lld\n",key.ToString());
   return pageSize + 1 == insertSize;
 }
@@ -248,17 +175,16 @@ bool BPLUSTREE_TYPE::concurrentInsert(const KeyType &key, const ValueType &value
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
   page_id_t root_page_id;
-  Page *root_page = buffer_pool_manager_->NewPage(&root_page_id);
-  if (root_page == nullptr) {
+  auto root_guard = buffer_pool_manager_->NewPageGuarded(&root_page_id);
+  if (!root_guard) {
     throw "out of memory";
   }
-  LeafPage *root_node = reinterpret_cast<LeafPage *>(root_page->GetData());  // 此时root是leaf node？
+  LeafPage *root_node = root_guard.template AsMut<LeafPage>();  // 此时root是leaf node？
   root_node->Init(root_page_id, INVALID_PAGE_ID, leaf_max_size_);
   // insert
   root_node->Insert(key, value, comparator_);
   root_page_id_ = root_page_id;
   UpdateRootPageId(1);
-  buffer_pool_manager_->UnpinPage(root_page->GetPageId(), true);
 }
 
 /*
@@ -271,18 +197,17 @@ void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction) {
-  Page *leaf_page = FindLeafPage(key);
-  B_PLUS_TREE_LEAF_PAGE_TYPE *leaf_node = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(leaf_page->GetData());
+  auto leaf_guard = FindLeafPage(key);
+  auto leaf_node = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(leaf_guard.GetPage()->GetData());
   // if duplicate key,return false
   if (leaf_node->Lookup(key, new ValueType{}, comparator_)) {
-    buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);
     return false;
   }
+  leaf_guard.MarkDirty();
   int size = leaf_node->Insert(key, value, comparator_);
   if (size >= leaf_node->GetMaxSize()) {  // should split
     Split<LeafPage>(leaf_node);
   }
-  buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), true);
   return true;
 }
 
@@ -299,15 +224,14 @@ INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 N *BPLUSTREE_TYPE::Split(N *node) {
   page_id_t pid;
-  Page *new_right_page = buffer_pool_manager_->NewPage(&pid);
-  if (!new_right_page) {
+  auto new_right_guard = buffer_pool_manager_->NewPageGuarded(&pid);
+  if (!new_right_guard) {
     throw "out of memory";
   }
-  N *new_right_node = reinterpret_cast<N *>(new_right_page->GetData());
+  N *new_right_node = new_right_guard.template AsMut<N>();
   new_right_node->Init(pid, node->GetParentPageId(), node->IsLeafPage() ? leaf_max_size_ : internal_max_size_);
   node->MoveHalfTo(new_right_node, buffer_pool_manager_);
   InsertIntoParent(node, new_right_node->KeyAt(0), new_right_node);
-  buffer_pool_manager_->UnpinPage(new_right_page->GetPageId(), true);
   return new_right_node;
 }
 
@@ -325,29 +249,28 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &ke
                                       Transaction *transaction) {
   if (old_node->IsRootPage()) {  // generate new root
     page_id_t page_id;
-    Page *new_root_page = buffer_pool_manager_->NewPage(&page_id);
-    if (new_root_page == nullptr) {
+    auto new_root_guard = buffer_pool_manager_->NewPageGuarded(&page_id);
+    if (!new_root_guard) {
       return;
     }
-    InternalPage *new_root = reinterpret_cast<InternalPage *>(new_root_page->GetData());
+    InternalPage *new_root = new_root_guard.template AsMut<InternalPage>();
     new_root->Init(page_id, INVALID_PAGE_ID, internal_max_size_);
     new_root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
-    old_node->SetParentPageId(new_root->GetPageId());
-    new_node->SetParentPageId(new_root->GetPageId());
-    buffer_pool_manager_->UnpinPage(new_root->GetPageId(), true);
-    // update root info
-    root_page_id_ = new_root->GetPageId();
+    old_node->SetParentPageId(page_id);
+    new_node->SetParentPageId(page_id);
+    // update root info; new_root is not read once the guard has unpinned the page
+    root_page_id_ = page_id;
     UpdateRootPageId(0);
+    new_root_guard.Drop();
     return;
   }
-  Page *parent_page = buffer_pool_manager_->FetchPage(old_node->GetParentPageId());
-  InternalPage *parent_node = reinterpret_cast<InternalPage *>(parent_page->GetData());
+  auto parent_guard = buffer_pool_manager_->FetchPageBasic(old_node->GetParentPageId());
+  InternalPage *parent_node = parent_guard.template AsMut<InternalPage>();
   int size = parent_node->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
   new_node->SetParentPageId(old_node->GetParentPageId());
   if (size > internal_max_size_) {
     Split<InternalPage>(parent_node);
   }
-  buffer_pool_manager_->UnpinPage(parent_node->GetPageId(), true);
 }
 
 /*****************************************************************************
@@ -370,68 +293,32 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
 }
 INDEX_TEMPLATE_ARGUMENTS
 int BPLUSTREE_TYPE::optimisticDelete(const KeyType &key, Transaction *transaction) {
-  auto rLatchPages = transaction->GetPageSet();
-  dummy_page.RLatch();
-  rLatchPages->push_back(&dummy_page);
+  std::deque<ReadPageGuard> rLatchPages;
+  root_latch_.RLock();
+  bool root_latched = true;
   if (IsEmpty()) {
-    dummy_page.RUnlatch();
-    rLatchPages->clear();
+    root_latch_.RUnlock();
     return -1;  // key not exist
   }
   // TO DO 找到插入删除位置 获取锁过程类似，应该封装一个函数公用？
-  Page *page = buffer_pool_manager_->FetchPage(root_page_id_);
-  BPlusTreePage *treePage = reinterpret_cast<BPlusTreePage *>(page->GetData());
-  if (treePage->IsLeafPage()) {
-    page->WLatch();
-  } else {
-    page->RLatch();
-    rLatchPages->push_back(page);
-  }
-  while (!treePage->IsLeafPage()) {
-    Page *childPage = buffer_pool_manager_->FetchPage(static_cast<InternalPage *>(treePage)->Lookup(key, comparator_));
-    TreePage *childTreePage = reinterpret_cast<TreePage *>(childPage->GetData());
-
-    if (childTreePage->IsLeafPage()) {
-      childPage->WLatch();
-    } else {
-      childPage->RLatch();
-      rLatchPages->push_back(childPage);
-    }
-    if (childTreePage->IsSafeForDelete()) {
-      while (rLatchPages->size() > 1) {
-        Page *p = rLatchPages->front();
-        rLatchPages->pop_front();
-        p->RUnlatch();
-        buffer_pool_manager_->UnpinPage(p->GetPageId(), false);
-      }
+  auto guard = buffer_pool_manager_->FetchPageBasic(root_page_id_);
+  while (!guard.template As<TreePage>()->IsLeafPage()) {
+    rLatchPages.push_back(guard.UpgradeRead());
+    auto node = rLatchPages.back().template As<InternalPage>();
+    if (node->IsSafeForDelete()) {
+      ReleaseAncestors(&rLatchPages, &root_latched);
     }
-    page = childPage;
-    treePage = childTreePage;
-  }
-  LeafPage *targetLeaf = static_cast<LeafPage *>(treePage);
-  if (!targetLeaf->IsSafeForDelete()) {
-    while (!rLatchPages->empty()) {
-      Page *p = rLatchPages->front();
-      rLatchPages->pop_front();
-      p->RUnlatch();
-      buffer_pool_manager_->UnpinPage(p->GetPageId(), false);
-    }
-    page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    guard = buffer_pool_manager_->FetchPageBasic(node->Lookup(key, comparator_));
+  }
+  auto leaf_guard = guard.UpgradeWrite();
+  bool safe = leaf_guard.template As<LeafPage>()->IsSafeForDelete();
+  ReleaseAncestors(&rLatchPages, &root_latched);
+  if (!safe) {
     return 0;
   }
+  auto targetLeaf = leaf_guard.template AsMut<LeafPage>();
   int size = targetLeaf->GetSize();
   int sizeAfterDel = targetLeaf->RemoveAndDeleteRecord(key, comparator_);
-
-  while (!rLatchPages->empty()) {
-    Page *p = rLatchPages->front();
-    rLatchPages->pop_front();
-    p->RUnlatch();
-    buffer_pool_manager_->UnpinPage(p->GetPageId(), false);
-  }
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
-
   if (size == sizeAfterDel) {
     return -1;  // key not exist;
   }
@@ -439,56 +326,39 @@ int BPLUSTREE_TYPE::optimisticDelete(const KeyType &key, Transaction *transactio
 }
 INDEX_TEMPLATE_ARGUMENTS
 int BPLUSTREE_TYPE::concurrentDelete(const KeyType &key, Transaction *transaction) {
-  // std::deque<Page*> wLatchPages;
   auto wLatchPages = transaction->GetPageSet();
-  dummy_page.WLatch();
-  wLatchPages->push_back(&dummy_page);
+  root_latch_.WLock();
+  bool root_latched = true;
   if (IsEmpty()) {
-    dummy_page.WUnlatch();
-    wLatchPages->clear();
+    root_latch_.WUnlock();
     return -1;
   }
-  Page *page = buffer_pool_manager_->FetchPage(root_page_id_);
-  page->WLatch();
-  wLatchPages->push_back(page);
-  TreePage *treePage = reinterpret_cast<TreePage *>(page->GetData());
-  while (!treePage->IsLeafPage()) {
-    Page *childPage = buffer_pool_manager_->FetchPage(static_cast<InternalPage *>(treePage)->Lookup(key, comparator_));
-    TreePage *childTreePage = reinterpret_cast<TreePage *>(childPage->GetData());
-    childPage->WLatch();
-    wLatchPages->push_back(childPage);
-    if (childTreePage->IsSafeForDelete()) {
-      while (wLatchPages->size() > 1) {
-        Page *p = wLatchPages->front();
-        wLatchPages->pop_front();
-        p->WUnlatch();
-        buffer_pool_manager_->UnpinPage(p->GetPageId(), false);
-      }
+  wLatchPages->push_back(buffer_pool_manager_->FetchPageWrite(root_page_id_));
+  while (!wLatchPages->back().template As<TreePage>()->IsLeafPage()) {
+    page_id_t child_page_id = wLatchPages->back().template As<InternalPage>()->Lookup(key, comparator_);
+    wLatchPages->push_back(buffer_pool_manager_->FetchPageWrite(child_page_id));
+    if (wLatchPages->back().template As<TreePage>()->IsSafeForDelete()) {
+      ReleaseAncestors(wLatchPages.get(), &root_latched);
     }
-    treePage = childTreePage;
-    page = childPage;
   }
-  LeafPage *targetLeaf = static_cast<LeafPage *>(treePage);
+  LeafPage *targetLeaf = wLatchPages->back().template AsMut<LeafPage>();
   targetLeaf->RemoveAndDeleteRecord(key, comparator_);
 
   if (targetLeaf->GetSize() < targetLeaf->GetMinSize()) {
     CoalesceOrRedistribute<LeafPage>(targetLeaf, transaction);
   }
   while (!wLatchPages->empty()) {
-    Page *p = wLatchPages->front();
+    page_id_t page_id = wLatchPages->front().PageId();
+    // 直接unpin+delete? 不行，因为没有wunlatch，后面新来的page可能用了原来的page的latch...
     wLatchPages->pop_front();
-    if (transaction->GetDeletedPageSet()->count(p->GetPageId()) == 1U) {
-      transaction->GetDeletedPageSet()->erase(p->GetPageId());
-      // 直接unpin+delete? 不行，因为没有wunlatch，后面新来的page可能用了原来的page的latch...
-      p->WUnlatch();
-      buffer_pool_manager_->UnpinPage(p->GetPageId(), false);
-      buffer_pool_manager_->DeletePage(p->GetPageId());
-    } else {
-      p->WUnlatch();
-      buffer_pool_manager_->UnpinPage(p->GetPageId(), targetLeaf->GetPageId() == p->GetPageId());
+    if (transaction->GetDeletedPageSet()->erase(page_id) == 1U) {
+      buffer_pool_manager_->DeletePage(page_id);
     }
   }
   transaction->GetDeletedPageSet()->clear();
+  if (root_latched) {
+    root_latch_.WUnlock();
+  }
   return 1;
 }
 /*
@@ -515,8 +385,8 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
   bool res = false;
   // get the parent node
   // 在调用之前，一定已经获取parent的wlatch了，所以只需要在return后unpin即可
-  Page *parent_page = buffer_pool_manager_->FetchPage(node->GetParentPageId());
-  InternalPage *parent_node = reinterpret_cast<InternalPage *>(parent_page->GetData());
+  auto parent_guard = buffer_pool_manager_->FetchPageBasic(node->GetParentPageId());
+  InternalPage *parent_node = parent_guard.template AsMut<InternalPage>();
   page_id_t parent_index = parent_node->ValueIndex(node->GetPageId());
   // get the left and right sibling
   int pageMaxSize = node->GetMaxSize();
@@ -524,36 +394,29 @@ bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
     pageMaxSize -= 1;
   }
   if (parent_index - 1 >= 0) {
-    Page *left_page = buffer_pool_manager_->FetchPage(parent_node->ValueAt(parent_index - 1));
-    left_page->WLatch();
-    N *left_sibling = reinterpret_cast<N *>(left_page->GetData());
+    auto left_guard = buffer_pool_manager_->FetchPageWrite(parent_node->ValueAt(parent_index - 1));
+    N *left_sibling = left_guard.template AsMut<N>();
     if (left_sibling->GetSize() + node->GetSize() <= pageMaxSize) {  // merge node to left sibling
       res = true;
       Coalesce<N>(&left_sibling, &node, &parent_node, parent_index, transaction);
     } else {  // redistribute
       Redistribute(left_sibling, node, 1);
     }
-    left_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(left_page->GetPageId(), true);
   } else if (parent_index + 1 < parent_node->GetSize()) {
-    Page *right_page = buffer_pool_manager_->FetchPage(parent_node->ValueAt(parent_index + 1));
-    right_page->WLatch();
-    N *right_sibling = reinterpret_cast<N *>(right_page->GetData());
+    auto right_guard = buffer_pool_manager_->FetchPageWrite(parent_node->ValueAt(parent_index + 1));
+    N *right_sibling = right_guard.template AsMut<N>();
     if (right_sibling->GetSize() + node->GetSize() <= pageMaxSize) {  // merge to right sibling
       // leaf page 在merge的时候要考虑set
       // next_page_id，所以总是从右边合并到左边，如果从左合并到右边，需要更新左边节点前一个节点
       // right page 在这里会被加到deleted page里面
-      transaction->AddIntoPageSet(right_page);
+      transaction->AddIntoPageSet(std::move(right_guard));
       Coalesce<N>(&node, &right_sibling, &parent_node, parent_index + 1, transaction);
     } else {  // redistribute
+      // right page 没有被删除，right_guard unpins it dirty
       Redistribute(right_sibling, node, 0);
-      // right page 没有被删除，应该unpin true，
-      right_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(right_page->GetPageId(), true);
     }
   }
-  // unpin parent pages
-  buffer_pool_manager_->UnpinPage(parent_node->GetPageId(), true);
+  // parent_guard unpins the parent page
   return res;
 }
 
@@ -629,12 +492,9 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
   if (!old_root_node->IsLeafPage() && root_size == 1) {
     root_page_id_ = static_cast<InternalPage *>(old_root_node)->ValueAt(0);
     // TO DO 这里这个page没有获取wlock! 但感觉影响不大，因为没有修改数据，，改的只是parent pid
-    Page *new_root_page = buffer_pool_manager_->FetchPage(root_page_id_);
-    // new_root_page->WLatch();
-    BPlusTreePage *new_root_node = reinterpret_cast<BPlusTreePage *>(new_root_page->GetData());
-    new_root_node->SetParentPageId(INVALID_PAGE_ID);
-    // new_root_page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(root_page_id_, true);
+    auto new_root_guard = buffer_pool_manager_->FetchPageBasic(root_page_id_);
+    new_root_guard.template AsMut<BPlusTreePage>()->SetParentPageId(INVALID_PAGE_ID);
+    new_root_guard.Drop();
     UpdateRootPageId(0);
     return true;
   }
@@ -651,16 +511,9 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_TYPE::begin() {
-  Page *page = buffer_pool_manager_->FetchPage(root_page_id_);
-  BPlusTreePage *btp = reinterpret_cast<BPlusTreePage *>(page->GetData());
-  while (!btp->IsLeafPage()) {
-    auto page_id = reinterpret_cast<InternalPage *>(btp)->ValueAt(0);
-    Page *p = buffer_pool_manager_->FetchPage(page_id);
-    btp = reinterpret_cast<BPlusTreePage *>(p->GetData());
-  }
   // get the left most leaf page id to build the iterator
-  buffer_pool_manager_->UnpinPage(btp->GetPageId(), false);
-  return INDEXITERATOR_TYPE(btp->GetPageId(), 0, buffer_pool_manager_);
+  page_id_t leaf_page_id = FindLeafPage(KeyType{}, true).PageId();
+  return INDEXITERATOR_TYPE(leaf_page_id, 0, buffer_pool_manager_);
 }
 
 /*
@@ -671,17 +524,9 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::begin() {
 // TO DO index iterator read latch
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
-  Page *page = buffer_pool_manager_->FetchPage(root_page_id_);
-  BPlusTreePage *btp = reinterpret_cast<BPlusTreePage *>(page->GetData());
-  while (!btp->IsLeafPage()) {
-    auto page_id = reinterpret_cast<InternalPage *>(btp)->Lookup(key, comparator_);
-    buffer_pool_manager_->UnpinPage(btp->GetPageId(), false);
-    Page *p = buffer_pool_manager_->FetchPage(page_id);
-    btp = reinterpret_cast<BPlusTreePage *>(p->GetData());
-  }
-  int pos = reinterpret_cast<LeafPage *>(btp)->KeyIndex(key, comparator_);
-  buffer_pool_manager_->UnpinPage(btp->GetPageId(), false);
-  return INDEXITERATOR_TYPE(btp->GetPageId(), pos, buffer_pool_manager_);
+  auto leaf_guard = FindLeafPage(key);
+  int pos = leaf_guard.template As<LeafPage>()->KeyIndex(key, comparator_);
+  return INDEXITERATOR_TYPE(leaf_guard.PageId(), pos, buffer_pool_manager_);
 }
 
 /*
@@ -692,18 +537,17 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_TYPE::end() {
   // go to the right most leaf page
-  Page *page = buffer_pool_manager_->FetchPage(root_page_id_);
-  BPlusTreePage *btp = reinterpret_cast<InternalPage *>(page->GetData());
+  auto guard = buffer_pool_manager_->FetchPageBasic(root_page_id_);
+  auto btp = guard.template As<BPlusTreePage>();
   while (!btp->IsLeafPage()) {
     int rightMostIdx = btp->GetSize() - 1;
-    auto page_id = reinterpret_cast<InternalPage *>(btp)->ValueAt(rightMostIdx);
-    buffer_pool_manager_->UnpinPage(btp->GetPageId(), false);
-    Page *p = buffer_pool_manager_->FetchPage(page_id);
-    btp = reinterpret_cast<BPlusTreePage *>(p->GetData());
+    auto page_id = reinterpret_cast<const InternalPage *>(btp)->ValueAt(rightMostIdx);
+    guard.Drop();
+    guard = buffer_pool_manager_->FetchPageBasic(page_id);
+    btp = guard.template As<BPlusTreePage>();
   }
   int rightMostIdx = btp->GetSize();
-  buffer_pool_manager_->UnpinPage(btp->GetPageId(), false);
-  return INDEXITERATOR_TYPE(btp->GetPageId(), rightMostIdx, buffer_pool_manager_);
+  return INDEXITERATOR_TYPE(guard.PageId(), rightMostIdx, buffer_pool_manager_);
 }
 
 /*****************************************************************************
@@ -717,28 +561,47 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::end() {
  * TODO
  */
 INDEX_TEMPLATE_ARGUMENTS
-Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) {
+BasicPageGuard BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) {
   if (IsEmpty()) {
-    return nullptr;
+    return {};
   }
-  Page *page = buffer_pool_manager_->FetchPage(root_page_id_);
-  TreePage *p = reinterpret_cast<TreePage *>(page->GetData());
+  auto guard = buffer_pool_manager_->FetchPageBasic(root_page_id_);
+  auto p = guard.template As<TreePage>();
 
   while (!p->IsLeafPage()) {
     // cast to leaf page
     // auto internalNode = static_cast<InternalPage *>(p);
     page_id_t childPid;
     if (leftMost) {
-      childPid = static_cast<InternalPage *>(p)->ValueAt(0);
+      childPid = static_cast<const InternalPage *>(p)->ValueAt(0);
     } else {
-      childPid = static_cast<InternalPage *>(p)->Lookup(key, comparator_);
+      childPid = static_cast<const InternalPage *>(p)->Lookup(key, comparator_);
     }
-    buffer_pool_manager_->UnpinPage(p->GetPageId(), false);
+    guard.Drop();
+    guard = buffer_pool_manager_->FetchPageBasic(childPid);
+    p = guard.template As<TreePage>();
+  }
+  return guard;
+}
 
-    page = buffer_pool_manager_->FetchPage(childPid);
-    p = reinterpret_cast<TreePage *>(page->GetData());
+/*
+ * Release the latches a descent no longer needs: the root latch, if it is still held, and every page above the last
+ * one latched. Write guards mark their pages dirty themselves, if they were changed.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+template <typename Guard>
+void BPLUSTREE_TYPE::ReleaseAncestors(std::deque<Guard> *guards, bool *root_latched) {
+  if (*root_latched) {
+    if constexpr (std::is_same_v<Guard, WritePageGuard>) {
+      root_latch_.WUnlock();
+    } else {
+      root_latch_.RUnlock();
+    }
+    *root_latched = false;
+  }
+  while (guards->size() > 1) {
+    guards->pop_front();
   }
-  return page;
 }
 
 /*
@@ -751,7 +614,8 @@ Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
-  HeaderPage *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+  auto header_guard = buffer_pool_manager_->FetchPageBasic(HEADER_PAGE_ID);
+  auto header_page = static_cast<HeaderPage *>(header_guard.GetPageMut());
   if (insert_record != 0) {
     // create a new record<index_name + root_page_id> in header_page
     header_page->InsertRecord(index_name_, root_page_id_);
@@ -759,7 +623,6 @@ void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
     // update root_page_id in header_page
     header_page->UpdateRecord(index_name_, root_page_id_);
   }
-  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
 }
 
 /*
@@ -13,44 +13,57 @@ namespace bustub {
  */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::IndexIterator(page_id_t pageId, int Index, BufferPoolManager *bmp)
-    : bufferPoolManager(bmp), leafPageId(pageId), kvIndex(Index) {}
+    : bufferPoolManager(bmp), leafPageId(pageId), kvIndex(Index) {
+  readAhead(leafPageId);
+}
 
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::~IndexIterator() = default;
 
 INDEX_TEMPLATE_ARGUMENTS
 bool INDEXITERATOR_TYPE::isEnd() {
-  Page *page = bufferPoolManager->FetchPage(leafPageId);
-  B_PLUS_TREE_LEAF_PAGE_TYPE *leafPage = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  auto guard = bufferPoolManager->FetchPageBasic(leafPageId);
+  auto leafPage = guard.As<B_PLUS_TREE_LEAF_PAGE_TYPE>();
   if (leafPage->GetNextPageId() != INVALID_PAGE_ID) {
     return false;
   }
-  bufferPoolManager->UnpinPage(page->GetPageId(), false);
   return kvIndex == leafPage->GetSize() - 1;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 const MappingType &INDEXITERATOR_TYPE::operator*() {
-  Page *page = bufferPoolManager->FetchPage(leafPageId);
-  B_PLUS_TREE_LEAF_PAGE_TYPE *leafPage = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
-  bufferPoolManager->UnpinPage(page->GetPageId(), false);
+  auto guard = bufferPoolManager->FetchPageBasic(leafPageId);
+  auto leafPage = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(guard.GetPage()->GetData());
   return leafPage->GetItem(kvIndex);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() {
-  Page *page = bufferPoolManager->FetchPage(leafPageId);
-  B_PLUS_TREE_LEAF_PAGE_TYPE *leafPage = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  auto guard = bufferPoolManager->FetchPageBasic(leafPageId);
+  auto leafPage = guard.As<B_PLUS_TREE_LEAF_PAGE_TYPE>();
   ++kvIndex;
   if (kvIndex >= leafPage->GetSize()) {
     if (leafPage->GetNextPageId() != INVALID_PAGE_ID) {
       kvIndex = 0;
       leafPageId = leafPage->GetNextPageId();
+      if (++leavesSinceReadAhead >= READ_AHEAD_PAGES / 2) {
+        readAhead(leafPageId);
+      }
     }
   }
-  bufferPoolManager->UnpinPage(page->GetPageId(), false);
   return *this;  // ???
 }
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::readAhead(page_id_t pageId) {
+  leavesSinceReadAhead = 0;
+  bufferPoolManager->PrefetchPages(pageId, READ_AHEAD_PAGES, &INDEXITERATOR_TYPE::nextLeafPageIdOf);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t INDEXITERATOR_TYPE::nextLeafPageIdOf(const char *pageData) {
+  return reinterpret_cast<const B_PLUS_TREE_LEAF_PAGE_TYPE *>(pageData)->GetNextPageId();
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 bool INDEXITERATOR_TYPE::operator==(const IndexIterator &itr) const {
   return itr.leafPageId == this->leafPageId && itr.kvIndex == this->kvIndex;
@@ -144,11 +144,10 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveHalfTo(BPlusTreeInternalPage *recipient
   // remember every B tree page is stored on disk!
   // don't forget update their parent_page_id!
   for (int i = GetSize() - s; i < GetSize(); ++i) {
-    Page *child_page = buffer_pool_manager->FetchPage(array[i].second);
+    auto child_guard = buffer_pool_manager->FetchPageBasic(array[i].second);
     // child node 不一定是internal node
-    auto child_page_node = reinterpret_cast<BPlusTreePage *>(child_page->GetData());  // cast to in mem object
+    auto child_page_node = child_guard.template AsMut<BPlusTreePage>();  // cast to in mem object
     child_page_node->SetParentPageId(recipient->GetPageId());
-    buffer_pool_manager->UnpinPage(child_page_node->GetPageId(), true);
   }
   // update size
   IncreaseSize(-s);
@@ -205,18 +204,16 @@ INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(BPlusTreeInternalPage *recipient, int index_in_parent,
                                                BufferPoolManager *buffer_pool_manager) {
   // how to update relevent key & value parin in its parent page? this function doesn't care
-  auto parnet_page = buffer_pool_manager->FetchPage(GetParentPageId());
-  auto parent_node = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE_TYPE *>(parnet_page->GetData());
+  auto parent_guard = buffer_pool_manager->FetchPageBasic(GetParentPageId());
+  auto parent_node = parent_guard.template As<B_PLUS_TREE_INTERNAL_PAGE_TYPE>();
   // move the parent key down
   SetKeyAt(0, parent_node->KeyAt(index_in_parent));
-  buffer_pool_manager->UnpinPage(parent_node->GetPageId(), false);
+  parent_guard.Drop();
   recipient->CopyAllFrom(array, GetSize(), buffer_pool_manager);
   // update child page's parent_page_id property
   for (int i = 0; i < GetSize(); ++i) {
-    auto page = buffer_pool_manager->FetchPage(array[i].second);
-    auto page_node = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE_TYPE *>(page->GetData());
-    page_node->SetParentPageId(recipient->GetPageId());
-    buffer_pool_manager->UnpinPage(page_node->GetPageId(), true);
+    auto child_guard = buffer_pool_manager->FetchPageBasic(array[i].second);
+    child_guard.template AsMut<BPlusTreePage>()->SetParentPageId(recipient->GetPageId());
   }
   SetSize(0);
 }
@@ -242,24 +239,21 @@ INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeInternalPage *recipient,
                                                       BufferPoolManager *buffer_pool_manager) {
   // why should got to the parent page to fetch the key?
-  Page *parent_page = buffer_pool_manager->FetchPage(GetPageId());
-  BPlusTreeInternalPage *parent_node = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE_TYPE *>(parent_page->GetData());
+  auto parent_guard = buffer_pool_manager->FetchPageBasic(GetPageId());
+  auto parent_node = parent_guard.template AsMut<B_PLUS_TREE_INTERNAL_PAGE_TYPE>();
   auto key = parent_node->ValueIndex(GetPageId());
   MappingType pair = std::make_pair(parent_node->KeyAt(key), array[0].second);
   recipient->CopyLastFrom(pair, buffer_pool_manager);
   parent_node->SetKeyAt(key, array[1].first);
   Remove(0);
-  buffer_pool_manager->UnpinPage(parent_node->GetPageId(), true);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager) {
   array[GetSize()] = pair;
   IncreaseSize(1);
-  Page *child_page = buffer_pool_manager->FetchPage(pair.second);
-  auto child_node = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE_TYPE *>(child_page->GetData());
-  child_node->SetParentPageId(GetPageId());
-  buffer_pool_manager->UnpinPage(child_node->GetPageId(), true);
+  auto child_guard = buffer_pool_manager->FetchPageBasic(pair.second);
+  child_guard.template AsMut<BPlusTreePage>()->SetParentPageId(GetPageId());
 }
 
 /*
@@ -269,12 +263,11 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(const MappingType &pair, Buffe
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeInternalPage *recipient,
                                                        BufferPoolManager *buffer_pool_manager) {
-  Page *parent_page = buffer_pool_manager->FetchPage(GetParentPageId());
-  auto parent_node =
-      reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(parent_page->GetData());
+  auto parent_guard = buffer_pool_manager->FetchPageBasic(GetParentPageId());
+  auto parent_node = parent_guard.template As<B_PLUS_TREE_INTERNAL_PAGE_TYPE>();
   page_id_t parent_index =
       parent_node->ValueIndex(GetPageId()) + 1;  // add one,recipient is the right sibling of current node
-  buffer_pool_manager->UnpinPage(parent_page->GetPageId(), false);
+  parent_guard.Drop();
   recipient->CopyFirstFrom(array[GetSize() - 1], parent_index, buffer_pool_manager);
   IncreaseSize(-1);
 }
@@ -282,8 +275,8 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeInternalPage *re
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(const MappingType &pair, int parent_index,
                                                    BufferPoolManager *buffer_pool_manager) {
-  Page *parent_page = buffer_pool_manager->FetchPage(GetParentPageId());
-  BPlusTreeInternalPage *parent_node = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE_TYPE *>(parent_page->GetData());
+  auto parent_guard = buffer_pool_manager->FetchPageBasic(GetParentPageId());
+  auto parent_node = parent_guard.template AsMut<B_PLUS_TREE_INTERNAL_PAGE_TYPE>();
   array[0].first = parent_node->KeyAt(parent_index);
   // memmove(array+1,array,GetSize()*sizeof(pair));
   for (int i = GetSize(); i > 0; --i) {
@@ -292,12 +285,8 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(const MappingType &pair, int
   array[0] = pair;
   parent_node->SetKeyAt(parent_index, pair.first);
 
-  Page *child_page = buffer_pool_manager->FetchPage(pair.second);
-  BPlusTreeInternalPage *child_node = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE_TYPE *>(child_page->GetData());
-  child_node->SetPageId(GetPageId());
-
-  buffer_pool_manager->UnpinPage(GetParentPageId(), true);
-  buffer_pool_manager->UnpinPage(child_node->GetPageId(), true);
+  auto child_guard = buffer_pool_manager->FetchPageBasic(pair.second);
+  child_guard.template AsMut<B_PLUS_TREE_INTERNAL_PAGE_TYPE>()->SetPageId(GetPageId());
   IncreaseSize(1);
 }
 
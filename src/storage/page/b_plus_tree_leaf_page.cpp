@@ -239,12 +239,11 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeLeafPage *recipient,
     array[i] = array[i + 1];
   }
   IncreaseSize(-1);
-  Page *parent_page = buffer_pool_manager->FetchPage(GetParentPageId());
-  auto parent_node =
-      reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(parent_page->GetData());
+  auto parent_guard = buffer_pool_manager->FetchPageBasic(GetParentPageId());
+  auto parent_node = parent_guard.template AsMut<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>>();
   auto key = parent_node->ValueIndex(GetPageId());
   parent_node->SetKeyAt(key, array[0].first);
-  buffer_pool_manager->UnpinPage(parent_page->GetPageId(), true);
+  parent_guard.Drop();
   recipient->CopyLastFrom(pair);
 }
 
@@ -260,11 +259,10 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyLastFrom(const MappingType &item) {
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeLeafPage *recipient,
                                                    BufferPoolManager *buffer_pool_manager) {
-  Page *parent_page = buffer_pool_manager->FetchPage(GetParentPageId());
-  auto parent_node =
-      reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(parent_page->GetData());
+  auto parent_guard = buffer_pool_manager->FetchPageBasic(GetParentPageId());
+  auto parent_node = parent_guard.template As<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>>();
   page_id_t parentIndex = parent_node->ValueIndex(GetPageId());
-  buffer_pool_manager->UnpinPage(parent_page->GetPageId(), false);
+  parent_guard.Drop();
   recipient->CopyFirstFrom(array[GetSize() - 1], parentIndex + 1, buffer_pool_manager);
   IncreaseSize(-1);
 }
@@ -272,11 +270,10 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeLeafPage *recipient,
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyFirstFrom(const MappingType &item, int parentIndex,
                                                BufferPoolManager *buffer_pool_manager) {
-  Page *parent_page = buffer_pool_manager->FetchPage(GetParentPageId());
-  auto parent_node =
-      reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(parent_page->GetData());
+  auto parent_guard = buffer_pool_manager->FetchPageBasic(GetParentPageId());
+  auto parent_node = parent_guard.template AsMut<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>>();
   parent_node->SetKeyAt(parentIndex, item.first);
-  buffer_pool_manager->UnpinPage(parent_page->GetPageId(), true);
+  parent_guard.Drop();
   // memmove(array+1,array,sizeof(MappingType)*GetSize());
   for (int i = GetSize(); i > 0; --i) {
     array[i] = array[i - 1];
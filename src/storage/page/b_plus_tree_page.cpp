@@ -77,11 +77,11 @@ void BPlusTreePage::SetPageId(page_id_t page_id) { page_id_ = page_id; }
  */
 void BPlusTreePage::SetLSN(lsn_t lsn) { lsn_ = lsn; }
 
-bool BPlusTreePage::IsSafeForInsert() {
+bool BPlusTreePage::IsSafeForInsert() const {
   if (IsLeafPage()) {
     return size_ + 1 < GetMaxSize();
   }
   return size_ < GetMaxSize();
 }
-bool BPlusTreePage::IsSafeForDelete() { return size_ - 1 >= GetMinSize(); }
+bool BPlusTreePage::IsSafeForDelete() const { return size_ - 1 >= GetMinSize(); }
 }  // namespace bustub
@@ -19,6 +19,7 @@ namespace bustub {
 TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
     : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
+    ReadAhead(rid.GetPageId());
     table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
   }
 }
@@ -35,19 +36,20 @@ Tuple *TableIterator::operator->() {
 
 TableIterator &TableIterator::operator++() {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
-  cur_page->RLatch();
-  assert(cur_page != nullptr);  // all pages are pinned
+  auto cur_guard = buffer_pool_manager->FetchPageRead(tuple_->rid_.GetPageId());
+  assert(cur_guard);  // all pages are pinned
+  auto cur_page = static_cast<TablePage *>(cur_guard.GetPage());
 
   RID next_tuple_rid;
   if (!cur_page->GetNextTupleRid(tuple_->rid_,
                                  &next_tuple_rid)) {  // end of this page
     while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
-      cur_page->RUnlatch();
-      buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
-      cur_page = next_page;
-      cur_page->RLatch();
+      cur_guard = buffer_pool_manager->FetchPageRead(cur_page->GetNextPageId());
+      cur_page = static_cast<TablePage *>(cur_guard.GetPage());
+      // Keep the read-ahead window half a window in front of us, so the pages ahead are requested before we need them.
+      if (++pages_since_read_ahead_ >= READ_AHEAD_PAGES / 2) {
+        ReadAhead(cur_page->GetNextPageId());
+      }
       if (cur_page->GetFirstTupleRid(&next_tuple_rid)) {
         break;
       }
@@ -58,12 +60,15 @@ TableIterator &TableIterator::operator++() {
   if (*this != table_heap_->End()) {
     table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
   }
-  // release until copy the tuple
-  cur_page->RUnlatch();
-  buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
+  // cur_guard releases the page only after the tuple is copied
   return *this;
 }
 
+void TableIterator::ReadAhead(page_id_t page_id) {
+  pages_since_read_ahead_ = 0;
+  table_heap_->buffer_pool_manager_->PrefetchPages(page_id, READ_AHEAD_PAGES, &TablePage::NextPageIdOf);
+}
+
 TableIterator TableIterator::operator++(int) {
   TableIterator clone(*this);
   ++(*this);
@@ -11,10 +11,17 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/buffer_pool_manager.h"
+#include <sys/stat.h>
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <iostream>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 #include "common/logger.h"
+#include "recovery/log_manager.h"
 #include "gtest/gtest.h"
 
 namespace bustub {
@@ -141,4 +148,829 @@ TEST(BufferPoolManagerTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+// Disk I/O runs without the latch, so concurrent misses, hits and evictions must never expose a half-read page.
+TEST(BufferPoolManagerTest, ConcurrentFetchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+  const int num_pages = 16;
+  const int num_threads = 4;
+  const int rounds = 50;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, page_id_temp);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    // Leave the pages dirty so that evictions have to write them back.
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([bpm, tid] {
+      for (int round = 0; round < rounds; ++round) {
+        // Every thread walks the same pages, so fetchers of one page id regularly overlap.
+        page_id_t page_id = (round + tid / 2) % num_pages;
+        Page *page = bpm->FetchPage(page_id);
+        while (page == nullptr) {
+          std::this_thread::yield();
+          page = bpm->FetchPage(page_id);
+        }
+        EXPECT_EQ(page_id, page->GetPageId());
+        EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, round % 2 == 0));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// The page cleaner writes dirty pages back ahead of time, so evictions should not have to.
+TEST(BufferPoolManagerTest, PageCleanerTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: Fill the pool with dirty pages, then let the cleaner bring the dirty ratio down to zero.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  bpm->RunPageCleaner(0.5, 0.0, 0);
+  for (int i = 0; i < 100 && bpm->GetBackgroundWriteCount() < buffer_pool_size; ++i) {
+    std::this_thread::sleep_for(page_cleaner_interval);
+  }
+  bpm->StopPageCleaner();
+  EXPECT_EQ(buffer_pool_size, bpm->GetBackgroundWriteCount());
+
+  // Scenario: Replacing every page in the pool only evicts clean victims.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id_temp;
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+  EXPECT_EQ(0, bpm->GetForegroundWriteCount());
+
+  // Scenario: The pages written by the cleaner can be read back.
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size); ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// PrefetchPages follows a chain of pages in the background and leaves them in the pool unpinned.
+TEST(BufferPoolManagerTest, PrefetchPagesTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 20;
+  const int num_pages = 40;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: Build a chain that visits the pages in reverse order, each page storing the id of the next one.
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    page_id_t next_page_id = page_id_temp == 0 ? INVALID_PAGE_ID : page_id_temp - 1;
+    memcpy(page->GetData(), &next_page_id, sizeof(page_id_t));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  // Pages 0 .. 19 have been evicted by now.
+  auto next_page_id = [](const char *page_data) { return *reinterpret_cast<const page_id_t *>(page_data); };
+  bpm->PrefetchPages(15, 5, next_page_id);
+
+  // A page counts as prefetched once it is in the pool and the prefetch thread no longer pins it.
+  auto is_resident = [&](page_id_t page_id) {
+    Page *pages = bpm->GetPages();
+    for (size_t i = 0; i < buffer_pool_size; ++i) {
+      if (pages[i].GetPageId() == page_id && pages[i].GetPinCount() == 0) {
+        return true;
+      }
+    }
+    return false;
+  };
+  for (int i = 0; i < 100 && !is_resident(11); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  // Scenario: The pool holds pages 15, 14, 13, 12 and 11, unpinned and with the content that was written.
+  for (page_id_t page_id = 11; page_id <= 15; ++page_id) {
+    EXPECT_TRUE(is_resident(page_id));
+  }
+  EXPECT_FALSE(is_resident(10));
+  for (page_id_t page_id = 11; page_id <= 15; ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(1, page->GetPinCount());
+    EXPECT_EQ(page_id - 1, next_page_id(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// Hits pin and unpin frames without the latch while misses evict and reassign them under it.
+TEST(BufferPoolManagerTest, OptimisticPinTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 8;
+  const int num_pages = 12;
+  const int num_threads = 4;
+  const int rounds = 2000;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr,
+                                    BufferPoolManager::ReplacerType::LOCK_FREE_CLOCK);
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: The threads mostly hit the first pages and now and then miss on the others, so frames are reassigned
+  // while other threads look them up without the latch.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([bpm, tid] {
+      std::mt19937 rng(tid);
+      std::uniform_int_distribution<int> hot_dist(0, 3);
+      std::uniform_int_distribution<int> page_dist(0, num_pages - 1);
+      for (int round = 0; round < rounds; ++round) {
+        page_id_t page_id = round % 8 == 0 ? page_dist(rng) : hot_dist(rng);
+        Page *page = bpm->FetchPage(page_id);
+        while (page == nullptr) {
+          std::this_thread::yield();
+          page = bpm->FetchPage(page_id);
+        }
+        EXPECT_EQ(page_id, page->GetPageId());
+        EXPECT_LT(0, page->GetPinCount());
+        EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, round % 2 == 0));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // Scenario: No pin is left behind and every frame can be reused, i.e. no frame got lost to the replacer.
+  Page *pages = bpm->GetPages();
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_EQ(0, pages[i].GetPinCount());
+  }
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  EXPECT_EQ(false, bpm->UnpinPage(page_id_temp, false));
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// FetchPages pins hits and reads misses in one batch, UnpinPages unpins a batch.
+TEST(BufferPoolManagerTest, BatchFetchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const int num_pages = 20;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: Pages 10 .. 19 are resident, so this batch has hits, misses and a page asked for twice.
+  std::vector<page_id_t> page_ids{15, 3, 7, 3, 19, 2};
+  std::vector<Page *> pages = bpm->FetchPages(page_ids);
+  ASSERT_EQ(page_ids.size(), pages.size());
+  for (size_t i = 0; i < pages.size(); ++i) {
+    ASSERT_NE(nullptr, pages[i]);
+    EXPECT_EQ(page_ids[i], pages[i]->GetPageId());
+    EXPECT_EQ("page " + std::to_string(page_ids[i]), std::string(pages[i]->GetData()));
+  }
+  EXPECT_EQ(pages[1], pages[3]);
+  EXPECT_EQ(2, pages[1]->GetPinCount());
+  EXPECT_EQ(3U, bpm->GetStats().misses_);
+  EXPECT_EQ(true, bpm->UnpinPages({{15, false}, {3, false}, {7, true}, {3, false}, {19, false}, {2, false}}));
+  EXPECT_EQ(0, pages[1]->GetPinCount());
+  EXPECT_EQ(false, bpm->UnpinPages({{15, false}}));
+
+  // Scenario: A batch larger than the pool gets the pages that fit and nullptr for the others.
+  std::vector<page_id_t> all_page_ids;
+  for (page_id_t page_id = 0; page_id < 12; ++page_id) {
+    all_page_ids.push_back(page_id);
+  }
+  pages = bpm->FetchPages(all_page_ids);
+  std::vector<std::pair<page_id_t, bool>> unpins;
+  for (size_t i = 0; i < pages.size(); ++i) {
+    if (pages[i] != nullptr) {
+      EXPECT_EQ("page " + std::to_string(all_page_ids[i]), std::string(pages[i]->GetData()));
+      unpins.emplace_back(all_page_ids[i], false);
+    }
+  }
+  EXPECT_EQ(buffer_pool_size, unpins.size());
+  EXPECT_EQ(true, bpm->UnpinPages(unpins));
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// FlushAllPages writes only the dirty pages when write batching is on, and every resident page otherwise.
+TEST(BufferPoolManagerTest, FlushAllPagesTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+    page_ids.push_back(page_id_temp);
+  }
+
+  // Scenario: every page is dirty, so all of them are written.
+  int writes = disk_manager->GetNumWrites();
+  bpm->FlushAllPages();
+  EXPECT_EQ(writes + static_cast<int>(buffer_pool_size), disk_manager->GetNumWrites());
+  char buf[PAGE_SIZE];
+  for (page_id_t page_id : page_ids) {
+    disk_manager->ReadPage(page_id, buf);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(buf));
+  }
+
+  // Scenario: only the pages dirtied since the last flush are written, in any order.
+  for (page_id_t page_id : {page_ids[7], page_ids[2], page_ids[3]}) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d again", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  writes = disk_manager->GetNumWrites();
+  bpm->FlushAllPages();
+  EXPECT_EQ(writes + 3, disk_manager->GetNumWrites());
+  disk_manager->ReadPage(page_ids[3], buf);
+  EXPECT_EQ("page " + std::to_string(page_ids[3]) + " again", std::string(buf));
+  bpm->FlushAllPages();
+  EXPECT_EQ(writes + 3, disk_manager->GetNumWrites());
+
+  // Scenario: without write batching every resident page is written.
+  enable_write_batching = false;
+  bpm->FlushAllPages();
+  EXPECT_EQ(writes + 3 + static_cast<int>(buffer_pool_size), disk_manager->GetNumWrites());
+  enable_write_batching = true;
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// Deleted pages are reused by NewPage, so the db file stays bounded under churn.
+TEST(BufferPoolManagerTest, DeletePageReuseTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const int num_live_pages = 30;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  std::vector<page_id_t> live;
+  for (int i = 0; i < 2000; ++i) {
+    if (live.size() == num_live_pages) {
+      // Retire the oldest page, resident or not.
+      EXPECT_EQ(true, bpm->DeletePage(live.front()));
+      live.erase(live.begin());
+    }
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_LT(page_id_temp, num_live_pages);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+    live.push_back(page_id_temp);
+  }
+  bpm->FlushAllPages();
+
+  struct stat stat_buf;
+  ASSERT_EQ(0, stat(db_name.c_str(), &stat_buf));
+  EXPECT_LE(stat_buf.st_size, num_live_pages * PAGE_SIZE);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// Resize adds frames, or writes back and retires them while keeping pinned pages valid.
+TEST(BufferPoolManagerTest, ResizeTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+  const size_t max_pool_size = 16;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, BufferPoolManager::ReplacerType::LRU,
+                                    max_pool_size);
+  EXPECT_EQ(max_pool_size, bpm->GetMaxPoolSize());
+  auto new_page = [&]() {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    if (page != nullptr) {
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    }
+    return page;
+  };
+
+  // Scenario: After growing, eight dirty pages fit without any write-back.
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_NE(nullptr, new_page());
+    EXPECT_EQ(true, bpm->UnpinPage(i, true));
+  }
+  EXPECT_EQ(8U, bpm->Resize(8));
+  EXPECT_EQ(8U, bpm->GetPoolSize());
+  for (int i = 4; i < 8; ++i) {
+    ASSERT_NE(nullptr, new_page());
+    EXPECT_EQ(true, bpm->UnpinPage(i, true));
+  }
+  EXPECT_EQ(0U, bpm->GetForegroundWriteCount());
+  EXPECT_EQ(max_pool_size, bpm->Resize(100));
+
+  // Scenario: Shrinking keeps a frame that stays pinned, and the page in it, and writes the others back.
+  auto old_timeout = buffer_pool_resize_timeout;
+  buffer_pool_resize_timeout = std::chrono::milliseconds(20);
+  Page *pinned = bpm->FetchPage(5);
+  ASSERT_NE(nullptr, pinned);
+  EXPECT_EQ(6U, bpm->Resize(2));
+  EXPECT_EQ(6U, bpm->GetPoolSize());
+  EXPECT_EQ("page 5", std::string(pinned->GetData()));
+  EXPECT_EQ(true, bpm->UnpinPage(5, false));
+  EXPECT_EQ(2U, bpm->Resize(2));
+  buffer_pool_resize_timeout = old_timeout;
+  EXPECT_EQ(6U, bpm->GetForegroundWriteCount());
+
+  // Scenario: Only two frames are left, and every page can still be read back.
+  for (page_id_t page_id = 0; page_id < 8; ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  ASSERT_NE(nullptr, new_page());
+  ASSERT_NE(nullptr, new_page());
+  EXPECT_EQ(nullptr, new_page());
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// Fetches keep seeing the right data while the pool grows and shrinks under them.
+TEST(BufferPoolManagerTest, ConcurrentResizeTest) {
+  const std::string db_name = "test.db";
+  const int num_pages = 32;
+  const int num_threads = 3;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(8, disk_manager, nullptr, BufferPoolManager::ReplacerType::LRU, 24);
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  std::atomic<bool> done{false};
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([bpm, tid, &done] {
+      std::mt19937 rng(tid);
+      std::uniform_int_distribution<page_id_t> page_dist(0, num_pages - 1);
+      while (!done) {
+        page_id_t page_id = page_dist(rng);
+        Page *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          std::this_thread::yield();
+          continue;
+        }
+        EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, page_id % 2 == 0));
+      }
+    });
+  }
+  for (int round = 0; round < 50; ++round) {
+    bpm->Resize(round % 2 == 0 ? 4 : 24);
+  }
+  done = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(4U, bpm->Resize(4));
+  for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// Fetches and unpins resident pages from several threads and returns the throughput in million ops per second.
+static double RunParallelHitWorkload(BufferPoolManager *bpm, int num_pages, int num_threads, int ops_per_thread) {
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([=] {
+      for (int i = 0; i < ops_per_thread; ++i) {
+        auto page_id = static_cast<page_id_t>((i * 7 + tid) % num_pages);
+        bpm->FetchPage(page_id);
+        bpm->UnpinPage(page_id, false);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+  return static_cast<double>(num_threads) * ops_per_thread / static_cast<double>(elapsed.count());
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, OptimisticPinBenchmarkTest) {
+  const std::string db_name = "test.db";
+  const int buffer_pool_size = 256;
+  const int ops_per_thread = 200000;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr,
+                                    BufferPoolManager::ReplacerType::LOCK_FREE_CLOCK);
+  for (int i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id_temp;
+    bpm->NewPage(&page_id_temp);
+    bpm->UnpinPage(page_id_temp, false);
+  }
+
+  // Timings depend on the machine and its number of cores, so they are only reported.
+  for (int num_threads = 1; num_threads <= 8; num_threads *= 2) {
+    enable_optimistic_pinning = false;
+    double latched = RunParallelHitWorkload(bpm, buffer_pool_size, num_threads, ops_per_thread);
+    enable_optimistic_pinning = true;
+    double optimistic = RunParallelHitWorkload(bpm, buffer_pool_size, num_threads, ops_per_thread);
+    std::cout << num_threads << " threads: " << latched << " Mops/s latched, " << optimistic << " Mops/s optimistic"
+              << std::endl;
+  }
+  EXPECT_EQ(0U, bpm->GetStats().misses_);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+// Compares direct and buffered I/O for a pool much smaller than the data, so most fetches miss.
+TEST(BufferPoolManagerTest, DirectIOBenchmarkTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 64;
+  const int num_pages = 2048;
+  const int num_fetches = 20000;
+
+  for (bool direct : {false, true}) {
+    enable_direct_io = direct;
+    auto *disk_manager = new DiskManager(db_name);
+    enable_direct_io = false;
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+    for (int i = 0; i < num_pages; ++i) {
+      page_id_t page_id_temp;
+      auto *page = bpm->NewPage(&page_id_temp);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+      bpm->UnpinPage(page_id_temp, true);
+    }
+    bpm->FlushAllPages();
+
+    std::mt19937 rng(15445);
+    std::uniform_int_distribution<page_id_t> page_dist(0, num_pages - 1);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_fetches; ++i) {
+      page_id_t page_id = page_dist(rng);
+      auto *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      ASSERT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+      bpm->UnpinPage(page_id, false);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    // Buffered mode is usually faster here because the page cache holds the whole file; direct mode shows what the
+    // device delivers and leaves that memory to the pool.
+    std::cout << (disk_manager->IsDirectIO() ? "direct" : "buffered") << ": "
+              << num_fetches / elapsed.count() / 1000 << " Kfetches/s, " << bpm->GetStats().misses_ << " misses"
+              << std::endl;
+
+    disk_manager->ShutDown();
+    remove("test.db");
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, ReadOnlyTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 64;
+  const int num_pages = 2048;
+  const int num_scans = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id_temp);
+    bpm->UnpinPage(page_id_temp, true);
+  }
+  bpm->FlushAllPages();
+
+  // Scans the whole file a few times, which misses on every page since it does not fit into the pool.
+  auto scan = [&](BufferPoolManager *bpm) {
+    auto start = std::chrono::steady_clock::now();
+    for (int scan = 0; scan < num_scans; ++scan) {
+      for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+        auto *page = bpm->FetchPage(page_id);
+        EXPECT_NE(nullptr, page);
+        EXPECT_EQ(page_id, atoi(page->GetData() + 5));
+        bpm->UnpinPage(page_id, false);
+      }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return num_pages * num_scans / elapsed.count() / 1000;
+  };
+  double copying = scan(bpm);
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+
+  disk_manager = new DiskManager(db_name, DiskManager::OpenMode::READ_ONLY);
+  ASSERT_TRUE(disk_manager->IsReadOnly());
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: fetched pages are the mapped pages themselves, in both fetch paths.
+  auto *page = bpm->FetchPage(7);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(disk_manager->GetMappedPage(7), page->GetData());
+  EXPECT_EQ("page 7", std::string(page->GetData()));
+  std::vector<Page *> batch = bpm->FetchPages({100, 7, 101, num_pages});
+  for (Page *fetched : batch) {
+    ASSERT_NE(nullptr, fetched);
+    EXPECT_EQ(disk_manager->GetMappedPage(fetched->GetPageId()), fetched->GetData());
+  }
+  EXPECT_EQ(page, batch[1]);
+  EXPECT_EQ("page 101", std::string(batch[2]->GetData()));
+  // a page past the end of the file reads as zeros
+  EXPECT_EQ(std::string(PAGE_SIZE, '\0'), std::string(batch[3]->GetData(), PAGE_SIZE));
+
+  // Scenario: nothing is ever written.
+  EXPECT_TRUE(bpm->UnpinPage(7, true));
+  EXPECT_FALSE(page->IsDirty());
+  EXPECT_TRUE(bpm->UnpinPages({{7, false}, {100, true}, {101, false}, {num_pages, false}}));
+  page_id_t page_id_temp;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_FALSE(bpm->DeletePage(100));
+  EXPECT_TRUE(bpm->FlushPage(100));
+  bpm->FlushAllPages();
+  EXPECT_EQ(0, disk_manager->GetNumWrites());
+
+  // Timings depend on the machine, so they are only reported.
+  double mapped = scan(bpm);
+  EXPECT_EQ(0, disk_manager->GetNumWrites());
+  std::cout << "copying: " << copying << " Kfetches/s, mapped: " << mapped << " Kfetches/s" << std::endl;
+
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+  remove("test.crc");
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, WriteAheadLogTest) {
+  const std::string db_name = "test.db";
+  auto old_log_timeout = log_timeout;
+  // the log is only written when the buffer pool asks for it
+  log_timeout = std::chrono::seconds(15);
+  auto *disk_manager = new DiskManager(db_name);
+  auto *log_manager = new LogManager(disk_manager);
+  auto *bpm = new BufferPoolManager(2, disk_manager, log_manager);
+  log_manager->RunFlushThread();
+
+  // Stamps a page with the LSN of a record that is still in the log buffer.
+  auto log_change = [&](Page *page) {
+    LogRecord log_record(0, INVALID_LSN, LogRecordType::BEGIN);
+    lsn_t lsn = log_manager->AppendLogRecord(&log_record);
+    page->SetLSN(lsn);
+    EXPECT_LT(log_manager->GetPersistentLSN(), lsn);
+    return lsn;
+  };
+  auto lsn_on_disk = [&](page_id_t page_id) {
+    char data[PAGE_SIZE];
+    disk_manager->ReadPage(page_id, data);
+    // the LSN follows the page id
+    return *reinterpret_cast<lsn_t *>(data + sizeof(page_id_t));
+  };
+
+  // Scenario: evicting a dirty page makes its log records durable first.
+  page_id_t page_id0;
+  page_id_t page_id1;
+  page_id_t page_id_temp;
+  lsn_t lsn = log_change(bpm->NewPage(&page_id0));
+  ASSERT_TRUE(bpm->UnpinPage(page_id0, true));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id1));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(lsn, lsn_on_disk(page_id0));
+  EXPECT_GE(log_manager->GetPersistentLSN(), lsn);
+
+  // Scenario: so does flushing one.
+  lsn = log_change(bpm->FetchPage(page_id1));
+  ASSERT_TRUE(bpm->UnpinPage(page_id1, true));
+  ASSERT_TRUE(bpm->FlushPage(page_id1));
+  EXPECT_EQ(lsn, lsn_on_disk(page_id1));
+  EXPECT_GE(log_manager->GetPersistentLSN(), lsn);
+
+  // Scenario: and flushing all of them.
+  lsn = log_change(bpm->FetchPage(page_id1));
+  ASSERT_TRUE(bpm->UnpinPage(page_id1, true));
+  bpm->FlushAllPages();
+  EXPECT_EQ(lsn, lsn_on_disk(page_id1));
+  EXPECT_GE(log_manager->GetPersistentLSN(), lsn);
+
+  ASSERT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  log_manager->StopFlushThread();
+  delete bpm;
+  delete log_manager;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  log_timeout = old_log_timeout;
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+  remove("test.crc");
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, ReusedPageTest) {
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(2, disk_manager);
+
+  page_id_t page_id;
+  page_id_t page_id_temp;
+  Page *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), PAGE_SIZE, "deleted");
+  ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  ASSERT_TRUE(bpm->FlushPage(page_id));
+  ASSERT_TRUE(bpm->DeletePage(page_id));
+
+  // Scenario: a new page that reuses the id of a deleted one reads as zeros, even if it was never modified.
+  page = bpm->NewPage(&page_id_temp);
+  ASSERT_EQ(page_id, page_id_temp);
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    ASSERT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+  page = bpm->FetchPage(page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(std::string(PAGE_SIZE, '\0'), std::string(page->GetData(), PAGE_SIZE));
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+  remove("test.crc");
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, ChecksumFailureTest) {
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(2, disk_manager);
+  page_id_t page_id;
+  for (int i = 0; i < 3; ++i) {
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  bpm->FlushAllPages();
+  delete bpm;
+  // Flip a byte of page 1 on disk, where the buffer pool cannot see it.
+  FILE *file = fopen("test.db", "r+b");
+  fseek(file, PAGE_SIZE + 100, SEEK_SET);
+  fputc('!', file);
+  fclose(file);
+  bpm = new BufferPoolManager(2, disk_manager);
+
+  // Scenario: a page that fails its checksum cannot be fetched, singly or in a batch.
+  EXPECT_EQ(nullptr, bpm->FetchPage(1));
+  std::vector<Page *> pages = bpm->FetchPages({2, 1, 1});
+  ASSERT_NE(nullptr, pages[0]);
+  EXPECT_STREQ("page 2", pages[0]->GetData());
+  EXPECT_EQ(nullptr, pages[1]);
+  EXPECT_EQ(nullptr, pages[2]);
+  EXPECT_EQ(2U, disk_manager->GetNumChecksumFailures());
+
+  // Scenario: the failed reads gave their frames back, so both frames can be pinned.
+  Page *page = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page);
+  EXPECT_STREQ("page 0", page->GetData());
+  ASSERT_TRUE(bpm->UnpinPage(0, false));
+  ASSERT_TRUE(bpm->UnpinPage(2, false));
+
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+  remove("test.crc");
+}
+
 }  // namespace bustub
@@ -0,0 +1,159 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats_test.cpp
+//
+// Identification: test/buffer/buffer_pool_stats_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(BufferPoolStatsTest, LatencyHistogramTest) {
+  EXPECT_EQ(0U, LatencyHistogram::BucketOf(0));
+  EXPECT_EQ(0U, LatencyHistogram::BucketOf(1));
+  EXPECT_EQ(1U, LatencyHistogram::BucketOf(2));
+  EXPECT_EQ(1U, LatencyHistogram::BucketOf(3));
+  EXPECT_EQ(10U, LatencyHistogram::BucketOf(1024));
+  EXPECT_EQ(LatencyHistogram::NUM_BUCKETS - 1, LatencyHistogram::BucketOf(UINT64_MAX));
+
+  LatencyHistogram histogram;
+  EXPECT_EQ(0U, histogram.GetPercentile(50));
+  histogram.Add(LatencyHistogram::BucketOf(100), 90);
+  histogram.Add(LatencyHistogram::BucketOf(5000), 10);
+  EXPECT_EQ(100U, histogram.GetCount());
+  EXPECT_EQ(128U, histogram.GetPercentile(50));
+  EXPECT_EQ(8192U, histogram.GetPercentile(99));
+  EXPECT_EQ(8192U, histogram.GetPercentile(100));
+}
+
+TEST(BufferPoolStatsTest, SampleTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 3;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: fill the pool with dirty pages, then fetch one that is resident.
+  page_id_t page_ids[4];
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_ids[i]));
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_ids[3]));
+  for (int i = 0; i < 3; ++i) {
+    bpm->UnpinPage(page_ids[i], true);
+  }
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[0]));
+  bpm->UnpinPage(page_ids[0], false);
+
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(3U, stats.new_pages_);
+  EXPECT_EQ(1U, stats.no_free_frames_);
+  EXPECT_EQ(1U, stats.hits_);
+  EXPECT_EQ(0U, stats.misses_);
+  EXPECT_EQ(0U, stats.evictions_);
+
+  // Scenario: a new page evicts a dirty page, fetching that page again is a miss that evicts another dirty page.
+  ASSERT_NE(nullptr, bpm->NewPage(&page_ids[3]));
+  bpm->UnpinPage(page_ids[3], false);
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[1]));
+  bpm->UnpinPage(page_ids[1], false);
+
+  stats = bpm->GetStats();
+  EXPECT_EQ(4U, stats.new_pages_);
+  EXPECT_EQ(1U, stats.hits_);
+  EXPECT_EQ(1U, stats.misses_);
+  EXPECT_EQ(2U, stats.evictions_);
+  EXPECT_EQ(2U, stats.foreground_write_backs_);
+  EXPECT_EQ(1U, stats.miss_latency_.GetCount());
+  EXPECT_EQ(2U, stats.write_back_latency_.GetCount());
+  EXPECT_DOUBLE_EQ(0.5, stats.HitRatio());
+  std::cout << stats.ToString() << std::endl;
+
+  // Scenario: nothing is recorded while statistics are disabled, except for the write-back counts.
+  enable_buffer_pool_stats = false;
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[1]));
+  bpm->UnpinPage(page_ids[1], false);
+  enable_buffer_pool_stats = true;
+  EXPECT_EQ(1U, bpm->GetStats().hits_);
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolStatsTest, ParallelBufferPoolTest) {
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(4, 2, disk_manager);
+
+  // Scenario: the statistics of a parallel buffer pool add up those of its shards.
+  for (int i = 0; i < 8; ++i) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    bpm->UnpinPage(page_id, false);
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    bpm->UnpinPage(page_id, false);
+  }
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(8U, stats.new_pages_);
+  EXPECT_EQ(8U, stats.hits_);
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+// Fetches and unpins resident pages, the path where the cost of the statistics matters most, and returns ns per op.
+static double RunHitWorkload(BufferPoolManager *bpm, page_id_t num_pages, size_t num_ops) {
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < num_ops; ++i) {
+    auto page_id = static_cast<page_id_t>(i % num_pages);
+    bpm->FetchPage(page_id);
+    bpm->UnpinPage(page_id, false);
+  }
+  auto end = std::chrono::steady_clock::now();
+  return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) / num_ops;
+}
+
+TEST(BufferPoolStatsTest, OverheadBenchmarkTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 64;
+  const size_t num_ops = 1000000;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id;
+    bpm->NewPage(&page_id);
+    bpm->UnpinPage(page_id, false);
+  }
+
+  enable_buffer_pool_stats = false;
+  double disabled_ns = RunHitWorkload(bpm, buffer_pool_size, num_ops);
+  enable_buffer_pool_stats = true;
+  double enabled_ns = RunHitWorkload(bpm, buffer_pool_size, num_ops);
+  EXPECT_EQ(num_ops, bpm->GetStats().hits_);
+
+  // Timings depend on the machine, so they are only reported.
+  std::cout << "FetchPage+UnpinPage hit without statistics: " << disabled_ns << " ns/op" << std::endl;
+  std::cout << "FetchPage+UnpinPage hit with statistics:    " << enabled_ns << " ns/op" << std::endl;
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+}  // namespace bustub
@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena_test.cpp
+//
+// Identification: test/buffer/frame_arena_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/frame_arena.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(FrameArenaTest, SampleTest) {
+  const size_t num_frames = 10;
+
+  // Scenario: frames are zeroed, page aligned and PAGE_SIZE apart.
+  FrameArena arena(num_frames, false);
+  EXPECT_EQ(FrameArena::Mode::REGULAR_PAGES, arena.GetMode());
+  for (size_t i = 0; i < num_frames; ++i) {
+    char *frame = arena.GetFrame(static_cast<frame_id_t>(i));
+    EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(frame) % PAGE_SIZE);
+    EXPECT_EQ(arena.GetFrame(0) + i * PAGE_SIZE, frame);
+    for (size_t j = 0; j < PAGE_SIZE; ++j) {
+      ASSERT_EQ(0, frame[j]);
+    }
+  }
+  // Scenario: every byte of the last frame is usable.
+  arena.GetFrame(num_frames - 1)[PAGE_SIZE - 1] = 'x';
+
+  // Scenario: asking for hugepages always succeeds, falling back to whatever the system offers.
+  FrameArena huge_arena(num_frames, true);
+  std::cout << "FrameArena with hugepages requested is backed by " << FrameArena::ModeToString(huge_arena.GetMode())
+            << std::endl;
+  EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(huge_arena.GetFrame(0)) % PAGE_SIZE);
+  huge_arena.GetFrame(num_frames - 1)[PAGE_SIZE - 1] = 'x';
+}
+
+TEST(FrameArenaTest, BufferPoolFramesTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  enable_hugepage_frames = true;
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  enable_hugepage_frames = false;
+
+  // Scenario: the data of every page handed out by the buffer pool is page aligned.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(page->GetData()) % PAGE_SIZE);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+  }
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size); ++page_id) {
+    EXPECT_EQ(0, strcmp(bpm->FetchPage(page_id)->GetData(), ("page " + std::to_string(page_id)).c_str()));
+    bpm->UnpinPage(page_id, true);
+    bpm->UnpinPage(page_id, true);
+  }
+  std::cout << "BufferPoolManager frames are backed by " << FrameArena::ModeToString(bpm->GetFrameArenaMode())
+            << std::endl;
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+}  // namespace bustub
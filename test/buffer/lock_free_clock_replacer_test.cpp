@@ -0,0 +1,204 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lock_free_clock_replacer_test.cpp
+//
+// Identification: test/buffer/lock_free_clock_replacer_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/clock_replacer.h"
+#include "buffer/lock_free_clock_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(LockFreeClockReplacerTest, SampleTest) {
+  LockFreeClockReplacer clock_replacer(7);
+
+  // Scenario: unpin six elements, i.e. add them to the replacer.
+  for (frame_id_t frame_id = 1; frame_id <= 6; ++frame_id) {
+    clock_replacer.Unpin(frame_id);
+  }
+  clock_replacer.Unpin(1);
+  EXPECT_EQ(6, clock_replacer.Size());
+
+  // Scenario: the victims come out in the same order as from the ClockReplacer.
+  int value;
+  clock_replacer.Victim(&value);
+  EXPECT_EQ(1, value);
+  clock_replacer.Victim(&value);
+  EXPECT_EQ(2, value);
+  clock_replacer.Victim(&value);
+  EXPECT_EQ(3, value);
+
+  clock_replacer.Pin(3);
+  clock_replacer.Pin(4);
+  EXPECT_EQ(2, clock_replacer.Size());
+  clock_replacer.Unpin(4);
+
+  clock_replacer.Victim(&value);
+  EXPECT_EQ(5, value);
+  clock_replacer.Victim(&value);
+  EXPECT_EQ(6, value);
+  clock_replacer.Victim(&value);
+  EXPECT_EQ(4, value);
+  EXPECT_EQ(false, clock_replacer.Victim(&value));
+  EXPECT_EQ(0, clock_replacer.Size());
+}
+
+TEST(LockFreeClockReplacerTest, ConcurrencyTest) {
+  const size_t num_threads = 4;
+  const size_t frames_per_thread = 256;
+  const size_t num_frames = num_threads * frames_per_thread;
+  LockFreeClockReplacer clock_replacer(num_frames);
+
+  // Scenario: every thread pins and unpins its own frames over and over, ending with all of them unpinned.
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&clock_replacer, tid, frames_per_thread] {
+      for (int round = 0; round < 100; ++round) {
+        for (size_t i = 0; i < frames_per_thread; ++i) {
+          auto frame_id = static_cast<frame_id_t>(tid * frames_per_thread + i);
+          clock_replacer.Unpin(frame_id);
+          clock_replacer.Pin(frame_id);
+          clock_replacer.Unpin(frame_id);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_frames, clock_replacer.Size());
+
+  // Scenario: concurrent victims hand out every frame exactly once.
+  std::vector<std::vector<frame_id_t>> victims(num_threads);
+  threads.clear();
+  for (size_t tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&clock_replacer, &victims, tid] {
+      frame_id_t frame_id;
+      while (clock_replacer.Victim(&frame_id)) {
+        victims[tid].push_back(frame_id);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::vector<int> times_victimized(num_frames, 0);
+  for (const auto &thread_victims : victims) {
+    for (auto frame_id : thread_victims) {
+      times_victimized[frame_id]++;
+    }
+  }
+  for (size_t i = 0; i < num_frames; ++i) {
+    EXPECT_EQ(1, times_victimized[i]);
+  }
+  EXPECT_EQ(0, clock_replacer.Size());
+}
+
+TEST(LockFreeClockReplacerTest, VictimStressTest) {
+  const size_t num_victim_threads = 4;
+  const size_t num_kept_frames = num_victim_threads + 1;
+  const size_t num_churn_threads = 4;
+  const size_t frames_per_churn_thread = 64;
+  const size_t num_frames = num_kept_frames + num_churn_threads * frames_per_churn_thread;
+  LockFreeClockReplacer clock_replacer(num_frames);
+  for (size_t i = 0; i < num_frames; ++i) {
+    clock_replacer.Unpin(static_cast<frame_id_t>(i));
+  }
+
+  // Scenario: every victim thread takes a frame and puts it back, over and over, while other threads keep referencing
+  // the rest of the frames. The first frames are only touched by the victim threads, which hold one frame each at
+  // most, so some frame is always evictable and Victim must never fail.
+  std::atomic<bool> stop{false};
+  std::atomic<int> failed_victims{0};
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_churn_threads; ++tid) {
+    threads.emplace_back([&, tid] {
+      while (!stop) {
+        for (size_t i = 0; i < frames_per_churn_thread; ++i) {
+          auto frame_id = static_cast<frame_id_t>(num_kept_frames + tid * frames_per_churn_thread + i);
+          clock_replacer.Pin(frame_id);
+          clock_replacer.Unpin(frame_id);
+        }
+      }
+    });
+  }
+  std::vector<std::thread> victim_threads;
+  for (size_t tid = 0; tid < num_victim_threads; ++tid) {
+    victim_threads.emplace_back([&] {
+      for (int i = 0; i < 20000; ++i) {
+        frame_id_t frame_id;
+        if (!clock_replacer.Victim(&frame_id)) {
+          failed_victims++;
+          continue;
+        }
+        clock_replacer.Unpin(frame_id);
+      }
+    });
+  }
+  for (auto &thread : victim_threads) {
+    thread.join();
+  }
+  stop = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, failed_victims);
+}
+
+// Unpins from several threads at once, the way a busy buffer pool releases pages, and returns the elapsed time.
+static std::chrono::nanoseconds RunUnpinWorkload(Replacer *replacer, size_t num_threads, size_t frames_per_thread,
+                                                 size_t rounds) {
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([replacer, tid, frames_per_thread, rounds] {
+      for (size_t round = 0; round < rounds; ++round) {
+        for (size_t i = 0; i < frames_per_thread; ++i) {
+          auto frame_id = static_cast<frame_id_t>(tid * frames_per_thread + i);
+          replacer->Pin(frame_id);
+          replacer->Unpin(frame_id);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  EXPECT_EQ(num_threads * frames_per_thread, replacer->Size());
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+}
+
+TEST(LockFreeClockReplacerTest, UnpinThroughputTest) {
+  const size_t num_threads = 8;
+  const size_t frames_per_thread = 512;
+  const size_t rounds = 200;
+  const size_t num_ops = num_threads * frames_per_thread * rounds;
+
+  ClockReplacer mutex_clock(num_threads * frames_per_thread);
+  LockFreeClockReplacer lock_free_clock(num_threads * frames_per_thread);
+  auto mutex_time = RunUnpinWorkload(&mutex_clock, num_threads, frames_per_thread, rounds);
+  auto lock_free_time = RunUnpinWorkload(&lock_free_clock, num_threads, frames_per_thread, rounds);
+
+  // Timings depend on the machine, so they are only reported.
+  std::cout << "ClockReplacer (mutex):       " << num_ops * 1000 / mutex_time.count() << " pin/unpin per us"
+            << std::endl;
+  std::cout << "LockFreeClockReplacer:       " << num_ops * 1000 / lock_free_time.count() << " pin/unpin per us"
+            << std::endl;
+}
+
+}  // namespace bustub
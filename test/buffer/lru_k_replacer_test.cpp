@@ -0,0 +1,148 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer_test.cpp
+//
+// Identification: test/buffer/lru_k_replacer_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/lru_k_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_k_replacer(7, 2, 0);
+
+  // Scenario: access frames 1 .. 6 once, then access frame 1 a second time.
+  for (frame_id_t frame_id = 1; frame_id <= 6; ++frame_id) {
+    lru_k_replacer.Pin(frame_id);
+    lru_k_replacer.Unpin(frame_id);
+  }
+  lru_k_replacer.Pin(1);
+  lru_k_replacer.Unpin(1);
+  EXPECT_EQ(6, lru_k_replacer.Size());
+
+  // Scenario: frames with a single reference go first, in the order they were first referenced.
+  int value;
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(2, value);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(3, value);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(4, value);
+
+  // Scenario: pinned frames cannot be victimized, a removed frame is forgotten.
+  lru_k_replacer.Pin(5);
+  lru_k_replacer.Remove(6);
+  EXPECT_EQ(1, lru_k_replacer.Size());
+  lru_k_replacer.Unpin(5);
+  EXPECT_EQ(2, lru_k_replacer.Size());
+
+  // Scenario: frames 1 and 5 both have two references now, and frame 1 was first referenced before frame 5.
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(1, value);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(5, value);
+  EXPECT_EQ(false, lru_k_replacer.Victim(&value));
+  EXPECT_EQ(0, lru_k_replacer.Size());
+}
+
+TEST(LRUKReplacerTest, CorrelatedReferenceTest) {
+  LRUKReplacer lru_k_replacer(3, 2, 4);
+
+  // Scenario: frame 0 is accessed three times in a row, which only counts as one reference.
+  for (int i = 0; i < 3; ++i) {
+    lru_k_replacer.Pin(0);
+    lru_k_replacer.Unpin(0);
+  }
+  // Scenario: frame 1 is accessed twice, far enough apart to count as two references.
+  lru_k_replacer.Pin(1);
+  lru_k_replacer.Unpin(1);
+  for (int i = 0; i < 4; ++i) {
+    lru_k_replacer.Pin(2);
+    lru_k_replacer.Unpin(2);
+  }
+  lru_k_replacer.Pin(1);
+  lru_k_replacer.Unpin(1);
+
+  int value;
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(0, value);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(2, value);
+  lru_k_replacer.Victim(&value);
+  EXPECT_EQ(1, value);
+}
+
+// Hot pages, e.g. the inner pages of a B+ tree, should survive a sequential scan that is much larger than the pool.
+TEST(LRUKReplacerTest, ScanResistanceTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 20;
+  const int num_hot_pages = 5;
+  const int num_scan_pages = 100;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, nullptr, BufferPoolManager::ReplacerType::LRU_K);
+
+  std::vector<page_id_t> hot_pages;
+  std::vector<page_id_t> scan_pages;
+  for (int i = 0; i < num_hot_pages + num_scan_pages; ++i) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    (i < num_hot_pages ? hot_pages : scan_pages).push_back(page_id);
+  }
+
+  // Scenario: a point lookup workload keeps touching the hot pages.
+  auto lookups = [&](int rounds) {
+    for (int round = 0; round < rounds; ++round) {
+      for (auto page_id : hot_pages) {
+        Page *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+      }
+    }
+  };
+  lookups(20);
+
+  // Scenario: a full scan runs next to the lookups, touching every page a few times in a row, once per tuple.
+  // With plain LRU the scan would flush the hot pages out of the pool.
+  std::thread scan([&] {
+    for (auto page_id : scan_pages) {
+      for (int tuple = 0; tuple < 3; ++tuple) {
+        Page *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+      }
+    }
+  });
+  lookups(5);
+  scan.join();
+
+  int resident = 0;
+  Page *pages = bpm->GetPages();
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    for (auto page_id : hot_pages) {
+      resident += static_cast<int>(pages[i].GetPageId() == page_id);
+    }
+  }
+  EXPECT_EQ(num_hot_pages, resident);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
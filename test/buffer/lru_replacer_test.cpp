@@ -10,8 +10,14 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <random>
 #include <thread>  // NOLINT
+#include <unordered_map>
 #include <vector>
 
 #include "buffer/lru_replacer.h"
@@ -59,4 +65,113 @@ TEST(LRUReplacerTest, SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+// The LRUReplacer before it became intrusive: a list of shared_ptr nodes plus a hash map, kept as a baseline.
+class SharedPtrLRUReplacer : public Replacer {
+ public:
+  explicit SharedPtrLRUReplacer(size_t num_pages) : front_(std::make_shared<Node>()), rear_(std::make_shared<Node>()) {
+    front_->right_ = rear_;
+    rear_->left_ = front_;
+  }
+
+  ~SharedPtrLRUReplacer() override {
+    for (Node *p = front_.get(); p != nullptr;) {
+      Node *next = p->right_.get();
+      p->left_ = p->right_ = nullptr;
+      p = next;
+    }
+  }
+
+  bool Victim(frame_id_t *frame_id) override {
+    std::lock_guard<std::mutex> guard(latch_);
+    auto least_used = front_->right_;
+    if (least_used == rear_) {
+      return false;
+    }
+    *frame_id = least_used->data_;
+    Remove(least_used);
+    map_.erase(least_used->data_);
+    return true;
+  }
+
+  void Pin(frame_id_t frame_id) override {
+    std::lock_guard<std::mutex> guard(latch_);
+    auto iter = map_.find(frame_id);
+    if (iter == map_.end()) {
+      return;
+    }
+    Remove(iter->second);
+    map_.erase(iter);
+  }
+
+  void Unpin(frame_id_t frame_id) override {
+    std::lock_guard<std::mutex> guard(latch_);
+    if (map_.count(frame_id) != 0U) {
+      return;
+    }
+    auto node = std::make_shared<Node>();
+    node->data_ = frame_id;
+    node->left_ = rear_->left_;
+    rear_->left_->right_ = node;
+    node->right_ = rear_;
+    rear_->left_ = node;
+    map_[frame_id] = node;
+  }
+
+  size_t Size() override {
+    std::lock_guard<std::mutex> guard(latch_);
+    return map_.size();
+  }
+
+ private:
+  struct Node {
+    frame_id_t data_ = 0;
+    std::shared_ptr<Node> left_, right_;
+  };
+
+  void Remove(const std::shared_ptr<Node> &node) {
+    node->left_->right_ = node->right_;
+    node->right_->left_ = node->left_;
+  }
+
+  std::shared_ptr<Node> front_, rear_;
+  std::unordered_map<frame_id_t, std::shared_ptr<Node>> map_;
+  std::mutex latch_;
+};
+
+// Runs the Pin/Unpin/Victim mix the buffer pool produces against a replacer and returns the elapsed time.
+static std::chrono::nanoseconds RunReplacerWorkload(Replacer *replacer, size_t num_frames, size_t num_ops) {
+  std::mt19937 rng(15445);
+  std::uniform_int_distribution<frame_id_t> frame_dist(0, static_cast<frame_id_t>(num_frames) - 1);
+  for (size_t i = 0; i < num_frames; ++i) {
+    replacer->Unpin(static_cast<frame_id_t>(i));
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < num_ops; ++i) {
+    // A fetch hit pins the frame and the matching unpin puts it back; every fourth access is a miss.
+    frame_id_t frame_id = frame_dist(rng);
+    if (i % 4 == 0) {
+      replacer->Victim(&frame_id);
+    } else {
+      replacer->Pin(frame_id);
+    }
+    replacer->Unpin(frame_id);
+  }
+  auto end = std::chrono::steady_clock::now();
+  EXPECT_EQ(num_frames, replacer->Size());
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+}
+
+TEST(LRUReplacerTest, BenchmarkTest) {
+  const size_t num_frames = 4096;
+  const size_t num_ops = 1000000;
+
+  LRUReplacer intrusive(num_frames);
+  SharedPtrLRUReplacer shared_ptr_list(num_frames);
+  auto intrusive_time = RunReplacerWorkload(&intrusive, num_frames, num_ops);
+  auto shared_ptr_time = RunReplacerWorkload(&shared_ptr_list, num_frames, num_ops);
+
+  std::cout << "LRUReplacer (intrusive arrays): " << intrusive_time.count() / num_ops << " ns/op" << std::endl;
+  std::cout << "LRUReplacer (shared_ptr list):  " << shared_ptr_time.count() / num_ops << " ns/op" << std::endl;
+}
+
 }  // namespace bustub
@@ -0,0 +1,125 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table_test.cpp
+//
+// Identification: test/buffer/page_table_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <cstdio>
+#include <random>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/page_table.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(PageTableTest, SampleTest) {
+  PageTable page_table(4);
+  frame_id_t frame_id;
+
+  EXPECT_FALSE(page_table.Find(1, &frame_id));
+  EXPECT_FALSE(page_table.Erase(1));
+  EXPECT_FALSE(page_table.Erase(INVALID_PAGE_ID));
+
+  // Scenario: insert, overwrite and erase mappings.
+  page_table.Insert(1, 0);
+  page_table.Insert(2, 1);
+  page_table.Insert(3, 2);
+  EXPECT_EQ(3U, page_table.Size());
+  EXPECT_TRUE(page_table.Find(2, &frame_id));
+  EXPECT_EQ(1, frame_id);
+  page_table.Insert(2, 3);
+  EXPECT_EQ(3U, page_table.Size());
+  EXPECT_TRUE(page_table.Find(2, &frame_id));
+  EXPECT_EQ(3, frame_id);
+  EXPECT_TRUE(page_table.Erase(2));
+  EXPECT_FALSE(page_table.Find(2, &frame_id));
+  EXPECT_EQ(2U, page_table.Size());
+
+  // Scenario: ForEach visits every mapping once.
+  int visited = 0;
+  page_table.ForEach([&](page_id_t page_id, frame_id_t frame) {
+    EXPECT_TRUE(page_id == 1 || page_id == 3);
+    EXPECT_EQ(page_id == 1 ? 0 : 2, frame);
+    visited++;
+  });
+  EXPECT_EQ(2, visited);
+}
+
+TEST(PageTableTest, RandomOperationsTest) {
+  const size_t num_frames = 64;
+  PageTable page_table(num_frames);
+  std::unordered_map<page_id_t, frame_id_t> expected;
+  std::mt19937 rng(15445);
+  // Few distinct ids in a small table, so clusters form and erases have to shift entries back.
+  std::uniform_int_distribution<page_id_t> page_dist(0, 4 * num_frames);
+
+  for (int i = 0; i < 100000; ++i) {
+    page_id_t page_id = page_dist(rng);
+    if (expected.count(page_id) != 0U) {
+      EXPECT_TRUE(page_table.Erase(page_id));
+      expected.erase(page_id);
+    } else if (expected.size() < num_frames) {
+      auto frame_id = static_cast<frame_id_t>(i % num_frames);
+      page_table.Insert(page_id, frame_id);
+      expected[page_id] = frame_id;
+    }
+    if (i % 1000 == 0) {
+      ASSERT_EQ(expected.size(), page_table.Size());
+      for (page_id_t id = 0; id <= static_cast<page_id_t>(4 * num_frames); ++id) {
+        frame_id_t frame_id;
+        bool found = page_table.Find(id, &frame_id);
+        ASSERT_EQ(expected.count(id) != 0U, found);
+        if (found) {
+          ASSERT_EQ(expected[id], frame_id);
+        }
+      }
+    }
+  }
+}
+
+TEST(PageTableTest, ConcurrentReadersTest) {
+  const size_t num_frames = 128;
+  PageTable page_table(num_frames);
+  // Page p is only ever mapped to frame p % num_frames, so a reader can tell a wrong mapping apart from a stale one.
+  auto frame_of = [&](page_id_t page_id) { return static_cast<frame_id_t>(page_id % num_frames); };
+  std::atomic<bool> done{false};
+
+  // Scenario: one writer keeps a sliding window of pages mapped while readers look pages up without a latch.
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < 3; ++tid) {
+    readers.emplace_back([&, tid] {
+      std::mt19937 rng(tid);
+      std::uniform_int_distribution<page_id_t> page_dist(0, 20000);
+      while (!done) {
+        page_id_t page_id = page_dist(rng);
+        frame_id_t frame_id;
+        if (page_table.Find(page_id, &frame_id)) {
+          EXPECT_EQ(frame_of(page_id), frame_id);
+        }
+      }
+    });
+  }
+  for (page_id_t page_id = 0; page_id < 20000; ++page_id) {
+    if (page_id >= static_cast<page_id_t>(num_frames)) {
+      page_table.Erase(page_id - static_cast<page_id_t>(num_frames));
+    }
+    page_table.Insert(page_id, frame_of(page_id));
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(num_frames, page_table.Size());
+}
+
+}  // namespace bustub
@@ -0,0 +1,213 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager_test.cpp
+//
+// Identification: test/buffer/parallel_buffer_pool_manager_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, SampleTest) {
+  const std::string db_name = "test.db";
+  const size_t num_instances = 5;
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  EXPECT_EQ(num_instances * buffer_pool_size, bpm->GetPoolSize());
+
+  page_id_t page_id_temp;
+  auto *page0 = bpm->NewPage(&page_id_temp);
+
+  // Scenario: The buffer pool is empty. We should be able to create a new page.
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, page_id_temp);
+
+  // Scenario: Once we have a page, we should be able to read and write content.
+  snprintf(page0->GetData(), PAGE_SIZE, "Hello");
+  EXPECT_EQ(0, strcmp(page0->GetData(), "Hello"));
+
+  // Scenario: New pages are handed out round-robin, so every page lands in the shard its id maps to.
+  for (size_t i = 1; i < num_instances * buffer_pool_size; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(i % num_instances, static_cast<size_t>(page_id_temp) % num_instances);
+  }
+
+  // Scenario: Once every shard is full, we should not be able to create any new pages.
+  for (size_t i = 0; i < num_instances; ++i) {
+    EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  }
+
+  // Scenario: After unpinning pages {0, 1, 2, 3, 4}, one frame frees up in every shard.
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, true));
+  }
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+
+  // Scenario: We should be able to fetch the data we wrote a while ago.
+  page0 = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, strcmp(page0->GetData(), "Hello"));
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+
+  // Scenario: A page that is not resident cannot be unpinned, and a pinned page cannot be deleted.
+  EXPECT_EQ(false, bpm->UnpinPage(1, false));
+  page0 = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(false, bpm->DeletePage(0));
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+  EXPECT_EQ(true, bpm->DeletePage(0));
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ConcurrencyTest) {
+  const std::string db_name = "test.db";
+  const size_t num_instances = 4;
+  const size_t buffer_pool_size = 8;
+  const int num_threads = 4;
+  const int pages_per_thread = 50;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  // Every thread writes its own pages and reads them back, forcing evictions in all shards along the way.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([bpm, tid] {
+      std::vector<page_id_t> page_ids;
+      for (int i = 0; i < pages_per_thread; ++i) {
+        page_id_t page_id;
+        Page *page = bpm->NewPage(&page_id);
+        while (page == nullptr) {
+          std::this_thread::yield();
+          page = bpm->NewPage(&page_id);
+        }
+        snprintf(page->GetData(), PAGE_SIZE, "%d", page_id * 10 + tid);
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+        page_ids.push_back(page_id);
+      }
+      for (auto page_id : page_ids) {
+        Page *page = bpm->FetchPage(page_id);
+        while (page == nullptr) {
+          std::this_thread::yield();
+          page = bpm->FetchPage(page_id);
+        }
+        EXPECT_EQ(std::to_string(page_id * 10 + tid), std::string(page->GetData()));
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, BatchFetchTest) {
+  const std::string db_name = "test.db";
+  const size_t num_instances = 3;
+  const size_t buffer_pool_size = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  for (int i = 0; i < 24; ++i) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: a batch spread over all the shards comes back in the order it was asked for.
+  std::vector<page_id_t> page_ids{7, 0, 11, 5, 1, 9};
+  std::vector<Page *> pages = bpm->FetchPages(page_ids);
+  std::vector<std::pair<page_id_t, bool>> unpins;
+  for (size_t i = 0; i < page_ids.size(); ++i) {
+    ASSERT_NE(nullptr, pages[i]);
+    EXPECT_EQ(page_ids[i], pages[i]->GetPageId());
+    EXPECT_EQ(std::to_string(page_ids[i]), std::string(pages[i]->GetData()));
+    unpins.emplace_back(page_ids[i], false);
+  }
+  EXPECT_EQ(true, bpm->UnpinPages(unpins));
+  EXPECT_EQ(false, bpm->UnpinPages(unpins));
+
+  // Scenario: FlushAllPages writes the dirty pages of every shard, and nothing once they are clean.
+  bpm->FlushAllPages();
+  int writes = disk_manager->GetNumWrites();
+  pages = bpm->FetchPages(page_ids);
+  unpins.clear();
+  for (size_t i = 0; i < page_ids.size(); ++i) {
+    ASSERT_NE(nullptr, pages[i]);
+    snprintf(pages[i]->GetData(), PAGE_SIZE, "%d again", page_ids[i]);
+    unpins.emplace_back(page_ids[i], true);
+  }
+  EXPECT_EQ(true, bpm->UnpinPages(unpins));
+  bpm->FlushAllPages();
+  EXPECT_EQ(writes + static_cast<int>(page_ids.size()), disk_manager->GetNumWrites());
+  char buf[PAGE_SIZE];
+  for (page_id_t page_id : page_ids) {
+    disk_manager->ReadPage(page_id, buf);
+    EXPECT_EQ(std::to_string(page_id) + " again", std::string(buf));
+  }
+  bpm->FlushAllPages();
+  EXPECT_EQ(writes + static_cast<int>(page_ids.size()), disk_manager->GetNumWrites());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ResizeTest) {
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(3, 2, disk_manager, nullptr, BufferPoolManager::ReplacerType::LRU, 8);
+  EXPECT_EQ(6U, bpm->GetPoolSize());
+  EXPECT_EQ(24U, bpm->GetMaxPoolSize());
+
+  // Scenario: the new size is spread over the shards, each of which keeps at least one frame.
+  EXPECT_EQ(10U, bpm->Resize(10));
+  EXPECT_EQ(4U, bpm->GetBufferPoolManager(0)->GetPoolSize());
+  EXPECT_EQ(3U, bpm->GetBufferPoolManager(2)->GetPoolSize());
+  EXPECT_EQ(3U, bpm->Resize(1));
+  EXPECT_EQ(24U, bpm->Resize(100));
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+}  // namespace bustub
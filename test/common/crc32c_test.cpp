@@ -0,0 +1,82 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c_test.cpp
+//
+// Identification: test/common/crc32c_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "common/config.h"
+#include "common/util/crc32c.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(Crc32cTest, KnownValuesTest) {
+  // Check values from RFC 3720, appendix B.4.
+  const char *digits = "123456789";
+  EXPECT_EQ(0xE3069283U, Crc32c::Compute(digits, strlen(digits)));
+  EXPECT_EQ(0xE3069283U, Crc32c::ComputeSoftware(digits, strlen(digits)));
+  std::vector<uint8_t> zeros(32, 0);
+  EXPECT_EQ(0x8A9136AAU, Crc32c::Compute(zeros.data(), zeros.size()));
+  std::vector<uint8_t> ones(32, 0xFF);
+  EXPECT_EQ(0x62A8AB43U, Crc32c::Compute(ones.data(), ones.size()));
+  EXPECT_EQ(0U, Crc32c::Compute(nullptr, 0));
+}
+
+TEST(Crc32cTest, SoftwareMatchesHardwareTest) {
+  std::mt19937 rng(15445);
+  std::vector<uint8_t> data(PAGE_SIZE + 7);
+  for (auto &byte : data) {
+    byte = static_cast<uint8_t>(rng());
+  }
+  // Lengths and alignments that leave tails of every size.
+  for (size_t offset = 0; offset < 8; ++offset) {
+    for (size_t length : {0, 1, 7, 8, 9, 63, 64, 100, PAGE_SIZE - 1}) {
+      uint32_t crc = Crc32c::ComputeSoftware(data.data() + offset, length);
+      EXPECT_EQ(crc, Crc32c::Compute(data.data() + offset, length));
+      // checksumming in two pieces gives the same result
+      size_t half = length / 2;
+      EXPECT_EQ(crc, Crc32c::Compute(data.data() + offset + half, length - half,
+                                     Crc32c::Compute(data.data() + offset, half)));
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(Crc32cTest, BenchmarkTest) {
+  const int num_pages = 20000;
+  std::vector<char> page(PAGE_SIZE);
+  std::mt19937 rng(15445);
+  for (auto &byte : page) {
+    byte = static_cast<char>(rng());
+  }
+
+  // Timings depend on the machine, so they are only reported.
+  auto measure = [&](uint32_t (*compute)(const void *, size_t, uint32_t)) {
+    uint32_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_pages; ++i) {
+      sink ^= compute(page.data(), PAGE_SIZE, 0);
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_NE(0U, sink | 1);
+    return elapsed.count() / num_pages;
+  };
+  double software = measure(&Crc32c::ComputeSoftware);
+  double compute = measure(&Crc32c::Compute);
+  std::cout << "software: " << software << " ns/page, "
+            << (Crc32c::IsHardwareAccelerated() ? "sse4.2: " : "software: ") << compute << " ns/page" << std::endl;
+}
+
+}  // namespace bustub
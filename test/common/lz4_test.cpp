@@ -0,0 +1,178 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz4_test.cpp
+//
+// Identification: test/common/lz4_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "common/util/lz4.h"
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction.h"
+#include "gtest/gtest.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+/** Compresses and decompresses input, and checks that it comes back unchanged. @return the compressed size */
+size_t RoundTrip(const std::vector<char> &input) {
+  std::vector<char> compressed(Lz4::CompressBound(input.size()));
+  size_t size = Lz4::Compress(input.data(), input.size(), compressed.data(), compressed.size());
+  EXPECT_GT(size, 0U);
+  std::vector<char> output(input.size() + 1);
+  EXPECT_EQ(static_cast<int64_t>(input.size()), Lz4::Decompress(compressed.data(), size, output.data(), output.size()));
+  output.pop_back();
+  EXPECT_EQ(input, output);
+  return size;
+}
+
+}  // namespace
+
+TEST(Lz4Test, RoundTripTest) {
+  std::mt19937 rng(15445);
+  // short inputs are stored as literals only
+  for (size_t length = 0; length < 20; ++length) {
+    RoundTrip(std::vector<char>(length, 'x'));
+  }
+
+  std::vector<char> zeros(PAGE_SIZE, 0);
+  EXPECT_LT(RoundTrip(zeros), 32U);
+
+  std::vector<char> random(PAGE_SIZE);
+  for (auto &byte : random) {
+    byte = static_cast<char>(rng());
+  }
+  RoundTrip(random);
+  // random bytes do not compress, so they do not fit into less than their own size
+  std::vector<char> compressed(PAGE_SIZE);
+  EXPECT_EQ(0U, Lz4::Compress(random.data(), random.size(), compressed.data(), PAGE_SIZE - 1));
+
+  // text with repeats both near and beyond the 64 KiB reach of a match
+  std::string text;
+  while (text.size() < 200000) {
+    text += "tuple " + std::to_string(rng() % 5000) + (rng() % 2 == 0 ? " alpha" : " beta, gamma ");
+  }
+  EXPECT_LT(RoundTrip(std::vector<char>(text.begin(), text.end())), text.size() / 2);
+}
+
+TEST(Lz4Test, MalformedInputTest) {
+  char output[64];
+  // a literal 'a' copied eight times with offset 1, then five literals
+  const char block[] = {0x14, 'a', 0x01, 0x00, 0x50, 'b', 'c', 'd', 'e', 'f'};
+  ASSERT_EQ(14, Lz4::Decompress(block, sizeof(block), output, sizeof(output)));
+  EXPECT_EQ("aaaaaaaaabcdef", std::string(output, 14));
+  // the output does not fit
+  EXPECT_EQ(-1, Lz4::Decompress(block, sizeof(block), output, 10));
+  // a match reaching before the start of the output
+  const char bad_offset[] = {0x14, 'a', 0x02, 0x00, 0x50, 'b', 'c', 'd', 'e', 'f'};
+  EXPECT_EQ(-1, Lz4::Decompress(bad_offset, sizeof(bad_offset), output, sizeof(output)));
+  const char zero_offset[] = {0x14, 'a', 0x00, 0x00, 0x50, 'b', 'c', 'd', 'e', 'f'};
+  EXPECT_EQ(-1, Lz4::Decompress(zero_offset, sizeof(zero_offset), output, sizeof(output)));
+  EXPECT_EQ(-1, Lz4::Decompress(block, 0, output, sizeof(output)));
+
+  // Truncated and corrupted blocks never fail other than by returning -1 or wrong bytes.
+  std::string text;
+  for (int i = 0; i < 200; ++i) {
+    text += "row " + std::to_string(i % 17) + ";";
+  }
+  std::vector<char> compressed(Lz4::CompressBound(text.size()));
+  size_t size = Lz4::Compress(text.data(), text.size(), compressed.data(), compressed.size());
+  std::vector<char> decompressed(text.size());
+  for (size_t length = 0; length < size; ++length) {
+    EXPECT_NE(static_cast<int64_t>(text.size()),
+              Lz4::Decompress(compressed.data(), length, decompressed.data(), decompressed.size()));
+  }
+  std::mt19937 rng(15445);
+  for (int i = 0; i < 1000; ++i) {
+    std::vector<char> corrupted(compressed.begin(), compressed.begin() + size);
+    corrupted[rng() % size] ^= static_cast<char>(1 + rng() % 255);
+    Lz4::Decompress(corrupted.data(), size, decompressed.data(), decompressed.size());
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(Lz4Test, BenchmarkTest) {
+  // Fill the pages of a table heap with typical tuples, then delete every third one to leave holes.
+  Schema schema({Column{"id", TypeId::INTEGER}, Column{"name", TypeId::VARCHAR, 32}, Column{"balance", TypeId::BIGINT},
+                 Column{"active", TypeId::BOOLEAN}});
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(64, disk_manager);
+  LockManager lock_manager;
+  Transaction txn(0);
+  auto *table = new TableHeap(bpm, &lock_manager, nullptr, &txn);
+  std::mt19937 rng(15445);
+  std::vector<RID> rids;
+  for (int id = 0; id < 2000; ++id) {
+    std::string name = "customer#" + std::to_string(100000 + id);
+    std::vector<Value> values{ValueFactory::GetIntegerValue(id), ValueFactory::GetVarcharValue(name),
+                              ValueFactory::GetBigIntValue(rng() % 1000000),
+                              ValueFactory::GetBooleanValue(id % 2 == 0)};
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(Tuple(values, &schema), &rid, &txn));
+    rids.push_back(rid);
+  }
+  for (size_t i = 0; i < rids.size(); i += 3) {
+    table->ApplyDelete(rids[i], &txn);
+  }
+  std::vector<std::vector<char>> pages;
+  for (page_id_t page_id = 0; disk_manager->IsAllocated(page_id); ++page_id) {
+    ReadPageGuard guard = bpm->FetchPageRead(page_id);
+    pages.emplace_back(guard.GetData(), guard.GetData() + PAGE_SIZE);
+  }
+
+  // Timings depend on the machine, so they are only reported.
+  const int rounds = 200;
+  std::vector<char> compressed(Lz4::CompressBound(PAGE_SIZE));
+  std::vector<char> decompressed(PAGE_SIZE);
+  size_t total_size = 0;
+  std::chrono::duration<double, std::nano> compress_time(0);
+  std::chrono::duration<double, std::nano> decompress_time(0);
+  for (const auto &page : pages) {
+    size_t size = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+      size = Lz4::Compress(page.data(), PAGE_SIZE, compressed.data(), compressed.size());
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+      Lz4::Decompress(compressed.data(), size, decompressed.data(), PAGE_SIZE);
+    }
+    decompress_time += std::chrono::steady_clock::now() - middle;
+    compress_time += middle - start;
+    EXPECT_EQ(page, decompressed);
+    total_size += size;
+  }
+  double ratio = static_cast<double>(total_size) / (pages.size() * PAGE_SIZE);
+  EXPECT_LT(ratio, 1.0);
+  std::cout << pages.size() << " table pages compress to " << ratio * 100 << "% of their size, compress "
+            << compress_time.count() / (pages.size() * rounds) << " ns/page, decompress "
+            << decompress_time.count() / (pages.size() * rounds) << " ns/page" << std::endl;
+
+  delete table;
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+  remove("test.fsm");
+  remove("test.crc");
+}
+
+}  // namespace bustub
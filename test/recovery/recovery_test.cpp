@@ -10,7 +10,12 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <iostream>
 #include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
 #include <vector>
 
 #include "common/bustub_instance.h"
@@ -26,6 +31,42 @@
 
 namespace bustub {
 
+namespace {
+
+/**
+ * Reads the whole log and checks that it holds the records with LSNs 0 to next_lsn - 1 in order, each pointing back
+ * to the previous record of its transaction.
+ * @return the number of COMMIT records
+ */
+int CheckLog(DiskManager *disk_manager, lsn_t next_lsn) {
+  std::vector<char> log;
+  std::vector<char> chunk(LOG_BUFFER_SIZE);
+  while (disk_manager->ReadLog(chunk.data(), LOG_BUFFER_SIZE, log.size())) {
+    log.insert(log.end(), chunk.begin(), chunk.end());
+  }
+  std::unordered_map<txn_id_t, lsn_t> last_lsn;
+  int num_commits = 0;
+  size_t offset = 0;
+  for (lsn_t expected_lsn = 0; expected_lsn < next_lsn; expected_lsn++) {
+    EXPECT_LE(offset + 20, log.size());
+    if (offset + 20 > log.size()) {
+      break;
+    }
+    // size, lsn, txn id, prev lsn, type
+    int32_t header[5];
+    memcpy(header, log.data() + offset, sizeof(header));
+    auto type = static_cast<LogRecordType>(header[4]);
+    EXPECT_EQ(expected_lsn, header[1]);
+    EXPECT_EQ(type == LogRecordType::BEGIN ? INVALID_LSN : last_lsn[header[2]], header[3]);
+    last_lsn[header[2]] = header[1];
+    num_commits += type == LogRecordType::COMMIT ? 1 : 0;
+    offset += header[0];
+  }
+  return num_commits;
+}
+
+}  // namespace
+
 class RecoveryTest : public ::testing::Test {
  protected:
   // This function is called before every test.
@@ -43,7 +84,7 @@ class RecoveryTest : public ::testing::Test {
 };
 
 // NOLINTNEXTLINE
-TEST_F(RecoveryTest, DISABLED_RedoTest) {
+TEST_F(RecoveryTest, RedoTest) {
   BustubInstance *bustub_instance = new BustubInstance("test.db");
 
   ASSERT_FALSE(enable_logging);
@@ -132,7 +173,7 @@ TEST_F(RecoveryTest, DISABLED_RedoTest) {
 }
 
 // NOLINTNEXTLINE
-TEST_F(RecoveryTest, DISABLED_UndoTest) {
+TEST_F(RecoveryTest, UndoTest) {
   BustubInstance *bustub_instance = new BustubInstance("test.db");
 
   ASSERT_FALSE(enable_logging);
@@ -211,7 +252,7 @@ TEST_F(RecoveryTest, DISABLED_UndoTest) {
 }
 
 // NOLINTNEXTLINE
-TEST_F(RecoveryTest, DISABLED_CheckpointTest) {
+TEST_F(RecoveryTest, CheckpointTest) {
   BustubInstance *bustub_instance = new BustubInstance("test.db");
 
   EXPECT_FALSE(enable_logging);
@@ -313,4 +354,280 @@ TEST_F(RecoveryTest, DISABLED_CheckpointTest) {
   LOG_INFO("Shutdown System");
   delete bustub_instance;
 }
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, GroupCommitTest) {
+  auto *bustub_instance = new BustubInstance("test.db");
+  auto *transaction_manager = bustub_instance->transaction_manager_;
+  auto *log_manager = bustub_instance->log_manager_;
+  auto *disk_manager = bustub_instance->disk_manager_;
+  // neither the appends nor the commits below may depend on the timeout
+  auto old_log_timeout = log_timeout;
+  log_timeout = std::chrono::seconds(15);
+  log_manager->RunFlushThread();
+  ASSERT_TRUE(enable_logging);
+
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  Schema schema{std::vector<Column>{col1, col2}};
+  const Tuple tuple = ConstructTuple(&schema);
+
+  // Scenario: a transaction that logs more than a buffer holds keeps going while full buffers are written.
+  Transaction *txn = transaction_manager->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   log_manager, txn);
+  for (int i = 0; i < 2000; i++) {
+    RID rid;
+    ASSERT_TRUE(test_table->InsertTuple(tuple, &rid, txn));
+  }
+  EXPECT_GT(disk_manager->GetNumFlushes(), 0);
+  transaction_manager->Commit(txn);
+  EXPECT_EQ(txn->GetPrevLSN(), log_manager->GetPersistentLSN());
+  delete txn;
+
+  // Scenario: concurrent commits share writes of the log, and each returns only once its record is on disk.
+  const int num_threads = 16;
+  const int txns_per_thread = 50;
+  // every inserting thread holds on to two pages while it moves along the table
+  bustub_instance->buffer_pool_manager_->Resize(4 * num_threads);
+  int flushes_before = disk_manager->GetNumFlushes();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < txns_per_thread; j++) {
+        Transaction *txn = transaction_manager->Begin();
+        RID rid;
+        EXPECT_TRUE(test_table->InsertTuple(tuple, &rid, txn));
+        transaction_manager->Commit(txn);
+        EXPECT_GE(log_manager->GetPersistentLSN(), txn->GetPrevLSN());
+        delete txn;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  int num_flushes = disk_manager->GetNumFlushes() - flushes_before;
+  EXPECT_LT(num_flushes, num_threads * txns_per_thread);
+  EXPECT_EQ(log_manager->GetNextLSN() - 1, log_manager->GetPersistentLSN());
+  std::cout << num_threads * txns_per_thread << " commits took " << num_flushes << " log flushes" << std::endl;
+
+  // Scenario: the log file holds every record in LSN order, each chained to the previous one of its transaction.
+  EXPECT_EQ(1 + num_threads * txns_per_thread, CheckLog(disk_manager, log_manager->GetNextLSN()));
+
+  delete test_table;
+  delete bustub_instance;
+  EXPECT_FALSE(enable_logging);
+  log_timeout = old_log_timeout;
+}
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, ConcurrentAppendTest) {
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  Schema schema{std::vector<Column>{col1, col2}};
+  const Tuple tuple = ConstructTuple(&schema);
+  const int inserts_per_thread = 2000;
+  auto old_log_timeout = log_timeout;
+  log_timeout = std::chrono::seconds(15);
+
+  // Every thread inserts into a table of its own, so the log is all they share. Timings depend on the machine, so
+  // they are only reported.
+  for (int num_threads : {1, 4, 16}) {
+    remove("test.db");
+    remove("test.log");
+    auto *bustub_instance = new BustubInstance("test.db");
+    auto *transaction_manager = bustub_instance->transaction_manager_;
+    auto *log_manager = bustub_instance->log_manager_;
+    // every table stays in memory
+    bustub_instance->buffer_pool_manager_->Resize(MAX_BUFFER_POOL_SIZE);
+    log_manager->RunFlushThread();
+
+    std::vector<Transaction *> txns;
+    std::vector<TableHeap *> tables;
+    for (int i = 0; i < num_threads; i++) {
+      txns.push_back(transaction_manager->Begin());
+      tables.push_back(new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                     log_manager, txns[i]));
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; i++) {
+      threads.emplace_back([&, i] {
+        for (int j = 0; j < inserts_per_thread; j++) {
+          RID rid;
+          EXPECT_TRUE(tables[i]->InsertTuple(tuple, &rid, txns[i]));
+        }
+        transaction_manager->Commit(txns[i]);
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << num_threads << " threads: " << num_threads * inserts_per_thread / elapsed.count() / 1000
+              << " Kinserts/s" << std::endl;
+
+    EXPECT_EQ(log_manager->GetNextLSN() - 1, log_manager->GetPersistentLSN());
+    EXPECT_EQ(num_threads, CheckLog(bustub_instance->disk_manager_, log_manager->GetNextLSN()));
+    for (int i = 0; i < num_threads; i++) {
+      delete tables[i];
+      delete txns[i];
+    }
+    delete bustub_instance;
+  }
+  log_timeout = old_log_timeout;
+}
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, ParallelRedoTest) {
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  Schema schema{std::vector<Column>{col1, col2}};
+  const Tuple tuple = ConstructTuple(&schema);
+  const int num_tables = 8;
+  const int inserts_per_table = 500;
+
+  auto *bustub_instance = new BustubInstance("test.db");
+  auto *transaction_manager = bustub_instance->transaction_manager_;
+  bustub_instance->log_manager_->RunFlushThread();
+  std::vector<page_id_t> first_page_ids;
+  std::vector<std::vector<RID>> rids(num_tables);
+  for (int i = 0; i < num_tables; i++) {
+    Transaction *txn = transaction_manager->Begin();
+    TableHeap table(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                    bustub_instance->log_manager_, txn);
+    first_page_ids.push_back(table.GetFirstPageId());
+    for (int j = 0; j < inserts_per_table; j++) {
+      RID rid;
+      ASSERT_TRUE(table.InsertTuple(tuple, &rid, txn));
+      rids[i].push_back(rid);
+    }
+    transaction_manager->Commit(txn);
+    delete txn;
+  }
+  // a transaction that is still running at the crash, whose records are on disk nonetheless
+  Transaction *loser = transaction_manager->Begin();
+  RID loser_rid;
+  {
+    TableHeap table(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                    bustub_instance->log_manager_, first_page_ids[0]);
+    ASSERT_TRUE(table.InsertTuple(tuple, &loser_rid, loser));
+    bustub_instance->log_manager_->Flush(loser->GetPrevLSN());
+  }
+  delete loser;
+  // Crash: the pages that were evicted are on disk, the others only in the log.
+  delete bustub_instance;
+
+  // Recovering does not write to disk as long as the buffer pool holds every page, so each run starts from the same
+  // crashed state. Timings depend on the machine, so they are only reported.
+  for (size_t num_redo_threads : {1, 4}) {
+    bustub_instance = new BustubInstance("test.db");
+    bustub_instance->buffer_pool_manager_->Resize(MAX_BUFFER_POOL_SIZE);
+    LogRecovery log_recovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_, num_redo_threads);
+    EXPECT_EQ(num_redo_threads, log_recovery.GetNumRedoThreads());
+    // @return the number of committed tuples that can be read, -1 if the uncommitted one can be read too
+    auto count_tuples = [&] {
+      Transaction *txn = bustub_instance->transaction_manager_->Begin();
+      Tuple result;
+      int count = 0;
+      for (int i = 0; i < num_tables; i++) {
+        TableHeap table(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                        bustub_instance->log_manager_, first_page_ids[i]);
+        for (const RID &rid : rids[i]) {
+          if (table.GetTuple(rid, &result, txn) && result.GetLength() == tuple.GetLength() &&
+              memcmp(tuple.GetData(), result.GetData(), tuple.GetLength()) == 0) {
+            count++;
+          }
+        }
+        // the transaction that did not commit is rolled back
+        if (i == 0 && table.GetTuple(loser_rid, &result, txn)) {
+          count = -1;
+        }
+      }
+      bustub_instance->transaction_manager_->Commit(txn);
+      delete txn;
+      return count;
+    };
+    EXPECT_LT(count_tuples(), num_tables * inserts_per_table);
+
+    auto start = std::chrono::steady_clock::now();
+    log_recovery.Redo();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    log_recovery.Undo();
+    std::cout << num_redo_threads << " redo threads: " << elapsed.count() << " ms" << std::endl;
+    EXPECT_EQ(num_tables * inserts_per_table, count_tuples());
+
+    delete bustub_instance;
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, RecoverTwiceTest) {
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  Schema schema{std::vector<Column>{col1, col2}};
+  const Tuple tuple = ConstructTuple(&schema);
+  const Tuple tuple1 = ConstructTuple(&schema);
+
+  auto *bustub_instance = new BustubInstance("test.db");
+  bustub_instance->log_manager_->RunFlushThread();
+  Transaction *txn = bustub_instance->transaction_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  page_id_t first_page_id = test_table->GetFirstPageId();
+  RID rid;
+  ASSERT_TRUE(test_table->InsertTuple(tuple, &rid, txn));
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+  // the page on disk carries the lsn of the insert
+  ASSERT_TRUE(bustub_instance->buffer_pool_manager_->FlushPage(first_page_id));
+  delete bustub_instance;
+
+  LOG_INFO("First restart");
+  bustub_instance = new BustubInstance("test.db");
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_);
+  log_recovery->Redo();
+  log_recovery->Undo();
+  lsn_t next_lsn = log_recovery->GetNextLSN();
+  delete log_recovery;
+  bustub_instance->log_manager_->SetNextLSN(next_lsn);
+  bustub_instance->log_manager_->RunFlushThread();
+
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  RID rid1;
+  ASSERT_TRUE(test_table->InsertTuple(tuple1, &rid1, txn));
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+  // the records written after the restart follow those written before it
+  EXPECT_LT(next_lsn, bustub_instance->log_manager_->GetNextLSN());
+  EXPECT_EQ(2, CheckLog(bustub_instance->disk_manager_, bustub_instance->log_manager_->GetNextLSN()));
+  // crash without writing the page, so the second insert is only in the log
+  delete bustub_instance;
+
+  LOG_INFO("Second restart");
+  bustub_instance = new BustubInstance("test.db");
+  log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_);
+  log_recovery->Redo();
+  log_recovery->Undo();
+  delete log_recovery;
+
+  txn = bustub_instance->transaction_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  Tuple result;
+  ASSERT_TRUE(test_table->GetTuple(rid, &result, txn));
+  EXPECT_EQ(0, memcmp(tuple.GetData(), result.GetData(), tuple.GetLength()));
+  ASSERT_TRUE(test_table->GetTuple(rid1, &result, txn));
+  EXPECT_EQ(0, memcmp(tuple1.GetData(), result.GetData(), tuple1.GetLength()));
+  bustub_instance->transaction_manager_->Commit(txn);
+  delete txn;
+  delete test_table;
+  delete bustub_instance;
+}
+
 }  // namespace bustub
@@ -10,7 +10,18 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <future>  // NOLINT
+#include <iostream>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
@@ -24,12 +35,18 @@ class DiskManagerTest : public ::testing::Test {
   void SetUp() override {
     remove("test.db");
     remove("test.log");
+    remove("test.fsm");
+    remove("test.crc");
+    remove("test.map");
   }
 
   // This function is called after every test.
   void TearDown() override {
     remove("test.db");
     remove("test.log");
+    remove("test.fsm");
+    remove("test.crc");
+    remove("test.map");
   };
 };
 
@@ -55,6 +72,509 @@ TEST_F(DiskManagerTest, ReadWritePageTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ReadPagesTest) {
+  char data[4][PAGE_SIZE] = {{0}};
+  char buf[5][PAGE_SIZE];
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+  for (int i = 0; i < 4; ++i) {
+    snprintf(data[i], PAGE_SIZE, "page %d", i);
+    dm.WritePage(i, data[i]);
+  }
+
+  // Scenario: a run of consecutive pages, a gap, and a page past the end of the file that reads as zeros.
+  std::memset(buf, 'x', sizeof(buf));
+  dm.ReadPages({{0, buf[0]}, {1, buf[1]}, {3, buf[3]}, {7, buf[4]}});
+  EXPECT_EQ(std::memcmp(buf[0], data[0], PAGE_SIZE), 0);
+  EXPECT_EQ(std::memcmp(buf[1], data[1], PAGE_SIZE), 0);
+  EXPECT_EQ(std::memcmp(buf[3], data[3], PAGE_SIZE), 0);
+  EXPECT_EQ('x', buf[2][0]);
+  char zeros[PAGE_SIZE] = {0};
+  EXPECT_EQ(std::memcmp(buf[4], zeros, PAGE_SIZE), 0);
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, WritePagesTest) {
+  const int num_pages = DiskManager::MAX_WRITE_RUN + 20;
+  std::vector<std::vector<char>> data(num_pages, std::vector<char>(PAGE_SIZE));
+  std::vector<char> buf(PAGE_SIZE);
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+
+  // Scenario: unsorted pages with a gap and a run longer than one vectored write.
+  std::vector<std::pair<page_id_t, const char *>> pages;
+  for (int i = num_pages - 1; i >= 0; --i) {
+    if (i != 5) {
+      snprintf(data[i].data(), PAGE_SIZE, "batched page %d", i);
+      pages.emplace_back(i, data[i].data());
+    }
+  }
+  EXPECT_TRUE(dm.WritePages(pages));
+  EXPECT_EQ(num_pages - 1, dm.GetNumWrites());
+  for (int i = 0; i < num_pages; ++i) {
+    dm.ReadPage(i, buf.data());
+    EXPECT_EQ(data[i], buf);
+  }
+  EXPECT_TRUE(dm.WritePages({}));
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ConcurrentReadWritePageTest) {
+  const int num_threads = 4;
+  const int pages_per_thread = 32;
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+
+  // Scenario: every thread keeps rewriting and rereading its own pages, which are interleaved with the pages of the
+  // other threads. With a shared file cursor the threads would read and write each other's pages.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&, tid] {
+      char data[PAGE_SIZE];
+      char buf[PAGE_SIZE];
+      for (int round = 0; round < 20; ++round) {
+        for (int i = 0; i < pages_per_thread; ++i) {
+          page_id_t page_id = i * num_threads + tid;
+          std::memset(data, 0, sizeof(data));
+          snprintf(data, PAGE_SIZE, "page %d round %d", page_id, round);
+          dm.WritePage(page_id, data);
+          dm.ReadPage(page_id, buf);
+          EXPECT_EQ(std::memcmp(buf, data, PAGE_SIZE), 0);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * pages_per_thread * 20, dm.GetNumWrites());
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, AsyncReadWritePageTest) {
+  const int num_pages = 64;
+  const size_t queue_depth = disk_io_queue_depth;
+  // Queue more pages than fit in flight, so that submitting has to wait for completions.
+  disk_io_queue_depth = 4;
+  for (bool use_io_uring : {true, false}) {
+    enable_io_uring = use_io_uring;
+    std::vector<std::vector<char>> data(num_pages, std::vector<char>(PAGE_SIZE));
+    std::vector<std::vector<char>> buf(num_pages, std::vector<char>(PAGE_SIZE, 'x'));
+    std::string db_file("test.db");
+    auto dm = DiskManager(db_file);
+    if (!use_io_uring) {
+      EXPECT_EQ(DiskIOBackend::Type::THREAD_POOL, dm.GetAsyncBackendType());
+    }
+
+    // Scenario: write every page asynchronously, then read them back both ways.
+    std::vector<std::future<bool>> writes;
+    for (int i = 0; i < num_pages; ++i) {
+      snprintf(data[i].data(), PAGE_SIZE, "async page %d", i);
+      writes.push_back(dm.WritePageAsync(i, data[i].data()));
+    }
+    for (auto &write : writes) {
+      EXPECT_TRUE(write.get());
+    }
+    EXPECT_EQ(num_pages, dm.GetNumWrites());
+    std::vector<std::future<bool>> reads;
+    for (int i = num_pages - 1; i >= 0; --i) {
+      reads.push_back(dm.ReadPageAsync(i, buf[i].data()));
+    }
+    for (auto &read : reads) {
+      EXPECT_TRUE(read.get());
+    }
+    for (int i = 0; i < num_pages; ++i) {
+      EXPECT_EQ(data[i], buf[i]);
+    }
+    dm.ReadPage(num_pages / 2, buf[0].data());
+    EXPECT_EQ(data[num_pages / 2], buf[0]);
+
+    // Scenario: a synchronous write is visible to an asynchronous read, and a page past the end reads as zeros.
+    snprintf(data[0].data(), PAGE_SIZE, "rewritten");
+    dm.WritePage(0, data[0].data());
+    EXPECT_TRUE(dm.ReadPageAsync(0, buf[0].data()).get());
+    EXPECT_EQ(data[0], buf[0]);
+    EXPECT_TRUE(dm.ReadPageAsync(num_pages + 10, buf[1].data()).get());
+    EXPECT_EQ(std::vector<char>(PAGE_SIZE, 0), buf[1]);
+
+    // Scenario: a failed write reports back through its future and its failure callback, not its success callback.
+    int fd = open(db_file.c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+    {
+      auto backend = DiskIOBackend::Create(fd, disk_io_queue_depth, use_io_uring);
+      bool succeeded = false;
+      bool failed = false;
+      auto on_success = [&](const char * /*written*/) { return succeeded = true; };
+      EXPECT_FALSE(backend->WriteAt(0, data[0].data(), PAGE_SIZE, on_success, [&] { failed = true; }).get());
+      EXPECT_FALSE(succeeded);
+      EXPECT_TRUE(failed);
+    }
+    close(fd);
+
+    dm.ShutDown();
+    remove("test.db");
+    remove("test.log");
+  }
+  enable_io_uring = true;
+  disk_io_queue_depth = queue_depth;
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DirectIOTest) {
+  // A file that ends inside its second page, as a crash in the middle of extending it could leave it.
+  FILE *file = fopen("test.db", "wb");
+  std::vector<char> partial(PAGE_SIZE + 100, 'a');
+  fwrite(partial.data(), 1, partial.size(), file);
+  fclose(file);
+
+  enable_direct_io = true;
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+  enable_direct_io = false;
+  // Direct I/O depends on the file system, the results must not.
+  std::cout << "direct I/O: " << dm.IsDirectIO() << std::endl;
+  char *aligned = static_cast<char *>(aligned_alloc(DiskIOBackend::DIRECT_IO_ALIGNMENT, 2 * PAGE_SIZE));
+  // one byte in, so that it is never aligned
+  std::vector<char> unaligned_buf(PAGE_SIZE + 1);
+  char *unaligned = unaligned_buf.data() + 1;
+
+  // Scenario: the partial page reads as its bytes followed by zeros, through aligned and unaligned buffers.
+  std::vector<char> expected(PAGE_SIZE, 0);
+  std::memset(expected.data(), 'a', 100);
+  dm.ReadPage(1, aligned);
+  EXPECT_EQ(std::memcmp(aligned, expected.data(), PAGE_SIZE), 0);
+  std::memset(unaligned, 'x', PAGE_SIZE);
+  EXPECT_TRUE(dm.ReadPageAsync(1, unaligned).get());
+  EXPECT_EQ(std::memcmp(unaligned, expected.data(), PAGE_SIZE), 0);
+  dm.ReadPage(0, unaligned);
+  EXPECT_EQ(std::memcmp(unaligned, partial.data(), PAGE_SIZE), 0);
+
+  // Scenario: writes from unaligned buffers, one at a time, asynchronously and batched.
+  std::strncpy(unaligned, "rewritten partial page", PAGE_SIZE);
+  dm.WritePage(1, unaligned);
+  dm.ReadPage(1, aligned);
+  EXPECT_EQ(std::memcmp(aligned, unaligned, PAGE_SIZE), 0);
+  std::strncpy(unaligned, "async page", PAGE_SIZE);
+  EXPECT_TRUE(dm.WritePageAsync(2, unaligned).get());
+  EXPECT_TRUE(dm.ReadPageAsync(2, aligned + PAGE_SIZE).get());
+  EXPECT_EQ(std::memcmp(aligned + PAGE_SIZE, unaligned, PAGE_SIZE), 0);
+  std::strncpy(aligned, "batched aligned page", PAGE_SIZE);
+  EXPECT_TRUE(dm.WritePages({{4, unaligned}, {3, aligned}}));
+  std::vector<char> buf(PAGE_SIZE);
+  dm.ReadPage(3, buf.data());
+  EXPECT_EQ(std::memcmp(buf.data(), aligned, PAGE_SIZE), 0);
+  dm.ReadPage(4, buf.data());
+  EXPECT_EQ(std::memcmp(buf.data(), unaligned, PAGE_SIZE), 0);
+
+  free(aligned);
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, AllocatePageTest) {
+  std::string db_file("test.db");
+  auto *dm = new DiskManager(db_file);
+  for (page_id_t page_id = 0; page_id < 10; ++page_id) {
+    EXPECT_EQ(page_id, dm->AllocatePage());
+  }
+
+  // Scenario: deallocated pages are reused lowest first before the file grows.
+  dm->DeallocatePage(7);
+  dm->DeallocatePage(3);
+  dm->DeallocatePage(3);
+  dm->DeallocatePage(42);
+  EXPECT_FALSE(dm->IsAllocated(3));
+  EXPECT_EQ(3, dm->AllocatePage());
+  EXPECT_EQ(7, dm->AllocatePage());
+  EXPECT_EQ(10, dm->AllocatePage());
+
+  // Scenario: a strided allocation skips the pages of other residue classes and leaves them free.
+  dm->DeallocatePage(5);
+  EXPECT_EQ(5, dm->AllocatePage(4, 1));
+  EXPECT_EQ(13, dm->AllocatePage(4, 1));
+  EXPECT_EQ(14, dm->AllocatePage(4, 2));
+  EXPECT_EQ(11, dm->AllocatePage());
+
+  // Scenario: the allocated pages survive a restart.
+  dm->ShutDown();
+  delete dm;
+  dm = new DiskManager(db_file);
+  EXPECT_TRUE(dm->IsAllocated(13));
+  EXPECT_FALSE(dm->IsAllocated(12));
+  EXPECT_EQ(12, dm->AllocatePage());
+  EXPECT_EQ(15, dm->AllocatePage());
+  dm->ShutDown();
+  delete dm;
+
+  // Scenario: the map of a removed db file does not carry over to a new one.
+  remove("test.db");
+  dm = new DiskManager(db_file);
+  EXPECT_EQ(0, dm->AllocatePage());
+  dm->ShutDown();
+  delete dm;
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ChecksumTest) {
+  char data[PAGE_SIZE] = {0};
+  char buf[PAGE_SIZE];
+  std::string db_file("test.db");
+  auto *dm = new DiskManager(db_file);
+  for (page_id_t page_id = 0; page_id < 3; ++page_id) {
+    snprintf(data, PAGE_SIZE, "checksummed page %d", page_id);
+    dm->WritePage(page_id, data);
+  }
+  // Flips a byte of a page behind the disk manager's back, like bit rot or the lost half of a torn write.
+  auto corrupt = [](page_id_t page_id) {
+    FILE *file = fopen("test.db", "r+b");
+    fseek(file, page_id * PAGE_SIZE + 100, SEEK_SET);
+    fputc('!', file);
+    fclose(file);
+  };
+
+  // Scenario: a corrupted page is reported by both read paths and still returned as read.
+  corrupt(1);
+  EXPECT_TRUE(dm->ReadPage(0, buf));
+  EXPECT_EQ(0U, dm->GetNumChecksumFailures());
+  EXPECT_FALSE(dm->ReadPage(1, buf));
+  EXPECT_EQ(1U, dm->GetNumChecksumFailures());
+  EXPECT_EQ('!', buf[100]);
+  EXPECT_FALSE(dm->ReadPageAsync(1, buf).get());
+  EXPECT_EQ(2U, dm->GetNumChecksumFailures());
+
+  // Scenario: WRITE_ONLY does not verify, and rewriting the page makes it valid again.
+  page_checksum_mode = PageChecksumMode::WRITE_ONLY;
+  dm->ReadPage(1, buf);
+  EXPECT_EQ(2U, dm->GetNumChecksumFailures());
+  dm->WritePage(1, data);
+  page_checksum_mode = PageChecksumMode::VERIFY;
+  EXPECT_TRUE(dm->ReadPage(1, buf));
+  EXPECT_TRUE(dm->ReadPageAsync(1, buf).get());
+  EXPECT_EQ(2U, dm->GetNumChecksumFailures());
+
+  // Scenario: a page written with checksums off has none, so it cannot fail.
+  page_checksum_mode = PageChecksumMode::OFF;
+  dm->WritePage(2, data);
+  page_checksum_mode = PageChecksumMode::VERIFY;
+  corrupt(2);
+  dm->ReadPage(2, buf);
+  EXPECT_EQ(2U, dm->GetNumChecksumFailures());
+
+  // Scenario: the checksums survive a restart.
+  dm->ShutDown();
+  delete dm;
+  dm = new DiskManager(db_file);
+  corrupt(0);
+  dm->ReadPage(0, buf);
+  EXPECT_EQ(1U, dm->GetNumChecksumFailures());
+  dm->ShutDown();
+  delete dm;
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, CompressionTest) {
+  const page_id_t num_pages = 64;
+  char buf[PAGE_SIZE];
+  std::string db_file("test.db");
+  enable_page_compression = true;
+  auto *dm = new DiskManager(db_file);
+  ASSERT_TRUE(dm->IsCompressed());
+  EXPECT_FALSE(dm->IsDirectIO());
+
+  // Half-full pages of similar tuples compress well, pages of random bytes do not compress at all.
+  std::mt19937 rng(15445);
+  std::vector<std::vector<char>> pages(num_pages, std::vector<char>(PAGE_SIZE, 0));
+  for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+    char *data = pages[page_id].data();
+    if (page_id % 8 == 7) {
+      for (int i = 0; i < PAGE_SIZE; ++i) {
+        data[i] = static_cast<char>(rng());
+      }
+    } else {
+      for (int i = 0; i < PAGE_SIZE / 2; i += 32) {
+        snprintf(data + i, PAGE_SIZE - i, "page %d tuple %d", page_id, static_cast<int>(rng() % 1000));
+      }
+    }
+    EXPECT_EQ(page_id, dm->AllocatePage());
+  }
+  auto expect_pages = [&](DiskManager *dm) {
+    for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+      if (dm->IsAllocated(page_id)) {
+        dm->ReadPage(page_id, buf);
+        EXPECT_EQ(0, memcmp(buf, pages[page_id].data(), PAGE_SIZE)) << "page " << page_id;
+        memset(buf, 1, PAGE_SIZE);
+        EXPECT_TRUE(dm->ReadPageAsync(page_id, buf).get());
+        EXPECT_EQ(0, memcmp(buf, pages[page_id].data(), PAGE_SIZE)) << "page " << page_id;
+      }
+    }
+    EXPECT_EQ(0U, dm->GetNumChecksumFailures());
+  };
+  auto file_size = [] {
+    struct stat stat_buf;
+    return stat("test.db", &stat_buf) == 0 ? stat_buf.st_size : -1;
+  };
+  // the last sector of the file may be partly written
+  auto file_sectors = [&] {
+    return (file_size() + CompressedPageTable::SECTOR_SIZE - 1) / CompressedPageTable::SECTOR_SIZE;
+  };
+
+  // Scenario: pages written by every write path read back the same, in a fraction of the space.
+  std::vector<std::pair<page_id_t, const char *>> batch;
+  std::vector<std::future<bool>> writes;
+  for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+    if (page_id % 3 == 0) {
+      dm->WritePage(page_id, pages[page_id].data());
+    } else if (page_id % 3 == 1) {
+      writes.push_back(dm->WritePageAsync(page_id, pages[page_id].data()));
+    } else {
+      batch.emplace_back(page_id, pages[page_id].data());
+    }
+  }
+  EXPECT_TRUE(dm->WritePages(batch));
+  for (auto &write : writes) {
+    EXPECT_TRUE(write.get());
+  }
+  expect_pages(dm);
+  EXPECT_EQ(static_cast<size_t>(num_pages), dm->GetCompressedPageTable()->GetNumStoredPages());
+  EXPECT_LT(file_size(), num_pages * PAGE_SIZE / 3);
+  // a page that has never been written reads as zeros
+  memset(buf, 1, PAGE_SIZE);
+  dm->ReadPage(num_pages, buf);
+  EXPECT_EQ(std::vector<char>(PAGE_SIZE, 0), std::vector<char>(buf, buf + PAGE_SIZE));
+
+  // Scenario: once the table is synced, the sectors of deallocated and rewritten pages are reused before the file
+  // grows.
+  int64_t sectors = file_sectors();
+  for (page_id_t page_id = 0; page_id < num_pages; page_id += 2) {
+    dm->DeallocatePage(page_id);
+  }
+  EXPECT_TRUE(dm->WritePages({}));
+  for (page_id_t page_id = 1; page_id < num_pages; page_id += 2) {
+    std::swap(pages[page_id], pages[page_id - 1]);
+    dm->WritePage(page_id, pages[page_id].data());
+  }
+  expect_pages(dm);
+  EXPECT_EQ(sectors, file_sectors());
+
+  // Scenario: the layout survives a restart, whatever enable_page_compression says by then.
+  dm->ShutDown();
+  delete dm;
+  enable_page_compression = false;
+  dm = new DiskManager(db_file);
+  ASSERT_TRUE(dm->IsCompressed());
+  expect_pages(dm);
+
+  // Scenario: a corrupted compressed page is detected.
+  CompressedPageTable::Extent extent = dm->GetCompressedPageTable()->Lookup(1);
+  ASSERT_LT(extent.length_, static_cast<uint32_t>(PAGE_SIZE));
+  FILE *file = fopen("test.db", "r+b");
+  fseek(file, extent.Offset() + extent.length_ / 2, SEEK_SET);
+  int byte = fgetc(file);
+  fseek(file, extent.Offset() + extent.length_ / 2, SEEK_SET);
+  fputc(byte ^ 0x5A, file);
+  fclose(file);
+  dm->ReadPage(1, buf);
+  EXPECT_EQ(1U, dm->GetNumChecksumFailures());
+  EXPECT_FALSE(dm->ReadPageAsync(1, buf).get());
+
+  // Scenario: the extents of neighbouring pages merge when they are freed, so pages that do not compress fit where
+  // compressed ones were.
+  sectors = file_sectors();
+  for (page_id_t page_id = 0; page_id < num_pages; ++page_id) {
+    dm->DeallocatePage(page_id);
+  }
+  EXPECT_TRUE(dm->WritePages({}));
+  std::vector<char> noise(PAGE_SIZE);
+  for (char &byte : noise) {
+    byte = static_cast<char>(rng());
+  }
+  for (int i = 0; i < 12; ++i) {
+    dm->WritePage(dm->AllocatePage(), noise.data());
+  }
+  EXPECT_EQ(sectors, file_sectors());
+  dm->ShutDown();
+  delete dm;
+
+  // Scenario: a db file written uncompressed stays uncompressed.
+  remove("test.db");
+  dm = new DiskManager(db_file);
+  dm->WritePage(0, pages[0].data());
+  dm->ShutDown();
+  delete dm;
+  enable_page_compression = true;
+  dm = new DiskManager(db_file);
+  enable_page_compression = false;
+  EXPECT_FALSE(dm->IsCompressed());
+  dm->ReadPage(0, buf);
+  EXPECT_EQ(0, memcmp(buf, pages[0].data(), PAGE_SIZE));
+  dm->ShutDown();
+  delete dm;
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ReadOnlyTest) {
+  char data[PAGE_SIZE] = {0};
+  char buf[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  EXPECT_THROW(DiskManager(db_file, DiskManager::OpenMode::READ_ONLY), Exception);
+
+  auto *dm = new DiskManager(db_file);
+  for (page_id_t page_id = 0; page_id < 4; ++page_id) {
+    EXPECT_EQ(page_id, dm->AllocatePage());
+    snprintf(data, PAGE_SIZE, "page %d", page_id);
+    dm->WritePage(page_id, data);
+  }
+  // an allocated page that has not been written yet lies past the end of the file
+  EXPECT_EQ(4, dm->AllocatePage());
+  dm->ShutDown();
+  delete dm;
+
+  dm = new DiskManager(db_file, DiskManager::OpenMode::READ_ONLY);
+  EXPECT_TRUE(dm->IsReadOnly());
+  EXPECT_FALSE(dm->IsCompressed());
+  EXPECT_EQ("page 2", std::string(dm->GetMappedPage(2)));
+  EXPECT_EQ(std::string(PAGE_SIZE, '\0'), std::string(dm->GetMappedPage(4), PAGE_SIZE));
+  EXPECT_TRUE(dm->IsAllocated(4));
+  EXPECT_FALSE(dm->IsAllocated(5));
+  // the other read paths still work and still verify checksums
+  dm->ReadPage(1, buf);
+  EXPECT_EQ("page 1", std::string(buf));
+  EXPECT_TRUE(dm->ReadPageAsync(3, buf).get());
+  EXPECT_EQ("page 3", std::string(buf));
+  EXPECT_EQ(0U, dm->GetNumChecksumFailures());
+
+  // Scenario: nothing can be written or allocated.
+  snprintf(data, PAGE_SIZE, "overwritten");
+  dm->WritePage(0, data);
+  EXPECT_FALSE(dm->WritePageAsync(0, data).get());
+  EXPECT_FALSE(dm->WritePages({{0, data}}));
+  EXPECT_EQ(INVALID_PAGE_ID, dm->AllocatePage());
+  dm->DeallocatePage(0);
+  EXPECT_TRUE(dm->IsAllocated(0));
+  EXPECT_EQ(0, dm->GetNumWrites());
+  EXPECT_EQ("page 0", std::string(dm->GetMappedPage(0)));
+  EXPECT_FALSE(dm->ReadLog(buf, 16, 0));
+  dm->ShutDown();
+  delete dm;
+
+  // Scenario: a compressed db file cannot be mapped.
+  remove("test.db");
+  enable_page_compression = true;
+  dm = new DiskManager(db_file);
+  enable_page_compression = false;
+  dm->WritePage(0, data);
+  dm->ShutDown();
+  delete dm;
+  EXPECT_THROW(DiskManager(db_file, DiskManager::OpenMode::READ_ONLY), Exception);
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ReadWriteLogTest) {
   char buf[16] = {0};
@@ -0,0 +1,124 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard_test.cpp
+//
+// Identification: test/storage/page_guard_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/page/page_guard.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, SampleTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 5;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  page_id_t page_id;
+  Page *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  // a new page starts out dirty
+  ASSERT_TRUE(page->IsDirty());
+  ASSERT_TRUE(bpm->FlushPage(page_id));
+
+  // Scenario: a basic guard keeps the page pinned until it goes out of scope.
+  {
+    auto guard = bpm->FetchPageBasic(page_id);
+    EXPECT_TRUE(guard);
+    EXPECT_EQ(page_id, guard.PageId());
+    EXPECT_EQ(1, page->GetPinCount());
+    EXPECT_FALSE(page->IsDirty());
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+  EXPECT_FALSE(page->IsDirty());
+
+  // Scenario: moving a guard transfers the pin, the moved-from guard is empty and dropping it does nothing.
+  {
+    auto guard = bpm->FetchPageBasic(page_id);
+    BasicPageGuard other(std::move(guard));
+    EXPECT_FALSE(guard);  // NOLINT
+    EXPECT_EQ(1, page->GetPinCount());
+    guard.Drop();  // NOLINT
+    EXPECT_EQ(1, page->GetPinCount());
+    other.Drop();
+    EXPECT_EQ(0, page->GetPinCount());
+    other.Drop();
+    EXPECT_EQ(0, page->GetPinCount());
+  }
+
+  // Scenario: writing through a write guard marks the page dirty, and the write latch is released afterwards.
+  {
+    auto guard = bpm->FetchPageWrite(page_id);
+    snprintf(guard.GetDataMut(), PAGE_SIZE, "Hello");
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+  EXPECT_TRUE(page->IsDirty());
+  EXPECT_EQ(0, strcmp(page->GetData(), "Hello"));
+
+  // Scenario: several read guards can share a page, and assigning to a guard releases the page it held.
+  {
+    auto guard1 = bpm->FetchPageRead(page_id);
+    auto guard2 = bpm->FetchPageRead(page_id);
+    EXPECT_EQ(2, page->GetPinCount());
+    EXPECT_EQ(0, strcmp(guard1.GetData(), "Hello"));
+    guard1 = std::move(guard2);
+    EXPECT_EQ(1, page->GetPinCount());
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+  page->WLatch();
+  page->WUnlatch();
+
+  // Scenario: upgrading a basic guard latches the page and keeps the single pin.
+  {
+    auto write_guard = bpm->FetchPageBasic(page_id).UpgradeWrite();
+    EXPECT_TRUE(write_guard);
+    EXPECT_EQ(1, page->GetPinCount());
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+
+  // Scenario: a new page comes back pinned and is dirty even if it is not modified through the guard.
+  page_id_t new_page_id;
+  {
+    auto guard = bpm->NewPageGuarded(&new_page_id);
+    EXPECT_TRUE(guard);
+    EXPECT_EQ(new_page_id, guard.PageId());
+  }
+  {
+    auto guard = bpm->FetchPageBasic(new_page_id);
+    EXPECT_TRUE(guard.GetPage()->IsDirty());
+  }
+
+  // Scenario: failed fetches return empty guards.
+  std::vector<BasicPageGuard> guards;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t temp_page_id;
+    guards.push_back(bpm->NewPageGuarded(&temp_page_id));
+  }
+  EXPECT_FALSE(bpm->FetchPageRead(page_id));
+  EXPECT_FALSE(bpm->FetchPageWrite(page_id));
+  guards.clear();
+  EXPECT_TRUE(bpm->FetchPageRead(page_id));
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+}  // namespace bustub